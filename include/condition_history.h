@@ -0,0 +1,81 @@
+/*
+ * Condition History
+ * Copyright (c) 2025 William Bellvance Jr
+ * Licensed under the MIT License.
+ *
+ * Reads the daily conditions logs and aggregates them into fixed-width time buckets
+ */
+
+#ifndef CONDITION_HISTORY_H
+#define CONDITION_HISTORY_H
+
+#include <string>
+#include <vector>
+#include <ctime>
+#include <cstdint>
+
+enum class HistoryField {
+    Setpoint = 0,
+    Return,
+    Supply,
+    Coil,
+    Compressor,     // Relays aggregate to the fraction of samples they were on
+    Fan,
+    Valve,
+    ElectricHeater,
+    Count
+};
+
+// Per-bucket aggregates, one column per requested field
+struct HistoryResult {
+    std::time_t from = 0;
+    std::time_t to = 0;
+    int step = 0;
+    std::vector<HistoryField> fields;
+    std::vector<uint32_t> samples;              // [bucket] log lines that fell in the bucket
+    std::vector<std::vector<uint32_t>> count;   // [field][bucket] samples with a value for the field
+    std::vector<std::vector<float>> min;        // [field][bucket]
+    std::vector<std::vector<float>> max;
+    std::vector<std::vector<float>> avg;
+    size_t buckets() const { return samples.size(); }
+};
+
+class ConditionHistory {
+public:
+    /**
+     * @param log_folder Folder holding conditions-YYYY-MM-DD.log files
+     */
+    ConditionHistory(const std::string& log_folder = "/var/log/refrigeration");
+
+    /**
+     * Aggregate logged samples in [from, to) into buckets of step seconds.
+     * Reads every day file the range touches, so queries can span midnight.
+     * @return Aggregates; buckets with no samples have a count of 0
+     */
+    HistoryResult query(std::time_t from, std::time_t to, int step, const std::vector<HistoryField>& fields) const;
+
+    /**
+     * Parse one conditions log line
+     * @param values Filled with one value per HistoryField, NaN where the line has none
+     * @return false if the line isn't a conditions entry
+     */
+    static bool parse_line(const std::string& line, std::time_t& timestamp, float values[]);
+
+    /**
+     * Field name used by the API ("return", "compressor", ...)
+     */
+    static const char* field_name(HistoryField field);
+
+    /**
+     * Look up a field by its API name
+     */
+    static bool parse_field(const std::string& name, HistoryField& field);
+
+    // Upper bound on buckets per query, which bounds the response size
+    static constexpr size_t max_buckets = 2000;
+
+private:
+    std::string log_folder_;
+};
+
+#endif // CONDITION_HISTORY_H
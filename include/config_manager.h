@@ -3,9 +3,13 @@
 
 #include <string>
 #include <map>
+#include <memory>
+#include <mutex>
 #include <nlohmann/json.hpp>
 #include "config_validator.h"
 
+using ConfigSnapshot = std::shared_ptr<const std::map<std::string, std::string>>;
+
 class ConfigManager {
 public:
     ConfigManager(const std::string& filepath);
@@ -16,6 +20,16 @@ public:
     bool update(const std::string& key, const std::string& value);
     bool resetToDefaults();
 
+    // Validate a batch of changes and persist them with a single file write.
+    // Nothing is applied if any key is unknown or any value is invalid.
+    bool transaction(const std::map<std::string, std::string>& changes);
+
+    // Check a value against the schema without changing anything
+    bool isValid(const std::string& key, const std::string& value) const;
+
+    // Immutable copy of all values; readers never block writers and see updates as soon as they are made
+    ConfigSnapshot snapshot() const;
+
     const std::map<std::string, ConfigEntry>& getSchema() const {
         return validator_.getSchema();
     }
@@ -24,11 +38,16 @@ private:
     std::string filepath_;
     std::map<std::string, std::string> configValues_;
     ConfigValidator validator_;
+    ConfigSnapshot snapshot_;
+    std::mutex write_mutex_;
 
     void loadFromDotEnv();
+    void publishSnapshot();
     void initializeWithDefaults();
     bool set(const std::string& key, const std::string& value);
-    void saveToDotEnv() const;
+    int lockForWrite() const;
+    void unlockForWrite(int lock_fd) const;
+    bool saveToDotEnv() const;
     bool save();
 };
 
@@ -0,0 +1,136 @@
+/*
+ * Flight Recorder
+ * Copyright (c) 2025 William Bellvance Jr
+ * Licensed under the MIT License.
+ *
+ * One fixed-size record per control cycle in a memory-mapped ring file, kept for post-mortem analysis
+ */
+
+#ifndef FLIGHT_RECORDER_H
+#define FLIGHT_RECORDER_H
+
+#include "state_publisher.h"
+#include <string>
+#include <vector>
+#include <atomic>
+#include <ctime>
+#include <cstdint>
+
+enum class FlightMode : uint8_t {
+    Null = 0,
+    Cooling,
+    Heating,
+    Defrost,
+    Alarm,
+    Unknown
+};
+
+// FlightRecord::relays bits
+enum FlightRelay : uint8_t {
+    FlightCompressor = 1 << 0,
+    FlightFan = 1 << 1,
+    FlightValve = 1 << 2,
+    FlightElectricHeater = 1 << 3
+};
+
+// FlightRecord::flags bits
+enum FlightFlag : uint8_t {
+    FlightAntiCycle = 1 << 0,
+    FlightWarning = 1 << 1,
+    FlightShutdown = 1 << 2,
+    FlightDemo = 1 << 3
+};
+
+// 32 bytes, so a record never straddles a page
+struct FlightRecord {
+    uint32_t sequence;      // 1-based write counter, 0 = slot never written
+    uint32_t timestamp;
+    int16_t return_temp;    // Hundredths of a degree
+    int16_t supply_temp;
+    int16_t coil_temp;
+    int16_t setpoint;
+    uint8_t mode;           // FlightMode
+    uint8_t relays;         // FlightRelay bits
+    uint8_t flags;          // FlightFlag bits
+    uint8_t pretrip_stage;
+    uint32_t alarms;        // One bit per FlightRecorder::alarm_codes entry, top bit for any other code
+    uint32_t cycle_us;      // Control cycle duration
+    uint32_t check;         // Checksum of the fields above; torn or stale slots fail it
+};
+
+class FlightRecorder {
+public:
+    /**
+     * Open (or create) the ring file
+     * @param path Location of the ring file
+     * @param capacity Records kept; at one per second 86400 is a day. 0 disables the recorder.
+     */
+    FlightRecorder(const std::string& path = "/var/lib/refrigeration/flight.rec", size_t capacity = 172800);
+
+    /**
+     * Unmap the file; the kernel writes back anything still dirty
+     */
+    ~FlightRecorder();
+
+    /**
+     * Append one control cycle. Only ever called from the control thread: it fills a record
+     * and copies it into the mapping, with no locks, syscalls or allocation.
+     */
+    void record(const StateSnapshot& state, bool anti_cycle, int pretrip_stage, uint32_t cycle_us);
+
+    /**
+     * Records with from <= timestamp < to, oldest first. Safe to call while recording;
+     * a slot being overwritten fails its checksum and is skipped.
+     */
+    std::vector<FlightRecord> read(std::time_t from, std::time_t to) const;
+
+    /**
+     * When an alarm code most recently went from inactive to active, 0 if not in the recording
+     */
+    std::time_t find_alarm_onset(int code) const;
+
+    /**
+     * Time span currently held in the ring
+     * @return false if the ring is empty
+     */
+    bool span(std::time_t& oldest, std::time_t& newest) const;
+
+    /**
+     * Whether records are backed by the file (false if disabled or it could not be mapped)
+     */
+    bool is_recording() const { return records_ != nullptr; }
+
+    size_t capacity() const { return capacity_; }
+
+    static const char* mode_name(uint8_t mode);
+    static std::vector<int> decode_alarms(uint32_t bitmap);
+    static uint32_t alarm_bit(int code);
+
+    // Alarm codes with a bit of their own in FlightRecord::alarms
+    static constexpr int alarm_codes[] = {1001, 1002, 1004, 2000, 2001, 2002, 9000, 9001, 9002, 9003};
+
+private:
+    struct Header {
+        uint32_t magic;
+        uint32_t layout_version;
+        uint32_t record_size;
+        uint32_t reserved;
+        uint64_t capacity;
+    };
+
+    std::string path_;
+    size_t capacity_;
+    int fd_;
+    void* mapping_;
+    size_t mapping_size_;
+    FlightRecord* records_;
+    std::atomic<size_t> head_;  // Slot the next record goes to, which holds the oldest record once the ring is full
+    uint32_t sequence_;     // Sequence of the next record
+
+    bool open_file();
+    bool slot_valid(const FlightRecord& record) const;
+    size_t oldest_slot() const;
+    static uint32_t checksum(const FlightRecord& record);
+};
+
+#endif // FLIGHT_RECORDER_H
@@ -0,0 +1,63 @@
+/*
+ * Gzip Utilities
+ * Copyright (c) 2025 William Bellvance Jr
+ * Licensed under the MIT License.
+ *
+ * zlib helpers for gzip Content-Encoding and pre-compressed log files
+ */
+
+#ifndef GZIP_UTIL_H
+#define GZIP_UTIL_H
+
+#include <string>
+#include <functional>
+#include <zlib.h>
+
+// Incremental gzip encoder; feed chunks in and write out whatever it returns
+class GzipStream {
+public:
+    GzipStream(int level = Z_DEFAULT_COMPRESSION);
+    ~GzipStream();
+
+    GzipStream(const GzipStream&) = delete;
+    GzipStream& operator=(const GzipStream&) = delete;
+
+    /**
+     * Compress a chunk
+     * @return Compressed bytes ready to send (may be empty while zlib buffers input)
+     */
+    std::string write(const char* data, size_t length);
+
+    /**
+     * Flush the remaining data and the gzip trailer
+     */
+    std::string finish();
+
+    // False once zlib failed; the output so far is then truncated or empty
+    bool ok() const { return ok_; }
+
+private:
+    z_stream stream_;
+    bool initialized_;
+    bool ok_;
+
+    std::string run(const char* data, size_t length, int flush);
+};
+
+/**
+ * Compress a whole buffer to gzip format
+ */
+std::string gzip_compress(const std::string& data, int level = Z_DEFAULT_COMPRESSION);
+
+/**
+ * Gzip a file to destination (written to a temp file and renamed into place)
+ * @return true on success
+ */
+bool gzip_file(const std::string& source, const std::string& destination);
+
+/**
+ * Whether an HTTP request advertises gzip in Accept-Encoding
+ */
+bool accepts_gzip(const std::string& accept_encoding);
+
+#endif // GZIP_UTIL_H
@@ -10,6 +10,7 @@
 #include <sstream>
 #include <iomanip>
 #include <chrono>
+#include <cstdint>
 #include <fcntl.h>
 #include <unistd.h>
 #include <sys/file.h>
@@ -19,7 +20,13 @@ public:
     Logger(int debug);
     ~Logger();
 
-    void clear_old_logs(int days = 30);
+    // Compress closed days, prune by age and total size, and remove stale lock files.
+    // Safe to call while logging; today's files are never touched.
+    void maintain_logs(int retention_days = 30, uint64_t max_total_bytes = 0);
+
+    // Write <path>.gz for a closed day unless an up-to-date one exists, holding the file's .lock
+    // like maintain_logs() does. False if compression failed or the file is locked right now.
+    bool compress_log(const std::string& path, bool remove_original = false);
     void log_conditions(float setpoint, float return_sensor, float coil_sensor,
                        float supply_sensor, const std::map<std::string, std::string>& systems_status);
     void log_events(const std::string& event_type, const std::string& event_message);
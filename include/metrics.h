@@ -0,0 +1,93 @@
+/*
+ * Metrics
+ * Copyright (c) 2025 William Bellvance Jr
+ * Licensed under the MIT License.
+ *
+ * Low-overhead counters and latency histograms exported in Prometheus text format
+ */
+
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <string>
+#include <chrono>
+#include <cstdint>
+
+enum class MetricCounter {
+    RateLimitRejections = 0,
+    AdmissionRejections,    // Connections turned away before getting a worker
+    Count
+};
+
+enum class MetricHistogram {
+    ControlCycle = 0,   // Work done in one update_sensor_thread iteration
+    ControlJitter,      // How late the control loop woke up after its sleep
+    SensorRead,         // 1-Wire read, labelled by sensor
+    LcdFrame,           // All display writes for one frame
+    I2cWrite,           // One SMBus write
+    LogToFile,          // Logger::log_to_file including the file lock
+    TlsHandshake,       // SSL_accept
+    ApiRequest,         // Request handling, labelled by endpoint
+    Count
+};
+
+// Label values for MetricHistogram::SensorRead
+enum SensorLabel {
+    SensorReturn = 0,
+    SensorSupply,
+    SensorCoil
+};
+
+class Metrics {
+public:
+    /**
+     * Add to a counter. Lock-free: each thread writes its own shard.
+     */
+    static void increment(MetricCounter counter, uint64_t amount = 1);
+
+    /**
+     * Record one latency sample
+     * @param histogram Histogram to record into
+     * @param nanoseconds Duration of the operation
+     * @param label Label index for labelled histograms (sensor, endpoint), 0 otherwise
+     */
+    static void observe(MetricHistogram histogram, uint64_t nanoseconds, int label = 0);
+
+    /**
+     * Map a request path to its ApiRequest label index
+     */
+    static int endpoint_label(const std::string& path);
+
+    /**
+     * Render all metrics in the Prometheus text exposition format
+     */
+    static std::string render_prometheus();
+
+    // Maximum label values per histogram
+    static constexpr int max_labels = 24;
+};
+
+// Records the lifetime of the enclosing scope into a histogram
+class MetricTimer {
+public:
+    MetricTimer(MetricHistogram histogram, int label = 0)
+        : histogram_(histogram), label_(label), active_(true), start_(std::chrono::steady_clock::now()) {}
+
+    ~MetricTimer() {
+        if (active_) {
+            Metrics::observe(histogram_, std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - start_).count(), label_);
+        }
+    }
+
+    // Don't record this scope (e.g. long-lived streams)
+    void cancel() { active_ = false; }
+
+private:
+    MetricHistogram histogram_;
+    int label_;
+    bool active_;
+    std::chrono::steady_clock::time_point start_;
+};
+
+#endif // METRICS_H
@@ -3,7 +3,8 @@
  * Copyright (c) 2025 William Bellvance Jr
  * Licensed under the MIT License.
  *
- * Implements token bucket algorithm for rate limiting per IP address and API key
+ * Implements GCRA (virtual token bucket) rate limiting per IP address and API key
+ * with bounded, lock-striped client tables
  */
 
 #ifndef RATE_LIMITER_H
@@ -11,9 +12,12 @@
 
 #include <string>
 #include <unordered_map>
+#include <list>
+#include <vector>
 #include <mutex>
+#include <atomic>
 #include <chrono>
-#include <ctime>
+#include <cstdint>
 
 class RateLimiter {
 public:
@@ -22,10 +26,13 @@ public:
      * @param global_requests_per_minute Maximum requests per minute across all clients
      * @param per_ip_requests_per_minute Maximum requests per minute per IP address
      * @param per_key_requests_per_minute Maximum requests per minute per API key
+     * @param max_tracked_clients Maximum IPs/keys tracked at once; the least recently used entry is
+     *        reused once it is idle, otherwise new clients share an overflow entry
      */
     RateLimiter(int global_requests_per_minute = 1000,
                 int per_ip_requests_per_minute = 100,
-                int per_key_requests_per_minute = 200);
+                int per_key_requests_per_minute = 200,
+                size_t max_tracked_clients = 4096);
 
     /**
      * Check if a request is allowed based on IP and/or API key
@@ -38,14 +45,14 @@ public:
     /**
      * Get remaining requests for an IP address
      * @param ip_address Client IP address
-     * @return Number of remaining requests this minute
+     * @return Number of requests that would be allowed right now
      */
     int get_remaining_requests(const std::string& ip_address);
 
     /**
-     * Get time until rate limit resets for an IP address
+     * Get time until the next request from an IP address would be allowed
      * @param ip_address Client IP address
-     * @return Seconds until limit resets
+     * @return Seconds until the next request is allowed (0 if allowed now)
      */
     int get_reset_time(const std::string& ip_address);
 
@@ -61,23 +68,50 @@ public:
     std::string get_statistics();
 
 private:
-    struct TokenBucket {
-        int tokens;
-        std::time_t last_refill;
+    using Clock = std::chrono::steady_clock;
+
+    // GCRA parameters for one limit, in steady_clock nanoseconds
+    struct Limit {
+        int64_t emission_interval;  // Time one request "costs"
+        int64_t burst_tolerance;    // How far ahead of now the theoretical arrival time may run
+        int requests_per_minute;
+    };
+
+    // One tracked client; tat is the theoretical arrival time of its next request
+    struct Entry {
+        uint64_t hash;
+        int64_t tat;
+    };
+
+    // A slice of the client table with its own lock, kept in LRU order (front = most recent)
+    struct Stripe {
+        std::mutex mutex;
+        std::list<Entry> lru;
+        std::unordered_map<uint64_t, std::list<Entry>::iterator> index;
+        size_t capacity = 0;
+        int64_t overflow_tat = 0;   // Shared by new clients while the table is full of active ones
     };
 
-    std::unordered_map<std::string, TokenBucket> global_buckets_;
-    std::unordered_map<std::string, TokenBucket> ip_buckets_;
-    std::unordered_map<std::string, TokenBucket> key_buckets_;
+    static constexpr size_t stripe_count = 16;
+    static constexpr int eviction_probes = 4;   // LRU entries checked for an idle one before overflowing
 
-    int global_requests_per_minute_;
-    int per_ip_requests_per_minute_;
-    int per_key_requests_per_minute_;
+    Limit global_limit_;
+    Limit ip_limit_;
+    Limit key_limit_;
 
-    mutable std::mutex mutex_;
+    std::atomic<int64_t> global_tat_;
+    std::vector<Stripe> ip_stripes_;
+    std::vector<Stripe> key_stripes_;
+    std::atomic<uint64_t> evictions_;
+    std::atomic<uint64_t> overflows_;
+    std::atomic<uint64_t> rejections_;
 
-    void refill_bucket(TokenBucket& bucket, int capacity);
-    std::string extract_ip_from_request(const std::string& request_line);
+    static Limit make_limit(int requests_per_minute);
+    static int64_t now_ns();
+    static uint64_t hash_client(const std::string& client);
+    Stripe& stripe_for(std::vector<Stripe>& stripes, uint64_t hash);
+    int64_t& find_or_insert(Stripe& stripe, uint64_t hash, int64_t now);
+    bool try_consume_global(int64_t now);
 };
 
 #endif // RATE_LIMITER_H
@@ -7,6 +7,7 @@
 #include <atomic>
 #include <ctime>
 #include <memory>
+#include <algorithm>
 #include "lcd_manager.h"
 #include "gpio_manager.h"
 #include "config_manager.h"
@@ -18,6 +19,9 @@
 #include "alarm.h"
 #include "demo_refrigeration.h"
 #include "refrigeration_API.h"
+#include "state_publisher.h"
+#include "runtime_counters.h"
+#include "flight_recorder.h"
 
 // Version and config
 inline const std::string version = "2.6.0"; //Make sure you update the version in Makefile.
@@ -29,6 +33,7 @@ inline std::atomic_int api_port{stoi(cfg.get("api.port"))};
 // Global state and synchronization
 inline std::atomic<bool> running{true};
 inline std::mutex status_mutex;
+inline StatePublisher state_publisher;
 
 // Managers and hardware
 inline GpioManager gpio;
@@ -41,7 +46,7 @@ inline Logger logger(debug_code.load());
 inline WiFiManager wifi_manager;
 inline Alarm systemAlarm;
 inline DemoRefrigeration demo;
-inline RefrigerationAPI api(api_port.load(), config_file_name, &logger);
+inline RefrigerationAPI api(api_port.load(), &cfg, &logger);
 
 // Alarm state
 inline std::atomic<bool> isShutdownAlarm{false};
@@ -61,9 +66,12 @@ inline std::atomic<time_t> alarm_reset_button_press_start_time{0};
 inline std::atomic<time_t> state_timer{time(nullptr)};
 inline std::atomic<time_t> pretrip_stage_start{0};
 inline std::atomic<int> pretrip_stage{0};
-inline std::atomic<time_t> compressor_on_start_time{0};
-inline std::string last_compressor_status{"False"};
-inline std::atomic<long> compressor_on_total_seconds{(cfg.get("unit.compressor_run_seconds") == "0" ? 0 : std::stol(cfg.get("unit.compressor_run_seconds")))};
+
+// Relay hours, cycles and defrosts; seeded from the old config value the first time the store is created
+inline RuntimeCounters runtime_counters("/var/lib/refrigeration/counters.dat", std::stoull(cfg.get("unit.compressor_run_seconds")));
+
+// One record per control cycle (1 Hz) for the last logging.flight_recorder_hours; opened in main()
+inline std::unique_ptr<FlightRecorder> flight_recorder;
 
 // Status map
 inline std::map<std::string, std::string> status = {
@@ -82,6 +90,8 @@ inline std::atomic<float> setpoint{std::stof(cfg.get("unit.setpoint"))};
 
 // Logging config
 inline std::atomic<time_t> last_log_timestamp{time(nullptr) - 400};
+inline constexpr int counter_flush_interval = 5 * 60; // Seconds between runtime counter commits
+inline constexpr int log_maintenance_interval = 60 * 60; // Seconds between log compression/retention passes
 
 // Function declarations
 void refrigeration_system(float return_temp_, float supply_temp_, float coil_temp_, float setpoint_);
@@ -98,6 +108,7 @@ void pretrip_mode();
 void hotspot_start();
 void signalHandler(int signal);
 void interruptible_sleep(int total_seconds);
-void update_compressor_on_time(const std::string& new_status);
+StateSnapshot publish_state();
+void log_maintenance_thread();
 
 #endif // REFRIGERATION_H
\ No newline at end of file
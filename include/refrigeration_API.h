@@ -11,29 +11,43 @@
 #define REFRIGERATION_API_H
 
 #include <string>
+#include <set>
 #include <memory>
 #include <functional>
+#include <atomic>
+#include <mutex>
 #include <nlohmann/json.hpp>
 #include "log_manager.h"
+#include "config_manager.h"
 #include "rate_limiter.h"
+#include "state_publisher.h"
+#include "request_trace.h"
 #include <openssl/ssl.h>
 
 using json = nlohmann::json;
 
 #define REFRIGERATION_API_VERSION "1.0.0"
 
+// Response body encodings, chosen from the request's Accept header
+enum class BodyFormat {
+    Json = 0,
+    Cbor,
+    MsgPack,
+    Count
+};
+
 class RefrigerationAPI {
 public:
     /**
      * Initialize API server with port and config manager reference
      * @param port HTTP port to listen on (default 8080)
-     * @param config_file Path to config file for API key
+     * @param config Shared config manager owned by the daemon (API key, limits, system info)
      * @param logger Reference to Logger instance for logging events
      * @param enable_https Enable HTTPS/TLS encryption (default true)
      * @param cert_file Path to SSL certificate file (auto-generated if not exists)
      * @param key_file Path to SSL key file (auto-generated if not exists)
      */
-    RefrigerationAPI(int port = 8080, const std::string& config_file = "/etc/refrigeration/config.env", Logger* logger = nullptr,
+    RefrigerationAPI(int port, ConfigManager* config, Logger* logger = nullptr,
                      bool enable_https = true, const std::string& cert_file = "/etc/refrigeration/server.crt",
                      const std::string& key_file = "/etc/refrigeration/server.key");
 
@@ -51,22 +65,41 @@ public:
 
 private:
     int port_;
-    bool running_;
+    std::atomic<bool> running_;
     bool enable_https_;
-    std::string api_key_;
-    std::string config_file_;
+    ConfigManager* config_;
     std::string cert_file_;
     std::string key_file_;
     Logger* logger_;
     std::unique_ptr<class HTTPServer> server_;
     std::unique_ptr<class RateLimiter> rate_limiter_;
     std::unique_ptr<SSL_CTX, decltype(&SSL_CTX_free)> ssl_context_;
+    RequestTracer tracer_;
+
+    // Serialized /status, /relays and /sensors bodies for one state version, in each BodyFormat
+    struct StatusCache {
+        uint64_t version = 0;
+        std::time_t timestamp = 0;
+        std::string etag;
+        std::string status_body[static_cast<int>(BodyFormat::Count)];
+        std::string relays_body[static_cast<int>(BodyFormat::Count)];
+        std::string sensors_body[static_cast<int>(BodyFormat::Count)];
+    };
+    std::mutex status_cache_mutex_;
+    std::shared_ptr<const StatusCache> status_cache_;
+
+    // Writes a chunk directly to the client connection, returns false once the client is gone
+    using StreamWriter = std::function<bool(const std::string&)>;
 
     // Helper methods
-    void load_api_key();
     bool validate_api_key(const std::string& key);
     std::string get_error_response(int code, const std::string& message);
     std::string extract_client_ip(const std::string& request);
+    std::string extract_header(const std::string& request, const std::string& name);
+    json build_status_json(const StateSnapshot& state);
+    std::shared_ptr<const StatusCache> get_status_cache();
+    struct AdmissionLimits get_admission_limits();
+    void apply_trace_config();
 
     // API Endpoint handlers
     json handle_status_request();
@@ -78,9 +111,23 @@ private:
     json handle_defrost_trigger_request();
     json handle_demo_mode_request(bool enable);
     json handle_system_info_request();
+    json handle_counters_request();
+    json handle_snapshot_request(const std::set<std::string>& fields);
+    json handle_traces_request(size_t limit);
     json handle_config_update_request(const json& config_updates);
-    std::string handle_download_events_request(const std::string& date);
-    std::string handle_download_conditions_request(const std::string& date);
+    std::string handle_download_events_request(const std::string& date, const std::string& request,
+                                               const StreamWriter& write);
+    std::string handle_download_conditions_request(const std::string& date, const std::string& request,
+                                                   const StreamWriter& write);
+    std::string send_log_file(const std::string& path, const std::string& filename, const std::string& request,
+                              const StreamWriter& write);
+    std::string handle_history_request(const std::string& query_string, BodyFormat format,
+                                       const std::string& accept_encoding);
+    std::string handle_flight_recorder_request(const std::string& query_string, BodyFormat format,
+                                               const std::string& accept_encoding);
+    std::string handle_cached_status_request(const std::string& request, const std::string& path,
+                                             const std::string& query_string);
+    std::string handle_stream_request(const std::string& request, const StreamWriter& write);
 
     friend class HTTPServer;
 };
@@ -0,0 +1,124 @@
+/*
+ * Request Tracing
+ * Copyright (c) 2025 William Bellvance Jr
+ * Licensed under the MIT License.
+ *
+ * Per-request phase timings for the API server, kept in a fixed ring buffer
+ */
+
+#ifndef REQUEST_TRACE_H
+#define REQUEST_TRACE_H
+
+#include <string>
+#include <vector>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <ctime>
+#include <cstdint>
+
+enum class TracePhase {
+    Queue = 0,      // Accepted, waiting for its handler thread
+    TlsHandshake,
+    Read,
+    Parse,          // Request line, headers, API key
+    Handler,        // Rate limit, auth and endpoint work
+    Wait,           // Deliberate long-poll wait, not counted towards the slow threshold
+    Serialize,      // json::dump() and response headers
+    Write,
+    Count
+};
+
+// Fixed-size record so tracing a request never allocates
+struct RequestTrace {
+    uint64_t id = 0;
+    std::time_t timestamp = 0;
+    char method[8] = {0};
+    char path[64] = {0};
+    int status = 0;
+    int64_t phase_ns[static_cast<int>(TracePhase::Count)] = {0};
+    int64_t total_ns = 0;
+    bool discard = false;
+    std::chrono::steady_clock::time_point start;
+    std::chrono::steady_clock::time_point last_mark;
+};
+
+class RequestTracer {
+public:
+    /**
+     * Initialize tracer
+     * @param capacity Number of finished traces kept for /api/v1/debug/traces
+     */
+    RequestTracer(size_t capacity = 128);
+
+    /**
+     * Enable or disable tracing
+     */
+    void set_enabled(bool enabled) { enabled_ = enabled; }
+    bool enabled() const { return enabled_; }
+
+    /**
+     * Requests slower than this (excluding long-poll waits) are reported by finish()
+     */
+    void set_slow_threshold_ms(int threshold_ms) { slow_threshold_ms_ = threshold_ms; }
+    int slow_threshold_ms() const { return slow_threshold_ms_; }
+
+    /**
+     * Start tracing a request and make it the active trace for this thread
+     * @param trace Caller-owned record (usually on the stack)
+     * @param accepted When the connection was accepted; the gap until now is recorded as Queue
+     */
+    void begin(RequestTrace& trace, std::chrono::steady_clock::time_point accepted);
+
+    /**
+     * Charge the time since the previous mark to a phase of this thread's active trace.
+     * Does nothing when no trace is active.
+     */
+    static void mark(TracePhase phase);
+
+    /**
+     * Record the request line of this thread's active trace
+     */
+    static void set_request(const char* request, size_t length);
+
+    /**
+     * Don't keep this thread's active trace (e.g. long-lived streams)
+     */
+    static void discard();
+
+    /**
+     * Finish the trace, store it in the ring buffer and clear the active trace
+     * @param status HTTP status code sent
+     * @return true if the request exceeded the slow threshold
+     */
+    bool finish(RequestTrace& trace, int status);
+
+    /**
+     * Most recent traces, newest first
+     * @param limit Maximum number of traces to return
+     */
+    std::vector<RequestTrace> recent(size_t limit) const;
+
+    /**
+     * Name of a phase for logs and JSON
+     */
+    static const char* phase_name(TracePhase phase);
+
+    /**
+     * One-line summary with the phase breakdown in milliseconds
+     */
+    static std::string describe(const RequestTrace& trace);
+
+private:
+    std::atomic<bool> enabled_;
+    std::atomic<int> slow_threshold_ms_;
+    std::atomic<uint64_t> next_id_;
+    mutable std::mutex mutex_;
+    std::vector<RequestTrace> ring_;
+    size_t ring_next_;
+    size_t ring_size_;
+
+    static thread_local RequestTrace* active_;
+};
+
+#endif // REQUEST_TRACE_H
@@ -0,0 +1,117 @@
+/*
+ * Runtime Counters
+ * Copyright (c) 2025 William Bellvance Jr
+ * Licensed under the MIT License.
+ *
+ * Persistent relay run hours, cycle counts and defrost counts kept in a small memory-mapped file
+ */
+
+#ifndef RUNTIME_COUNTERS_H
+#define RUNTIME_COUNTERS_H
+
+#include <string>
+#include <mutex>
+#include <deque>
+#include <chrono>
+#include <cstdint>
+
+// Relays tracked by the counter store
+enum class CounterRelay {
+    Compressor = 0,
+    Fan,
+    Valve,
+    ElectricHeater,
+    Count
+};
+
+struct CounterValues {
+    uint64_t run_seconds[static_cast<int>(CounterRelay::Count)];
+    uint64_t starts[static_cast<int>(CounterRelay::Count)];
+    uint64_t defrost_count;
+};
+
+class RuntimeCounters {
+public:
+    /**
+     * Open (or create) the counter file
+     * @param path Location of the counter file
+     * @param seed_compressor_seconds Compressor run time carried over when the file is created
+     */
+    RuntimeCounters(const std::string& path = "/var/lib/refrigeration/counters.dat", uint64_t seed_compressor_seconds = 0);
+
+    /**
+     * Flush pending counts and unmap the file
+     */
+    ~RuntimeCounters();
+
+    /**
+     * Record the current relay states; counts starts on OFF->ON and accumulates on-time
+     */
+    void update_relays(bool compressor, bool fan, bool valve, bool electric_heater);
+
+    /**
+     * Count a defrost cycle
+     */
+    void record_defrost();
+
+    /**
+     * Get the current counts, including time for relays that are on right now
+     */
+    CounterValues values();
+
+    /**
+     * Number of compressor starts in the last hour
+     */
+    int compressor_starts_last_hour();
+
+    /**
+     * Write counters to the file if interval_seconds have passed since the last write
+     * @return true if a write happened
+     */
+    bool flush_if_due(int interval_seconds);
+
+    /**
+     * Write counters to the inactive slot of the file now
+     */
+    void flush();
+
+    /**
+     * Whether counters are backed by the file (false if it could not be mapped)
+     */
+    bool is_persistent() const { return file_ != nullptr; }
+
+private:
+    // On-disk layout: two slots, the newest one with a valid checksum wins.
+    // Each commit writes the older slot, so a torn write never loses the last good copy.
+    struct Slot {
+        uint32_t magic;
+        uint32_t layout_version;
+        uint64_t sequence;
+        CounterValues values;
+        uint32_t crc;
+        uint32_t reserved;
+    };
+    struct File {
+        Slot slots[2];
+    };
+
+    std::string path_;
+    std::mutex mutex_;
+    File* file_;
+    int fd_;
+    CounterValues values_;
+    uint64_t sequence_;
+    bool relay_on_[static_cast<int>(CounterRelay::Count)];
+    std::chrono::steady_clock::time_point on_since_[static_cast<int>(CounterRelay::Count)];
+    std::chrono::steady_clock::time_point last_flush_;
+    std::deque<std::chrono::steady_clock::time_point> compressor_starts_;
+    bool dirty_;
+
+    bool open_file();
+    void accumulate_running(std::chrono::steady_clock::time_point now);
+    void write_slot();
+    static uint32_t crc32(const void* data, size_t length);
+    static bool slot_valid(const Slot& slot);
+};
+
+#endif // RUNTIME_COUNTERS_H
@@ -0,0 +1,113 @@
+/*
+ * State Publisher
+ * Copyright (c) 2025 William Bellvance Jr
+ * Licensed under the MIT License.
+ *
+ * Versioned snapshots of the control loop state shared with the API server
+ */
+
+#ifndef STATE_PUBLISHER_H
+#define STATE_PUBLISHER_H
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <chrono>
+#include <ctime>
+#include <cstdint>
+
+struct StateSnapshot {
+    uint64_t version = 0;
+    std::time_t timestamp = 0;
+    std::string system_status = "Null";
+    bool compressor = false;
+    bool fan = false;
+    bool valve = false;
+    bool electric_heater = false;
+    float return_temp = -327.0f;
+    float supply_temp = -327.0f;
+    float coil_temp = -327.0f;
+    float setpoint = 0.0f;
+    std::vector<int> active_alarms;
+    bool alarm_warning = false;
+    bool alarm_shutdown = false;
+    bool demo_mode = false;
+    int pretrip_stage = 0;  // 0 when no pretrip is running
+};
+
+class StatePublisher {
+public:
+    /**
+     * Initialize publisher
+     * @param history_size Number of past versions kept for delta/resume lookups
+     */
+    StatePublisher(size_t history_size = 64);
+
+    /**
+     * Publish the latest control loop state. The version is only bumped when
+     * something other than the timestamp changed; the timestamp is refreshed either way.
+     * @param snapshot State gathered by the control loop
+     * @return Current state version after publishing
+     */
+    uint64_t publish(const StateSnapshot& snapshot);
+
+    /**
+     * Get the current state version (0 until the first publish)
+     */
+    uint64_t version() const;
+
+    /**
+     * Time of the latest publish, whether or not it changed the version
+     */
+    std::time_t timestamp() const;
+
+    /**
+     * Get a copy of the current state
+     */
+    StateSnapshot current() const;
+
+    /**
+     * Look up a recently published version
+     * @param version Version to find
+     * @param out Receives the snapshot if found
+     * @return true if the version is still in the history
+     */
+    bool find(uint64_t version, StateSnapshot& out) const;
+
+    /**
+     * Block until the version differs from since_version or the timeout expires
+     * @param keep_waiting If given, also return early once it reads false (see wake_waiters())
+     * @return true if a different version is available
+     */
+    bool wait_for_change(uint64_t since_version, std::chrono::milliseconds timeout,
+                         const std::atomic<bool>* keep_waiting = nullptr) const;
+
+    /**
+     * Wake every wait_for_change() caller so it rechecks its keep_waiting flag.
+     * Clear the flag first; waiters without one go back to sleep.
+     */
+    void wake_waiters() const;
+
+    /**
+     * Identifier of this process instance, used to tell versions from a
+     * previous run apart from the current ones
+     */
+    std::time_t instance_id() const { return instance_id_; }
+
+private:
+    mutable std::mutex mutex_;
+    mutable std::condition_variable changed_;
+    std::atomic<uint64_t> version_;
+    std::atomic<std::time_t> timestamp_;
+    StateSnapshot current_;
+    std::deque<StateSnapshot> history_;
+    size_t history_size_;
+    std::time_t instance_id_;
+
+    static bool same_state(const StateSnapshot& a, const StateSnapshot& b);
+};
+
+#endif // STATE_PUBLISHER_H
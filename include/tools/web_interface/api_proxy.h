@@ -7,6 +7,7 @@
 #define API_PROXY_H
 
 #include "config_manager.h"
+#include "connection_cache.h"
 #include <string>
 #include <nlohmann/json.hpp>
 
@@ -14,12 +15,13 @@ using json = nlohmann::json;
 
 class APIProxy {
 public:
-    APIProxy();
+    explicit APIProxy(ConnectionCache* connections);
     ~APIProxy();
 
     // API operations
     json call_unit_api(const Unit& unit, const std::string& endpoint);
     json get_system_info(const Unit& unit);
+    json get_snapshot(const Unit& unit, const std::string& fields);
     json get_status(const Unit& unit);
     json get_demo_mode(const Unit& unit);
     json get_logs(const Unit& unit);
@@ -37,9 +39,10 @@ public:
 
 private:
     std::string base_url_;
+    ConnectionCache* connections_;
 
-    json perform_http_request(const std::string& url, const std::string& method,
-                             const std::string& body, const std::string& api_key);
+    json perform_http_request(const Unit& unit, const std::string& endpoint, const std::string& method,
+                             const std::string& body);
 
     void write_log(const std::string& message);
 };
@@ -11,10 +11,13 @@
 #define API_WEB_INTERFACE_H
 
 #include "config_manager.h"
+#include "connection_cache.h"
 #include "web_server.h"
 #include "unit_poller.h"
 #include "email_notifier.h"
 #include "api_proxy.h"
+#include "unit_history.h"
+#include "asset_cache.h"
 
 #include <string>
 #include <memory>
@@ -33,21 +36,26 @@ public:
 private:
     // Components
     std::unique_ptr<ConfigManager> config_manager_;
+    std::unique_ptr<ConnectionCache> connection_cache_;  // Declared first: outlives the poller and proxy using it
+    std::unique_ptr<UnitHistory> unit_history_;         // Also outlives the poller appending to it
     std::unique_ptr<WebServer> web_server_;
     std::unique_ptr<UnitPoller> unit_poller_;
     std::unique_ptr<EmailNotifier> email_notifier_;
     std::unique_ptr<APIProxy> api_proxy_;
+    std::unique_ptr<AssetCache> asset_cache_;
 
     bool running_;
     std::string config_file_;
 
     // Request handlers
-    std::string handle_get_request(const std::string& path);
+    std::string handle_get_request(const std::string& path, const std::string& request);
     std::string handle_post_request(const std::string& path, const std::string& body);
+    bool handle_asset_request(const std::string& path, const std::string& request, WebServer::SharedResponse& response);
+    std::string handle_unit_history_request(const std::string& unit_id, const std::string& query_string);
 
     // Download handlers
-    std::string handle_download_events_request(const std::string& date);
-    std::string handle_download_conditions_request(const std::string& date);
+    std::string handle_download_events_request(const std::string& date, bool accept_gzip);
+    std::string handle_download_conditions_request(const std::string& date, bool accept_gzip);
 
     // Utilities
     void write_log(const std::string& message);
@@ -0,0 +1,61 @@
+/*
+ * Asset Cache
+ * Templates and static files held in memory with gzip variants and ETags, reloaded on change
+ */
+
+#ifndef ASSET_CACHE_H
+#define ASSET_CACHE_H
+
+#include "directory_watcher.h"
+#include <string>
+#include <map>
+#include <memory>
+
+// One file, ready to send. Immutable once loaded; a reload builds new ones.
+struct CachedAsset {
+    std::string etag;                                // Strong tag of the identity body
+    std::string gzip_etag;                           // The gzip body is another representation, so another tag
+    std::shared_ptr<const std::string> body;
+    std::shared_ptr<const std::string> gzip_body;    // Null when compressing doesn't make it smaller
+    std::string head;                                // Status line and headers for body, without the blank line
+    std::string gzip_head;
+    std::string not_modified_head;                   // 304 for each representation
+    std::string gzip_not_modified_head;
+};
+
+class AssetCache {
+public:
+    /**
+     * @param static_dir Files served as /static/<name>
+     * @param templates_dir index.html is served as / and /index.html
+     */
+    AssetCache(const std::string& static_dir = "/usr/share/web-api/static",
+               const std::string& templates_dir = "/usr/share/web-api/templates");
+    ~AssetCache();
+
+    // Read every file and publish the new set; requests in progress keep the old one
+    void load();
+
+    // Watch both folders with inotify and reload shortly after files change
+    void start_watch_thread();
+    void stop_watch_thread();
+
+    // Asset for a request path (query string ignored), null if there is none
+    std::shared_ptr<const CachedAsset> find(const std::string& path) const;
+
+private:
+    using AssetMap = std::map<std::string, std::shared_ptr<const CachedAsset>>;
+
+    std::string static_dir_;
+    std::string templates_dir_;
+    std::shared_ptr<const AssetMap> assets_;   // Read and replaced with std::atomic_load/store
+    DirectoryWatcher watcher_;
+
+    static std::shared_ptr<const CachedAsset> build_asset(const std::string& content, const std::string& content_type,
+                                                          const std::string& cache_control);
+    static std::string content_type_for(const std::string& name);
+
+    void write_log(const std::string& message);
+};
+
+#endif // ASSET_CACHE_H
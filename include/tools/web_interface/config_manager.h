@@ -6,11 +6,11 @@
 #ifndef CONFIG_MANAGER_H
 #define CONFIG_MANAGER_H
 
+#include "directory_watcher.h"
 #include <string>
 #include <vector>
 #include <ctime>
 #include <mutex>
-#include <thread>
 #include <functional>
 
 struct Unit {
@@ -20,22 +20,47 @@ struct Unit {
     std::string api_key;
 };
 
+// What changed between two unit lists, matched by ID
+struct UnitDiff {
+    std::vector<Unit> added;
+    std::vector<Unit> removed;
+    std::vector<Unit> changed;    // Same ID with a new address, port or key; holds the new settings
+
+    bool empty() const { return added.empty() && removed.empty() && changed.empty(); }
+};
+
+UnitDiff diff_units(const std::vector<Unit>& before, const std::vector<Unit>& after);
+
+// How the unit poller talks to the fleet
+struct PollSettings {
+    int concurrency = 16;          // Units polled at once
+    int connect_timeout = 3;       // Seconds to establish TCP + TLS
+    int timeout = 10;              // Seconds for the whole request
+    int interval = 30;             // Seconds between polls of a healthy, idle unit
+    int fast_interval = 10;        // Seconds between polls of a unit in alarm, defrost, pretrip or just changed
+    int max_backoff = 600;         // Longest gap between polls of an unreachable unit
+};
+
 class ConfigManager {
 public:
     ConfigManager(const std::string& config_file = "web_interface_config.env");
     ~ConfigManager();
 
-    // Configuration access
-    std::string get_email_server() const { return email_server_; }
-    std::string get_email_address() const { return email_address_; }
-    std::string get_email_password() const { return email_password_; }
-    std::string get_web_password() const { return web_password_; }
-    int get_email_port() const { return email_port_; }
-    int get_web_port() const { return web_port_; }
-    const std::vector<Unit>& get_units() const { return units_; }
+    // Configuration access; safe from any thread while the watch thread reloads
+    std::string get_email_server() const { std::lock_guard<std::mutex> lock(config_mutex_); return email_server_; }
+    std::string get_email_address() const { std::lock_guard<std::mutex> lock(config_mutex_); return email_address_; }
+    std::string get_email_password() const { std::lock_guard<std::mutex> lock(config_mutex_); return email_password_; }
+    std::string get_web_password() const { std::lock_guard<std::mutex> lock(config_mutex_); return web_password_; }
+    int get_email_port() const { std::lock_guard<std::mutex> lock(config_mutex_); return email_port_; }
+    int get_web_port() const { std::lock_guard<std::mutex> lock(config_mutex_); return web_port_; }
+    PollSettings get_poll_settings() const { std::lock_guard<std::mutex> lock(config_mutex_); return poll_settings_; }
+    std::string get_history_dir() const { std::lock_guard<std::mutex> lock(config_mutex_); return history_dir_; }
+    int get_history_retention_days() const { std::lock_guard<std::mutex> lock(config_mutex_); return history_retention_days_; }
+    std::vector<Unit> get_units() const { std::lock_guard<std::mutex> lock(config_mutex_); return units_; }
 
     // Configuration management
     void load_config();
+    // Reloads when the file is written or replaced (inotify), polling its mtime if inotify is unavailable
     void start_watch_thread();
     void stop_watch_thread();
     void reload_if_changed();
@@ -53,16 +78,18 @@ private:
     std::string web_password_;
     int email_port_;
     int web_port_;
+    PollSettings poll_settings_;
+    std::string history_dir_;
+    int history_retention_days_;
 
     std::vector<Unit> units_;
     time_t config_file_mtime_;
-    std::thread config_watch_thread_;
-    bool watching_;
-    std::mutex config_mutex_;
+    DirectoryWatcher watcher_;
+    mutable std::mutex config_mutex_;
     std::function<void()> on_config_changed_;
 
     void load_units_from_config();
-    void config_watch_loop();
+    void reload();
     void write_log(const std::string& message);
 };
 
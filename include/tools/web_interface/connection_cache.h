@@ -0,0 +1,71 @@
+/*
+ * Connection Cache
+ * Reusable curl handles per unit, sharing DNS and TLS sessions between the poller and the proxy
+ */
+
+#ifndef CONNECTION_CACHE_H
+#define CONNECTION_CACHE_H
+
+#include "config_manager.h"
+#include <curl/curl.h>
+#include <string>
+#include <vector>
+#include <map>
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <nlohmann/json.hpp>
+
+using json = nlohmann::json;
+
+class ConnectionCache {
+public:
+    ConnectionCache();
+    ~ConnectionCache();
+
+    // Borrow a handle for a request to the unit. It comes back reset, with the share and
+    // handshake counting attached; the caller sets URL, headers and callbacks as usual.
+    CURL* acquire(const Unit& unit);
+
+    // Hand a handle back once its transfer is finished (and removed from any multi handle).
+    // Its live connection and TLS session stay with it for the next request to the same unit.
+    void release(const Unit& unit, CURL* curl);
+
+    // Drop the unit's connections after its address, port or key changed, or it was removed
+    // from the config. Handles still lent out are closed when they come back instead of being kept.
+    // A removed unit's counters stay allocated (see units_) but leave get_stats().
+    void forget(const std::string& unit_id, bool removed);
+
+    // Per-unit request, connection and TLS handshake counts
+    json get_stats() const;
+
+private:
+    struct UnitConnections {
+        std::vector<CURL*> idle;
+        uint64_t generation = 0;                 // Bumped by forget(); older handles aren't reused
+        bool removed = false;                    // Dropped from the config; nothing is kept idle
+        std::atomic<uint64_t> requests{0};
+        std::atomic<uint64_t> connects{0};       // New TCP connections
+        std::atomic<uint64_t> tls_full{0};       // Full TLS handshakes
+        std::atomic<uint64_t> tls_resumed{0};    // Abbreviated handshakes from a cached session
+    };
+
+    static constexpr size_t max_idle_per_unit = 4;
+
+    CURLSH* share_;
+    std::mutex share_locks_[CURL_LOCK_DATA_LAST];
+    // Entries are never erased: connections in a multi handle's pool outlive the easy handle they
+    // came from, and their SSL_CTX app data keeps pointing at the entry for the TLS counters
+    std::map<std::string, std::unique_ptr<UnitConnections>> units_;
+    std::map<CURL*, uint64_t> lent_generation_;   // Generation each lent handle was acquired in
+    mutable std::mutex mutex_;
+
+    UnitConnections& connections_for(const std::string& unit_id);
+
+    static void lock_share(CURL* handle, curl_lock_data data, curl_lock_access access, void* userptr);
+    static void unlock_share(CURL* handle, curl_lock_data data, void* userptr);
+    static CURLcode attach_ssl_ctx(CURL* curl, void* ssl_ctx, void* userptr);
+    static void tls_info_callback(const struct ssl_st* ssl, int where, int ret);
+};
+
+#endif // CONNECTION_CACHE_H
@@ -0,0 +1,57 @@
+/*
+ * Directory Watcher
+ * Background thread that runs a callback shortly after files in some folders change
+ */
+
+#ifndef DIRECTORY_WATCHER_H
+#define DIRECTORY_WATCHER_H
+
+#include <string>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <functional>
+#include <cstdint>
+
+class DirectoryWatcher {
+public:
+    // Which file names in the watched folders count; every name if empty
+    using NameFilter = std::function<bool(const std::string& name)>;
+
+    DirectoryWatcher();
+    ~DirectoryWatcher();
+
+    /**
+     * Watch folders rather than files, since editors and package upgrades replace files by rename.
+     * on_change runs on the watcher thread once matching events have been quiet for debounce_ms,
+     * so a multi-file update or a save that writes twice runs it once.
+     * @param mask inotify events to watch for (IN_CLOSE_WRITE, IN_MOVED_TO, ...)
+     * @param problems Set to the folders that couldn't be watched, or why watching failed
+     * @return false if nothing could be watched; the thread isn't started then
+     */
+    bool start(const std::vector<std::string>& dirs, uint32_t mask, NameFilter filter,
+               std::function<void()> on_change, std::string& problems);
+
+    /**
+     * Fallback when start() fails: run on_poll every interval_ms until stop()
+     */
+    bool start_polling(int interval_ms, std::function<void()> on_poll, std::string& problems);
+
+    // Wakes the thread and joins it; safe to call when not running
+    void stop();
+    bool running() const { return running_; }
+
+    static constexpr int debounce_ms = 200;
+
+private:
+    std::thread thread_;
+    std::atomic<bool> running_;
+    int inotify_fd_;
+    int stop_fd_;                 // eventfd that wakes the thread for stop
+
+    bool open_stop_fd(std::string& problems);
+    void watch_loop(NameFilter filter, std::function<void()> on_change);
+    void poll_loop(int interval_ms, std::function<void()> on_poll);
+};
+
+#endif // DIRECTORY_WATCHER_H
@@ -1,12 +1,20 @@
 /*
  * Email Notifier
- * Handles alarm notifications via email
+ * Handles alarm notifications via email, queued and sent from a background thread
  */
 
 #ifndef EMAIL_NOTIFIER_H
 #define EMAIL_NOTIFIER_H
 
 #include <string>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <chrono>
+#include <cstdint>
+#include <curl/curl.h>
 #include <nlohmann/json.hpp>
 
 using json = nlohmann::json;
@@ -17,7 +25,15 @@ public:
                   const std::string& email_address, const std::string& email_password);
     ~EmailNotifier();
 
-    // Email sending
+    // Sender thread; stop() sends what's already queued once, without waiting out retries
+    void start();
+    void stop();
+
+    /**
+     * Email sending. Both only queue the message and return at once; false means email
+     * isn't configured. Alarms that arrive within digest_seconds of each other go out
+     * as one email.
+     */
     bool send_alarm_email(const std::string& unit_id, const json& status_data);
     bool send_email(const std::string& to, const std::string& subject, const std::string& body);
 
@@ -25,13 +41,64 @@ public:
     void set_sender(const std::string& email, const std::string& password);
     void set_server(const std::string& server, int port);
 
+    // Queue depth and delivery counters for /api/notifications
+    json get_stats();
+
+    // How long the first alarm waits for others to join its email
+    static constexpr int digest_seconds = 30;
+    // Queued emails beyond this drop the oldest one not being sent
+    static constexpr size_t max_queue = 64;
+    // Failed sends are retried after 30 s, doubling up to 15 min, at most this many times
+    static constexpr int max_attempts = 8;
+    static constexpr int retry_base_seconds = 30;
+    static constexpr int retry_max_seconds = 900;
+
 private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Message {
+        uint64_t id;
+        std::string to;
+        std::string subject;
+        std::string body;
+        int attempts = 0;
+        Clock::time_point next_attempt;
+        std::time_t queued_at = 0;
+    };
+
     std::string email_server_;
     int email_port_;
     std::string email_address_;
     std::string email_password_;
 
-    bool send_smtp_email(const std::string& to, const std::string& subject, const std::string& body);
+    std::mutex mutex_;                         // Guards everything below and the settings above
+    std::condition_variable wake_;
+    std::thread sender_thread_;
+    bool running_;
+    std::deque<Message> queue_;
+    std::map<std::string, json> pending_alarms_;   // Latest status per unit for the next digest
+    Clock::time_point digest_due_;
+    uint64_t next_id_;
+    uint64_t sending_id_;                      // Message in flight, never dropped; 0 when idle
+    CURL* curl_;                               // Kept between sends so the SMTP connection is reused
+
+    // Counters
+    uint64_t queued_;
+    uint64_t sent_;
+    uint64_t failed_;
+    uint64_t retries_;
+    uint64_t dropped_;
+    uint64_t digests_;
+    uint64_t alarms_;
+    uint64_t connections_;
+    std::string last_error_;
+    std::time_t last_sent_;
+
+    void sender_loop();
+    void close_digest();
+    void enqueue(Message message);
+    bool send_smtp_email(const std::string& to, const std::string& subject, const std::string& body,
+                         std::string& error);
     std::string format_alarm_body(const std::string& unit_id, const json& status_data);
 
     void write_log(const std::string& message);
@@ -0,0 +1,145 @@
+/*
+ * Unit History
+ * Per-unit time series of polled samples: day files on disk, recent samples and rollups in memory
+ */
+
+#ifndef UNIT_HISTORY_H
+#define UNIT_HISTORY_H
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <ctime>
+#include <cstdint>
+#include <nlohmann/json.hpp>
+
+using json = nlohmann::json;
+
+// One polled status, 20 bytes in the day files
+struct HistorySample {
+    uint32_t timestamp;
+    int16_t return_temp;     // Hundredths of a degree, INT16_MIN when missing
+    int16_t supply_temp;
+    int16_t coil_temp;
+    int16_t setpoint;
+    uint8_t mode;            // HistoryMode
+    uint8_t relays;          // Bit 0 compressor, 1 fan, 2 valve, 3 electric heater
+    uint8_t flags;           // Bit 0 alarm warning, 1 alarm shutdown
+    uint8_t alarm_count;
+    uint16_t first_alarm;    // Lowest active alarm code, 0 if none
+    uint16_t reserved;
+};
+
+enum class HistoryMode : uint8_t {
+    Unknown = 0,
+    Null,
+    Cooling,
+    Heating,
+    Defrost,
+    Alarm
+};
+
+enum class SampleField {
+    Return = 0,
+    Supply,
+    Coil,
+    Setpoint,
+    Compressor,     // Relays, alarm and defrost aggregate to the fraction of samples they were on
+    Fan,
+    Valve,
+    ElectricHeater,
+    Alarm,
+    Defrost,
+    Count
+};
+
+// Per-bucket aggregates, one column per requested field
+struct HistorySeries {
+    std::time_t from = 0;
+    std::time_t to = 0;
+    int step = 0;
+    std::string source;                         // "recent", "rollup" or "disk"
+    std::vector<SampleField> fields;
+    std::vector<uint32_t> samples;              // [bucket]
+    std::vector<std::vector<uint32_t>> count;   // [field][bucket]
+    std::vector<std::vector<float>> min;
+    std::vector<std::vector<float>> max;
+    std::vector<std::vector<float>> avg;
+};
+
+class UnitHistory {
+public:
+    /**
+     * @param data_dir One subfolder per unit holding YYYY-MM-DD.hist day files (UTC)
+     * @param retention_days Day files older than this are deleted
+     */
+    UnitHistory(const std::string& data_dir = "/var/lib/web-api/history", int retention_days = 90);
+    ~UnitHistory();
+
+    /**
+     * Record a polled /status response. Statuses without readings are skipped, so
+     * offline periods show up as empty buckets.
+     */
+    void append(const std::string& unit_id, const json& status);
+
+    /**
+     * Aggregate [from, to) into buckets of step seconds. Served from the in-memory recent
+     * window or rollups when they cover the range, otherwise from the day files.
+     */
+    HistorySeries query(const std::string& unit_id, std::time_t from, std::time_t to, int step,
+                        const std::vector<SampleField>& fields);
+
+    static const char* field_name(SampleField field);
+    static bool parse_field(const std::string& name, SampleField& field);
+
+    // Upper bound on buckets per query, which bounds the response size
+    static constexpr size_t max_buckets = 2000;
+    // Raw samples kept in memory per unit
+    static constexpr int recent_seconds = 6 * 3600;
+    // Rollup bucket width and how far back rollups are kept in memory
+    static constexpr int rollup_seconds = 900;
+    static constexpr int rollup_keep_seconds = 7 * 24 * 3600;
+
+private:
+    static constexpr int field_count = static_cast<int>(SampleField::Count);
+
+    struct Rollup {
+        uint32_t start;
+        uint32_t samples;
+        uint32_t count[field_count];
+        float min[field_count];
+        float max[field_count];
+        float sum[field_count];
+    };
+
+    struct UnitSeries {
+        bool loaded = false;
+        std::deque<HistorySample> recent;
+        std::deque<Rollup> rollups;
+        std::time_t recent_since = 0;    // Memory holds every sample from these times on
+        std::time_t rollups_since = 0;
+        int fd = -1;                // Today's day file, opened for append
+        std::string day;
+    };
+
+    std::string data_dir_;
+    int retention_days_;
+    std::map<std::string, UnitSeries> units_;
+    std::mutex mutex_;
+
+    UnitSeries& series_for(const std::string& unit_id);
+    void load(const std::string& unit_id, UnitSeries& series);
+    void add_to_memory(UnitSeries& series, const HistorySample& sample);
+    bool open_day_file(const std::string& unit_id, UnitSeries& series, const std::string& day);
+    void remove_expired(const std::string& unit_id);
+    std::vector<HistorySample> read_range(const std::string& unit_id, std::time_t from, std::time_t to) const;
+    std::string unit_dir(const std::string& unit_id) const;
+
+    static bool sample_from_status(const json& status, HistorySample& sample);
+    static bool field_value(const HistorySample& sample, SampleField field, float& value);
+    static std::string day_name(std::time_t time);
+};
+
+#endif // UNIT_HISTORY_H
@@ -7,10 +7,15 @@
 #define UNIT_POLLER_H
 
 #include "config_manager.h"
+#include "connection_cache.h"
 #include <string>
 #include <vector>
 #include <thread>
 #include <mutex>
+#include <atomic>
+#include <queue>
+#include <chrono>
+#include <random>
 #include <map>
 #include <memory>
 #include <nlohmann/json.hpp>
@@ -18,20 +23,56 @@
 using json = nlohmann::json;
 
 class EmailNotifier;  // Forward declaration
+class UnitHistory;
+struct PollTransfer;
+
+// The /api/units body as of one version. Never modified once published, so readers
+// can hold on to it without a lock while the poller publishes the next one.
+struct UnitsSnapshot {
+    struct UnitBody {
+        uint64_t version = 0;                      // Snapshot version in which this status first appeared
+        std::shared_ptr<const std::string> json;   // Shared with later snapshots until it changes
+    };
+
+    uint64_t version = 0;
+    uint64_t first_version = 0;   // Versions below this predate the process; deltas can't start there
+    std::time_t timestamp = 0;
+    std::string etag;             // Quoted, changes with every version and every restart
+    std::string body;             // Full response
+    std::map<std::string, UnitBody> units;
+    std::map<std::string, uint64_t> removed;       // Unit IDs dropped from the config, and when
+
+    // Only the units that changed after version `since` and those removed since then.
+    // Falls back to the full body (with "full": true) when `since` is outside this process's versions.
+    std::string delta_body(uint64_t since) const;
+};
 
 class UnitPoller {
 public:
-    UnitPoller();
+    explicit UnitPoller(ConnectionCache* connections);
     ~UnitPoller();
 
     void start(const std::vector<Unit>& units);
     void stop();
+
+    // Apply a reloaded unit list while running: added units are polled within a few seconds,
+    // removed ones dropped, changed ones re-polled on fresh connections; the rest keep their schedule
+    void update_units(const std::vector<Unit>& units);
     bool is_running() const { return running_; }
     void set_email_notifier(EmailNotifier* notifier) { email_notifier_ = notifier; }
+    void set_history(UnitHistory* history) { history_ = history; }
+    void set_poll_settings(const PollSettings& settings);
+
+    // Poll a unit as soon as a slot is free, e.g. after a user acted on it
+    void request_poll(const std::string& unit_id);
+
+    // Per-unit scheduling state: next poll, current interval, failures and why
+    json get_schedule() const;
 
     // Data access
     json get_unit_data(const std::string& unit_id) const;
-    json get_all_unit_data() const;
+    // Latest /api/units snapshot; a shared pointer load, no copying or serializing
+    std::shared_ptr<const UnitsSnapshot> get_units_snapshot() const;
     json get_active_alarms(const std::string& unit_id) const;
 
     // API calls
@@ -40,17 +81,62 @@ public:
 private:
     std::vector<Unit> units_;
     std::map<std::string, json> unit_data_;
+    std::map<std::string, UnitsSnapshot::UnitBody> unit_bodies_;  // unit_data_ serialized once per change; version 0 until published
+    std::map<std::string, uint64_t> removed_units_;
+    std::shared_ptr<const UnitsSnapshot> units_snapshot_;  // Read and replaced with std::atomic_load/store
+    std::time_t snapshot_epoch_;  // Start time, so ETags from before a restart never match
+    uint64_t first_version_;      // Versions start at the start time x 10^6, so they keep rising across restarts
+    uint64_t snapshot_version_;
     std::map<std::string, std::vector<int>> active_alarms_;
     std::map<std::string, std::string> last_status_;
     EmailNotifier* email_notifier_;
+    UnitHistory* history_;
+    ConnectionCache* connections_;
+    CURLM* multi_;  // Kept across cycles so its connection pool outlives a cycle
+    PollSettings settings_;
+
+    // When each unit is polled next. The queue may hold stale entries for a unit that was
+    // rescheduled; an entry only counts if it matches the unit's current next_due.
+    using Clock = std::chrono::steady_clock;
+    struct UnitSchedule {
+        Unit unit;
+        Clock::time_point next_due;
+        int interval = 0;            // Seconds between the last poll and the next
+        int failures = 0;            // Consecutive polls without an answer
+        bool in_flight = false;
+        bool repoll = false;         // request_poll() arrived while a poll was in flight
+        std::time_t last_poll = 0;
+        std::time_t last_change = 0;
+        std::string state_key;       // Fields whose change speeds polling up
+        std::string reason;
+    };
+    struct ScheduledPoll {
+        Clock::time_point due;
+        std::string unit_id;
+        bool operator>(const ScheduledPoll& other) const { return due > other.due; }
+    };
+    std::map<std::string, UnitSchedule> schedule_;
+    std::priority_queue<ScheduledPoll, std::vector<ScheduledPoll>, std::greater<ScheduledPoll>> poll_queue_;
+    std::mt19937 jitter_rng_;
+
+    std::map<CURL*, std::unique_ptr<PollTransfer>> in_flight_;  // Only touched by the polling thread
 
     std::thread polling_thread_;
     bool running_;
+    std::atomic<bool> stop_requested_;  // Lets the polling loop bail out on stop()
     mutable std::mutex data_mutex_;
 
     void polling_loop();
-    json fetch_unit_status(const Unit& unit);
-    json fetch_unit_logs(const Unit& unit);
+    void schedule_units(const std::vector<Unit>& units);
+    bool accept_result(const Unit& unit);
+    std::vector<Unit> take_due_units(size_t limit, int& wait_ms);
+    void reschedule(const Unit& unit, bool answered, const json& status);
+    bool begin_transfer(const Unit& unit, const PollSettings& settings);
+    void finish_transfers(int wait_ms, std::vector<std::pair<Unit, json>>& results);
+    void abort_transfers();
+    void process_status(const Unit& unit, const json& status);
+    void publish_units_snapshot();
+    json decode_response(const Unit& unit, const char* content_type, const std::string& response);
 
     void write_log(const std::string& message);
 };
@@ -1,6 +1,7 @@
 /*
  * Web Server
- * Handles HTTP requests and static file serving
+ * Handles HTTP requests and static file serving: one epoll thread does all socket I/O,
+ * a small worker pool runs the request handlers
  */
 
 #ifndef WEB_SERVER_H
@@ -11,6 +12,11 @@
 #include <thread>
 #include <mutex>
 #include <map>
+#include <memory>
+#include <deque>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
 #include <functional>
 #include <nlohmann/json.hpp>
 
@@ -18,15 +24,17 @@ using json = nlohmann::json;
 
 class WebServer {
 public:
-    WebServer(int port = 9000);
+    // Handlers may wait on a unit for up to its request timeout, so the pool is sized for
+    // several slow proxied calls at once without queueing the cached routes behind them
+    WebServer(int port = 9000, int worker_count = 32);
     ~WebServer();
 
     void start();
     void stop();
     bool is_running() const { return running_; }
 
-    // Set callback for API requests
-    void set_get_handler(std::function<std::string(const std::string&)> handler) {
+    // Set callback for API requests; GET handlers also get the raw request for its headers
+    void set_get_handler(std::function<std::string(const std::string&, const std::string&)> handler) {
         get_handler_ = handler;
     }
 
@@ -38,20 +46,84 @@ public:
         login_verifier_ = verifier;
     }
 
+    // A response whose body is shared rather than copied, e.g. a cached file. head is the status
+    // line and headers without the blank line; the server adds Connection and sends head and
+    // body together with writev.
+    struct SharedResponse {
+        std::string head;
+        std::shared_ptr<const std::string> body;
+    };
+
+    // Tried before the GET handler; returns false to pass the request on
+    void set_asset_handler(std::function<bool(const std::string&, const std::string&, SharedResponse&)> handler) {
+        asset_handler_ = handler;
+    }
+
+    // Limits on what a client may send; larger requests get 431 or 413
+    static constexpr size_t max_header_bytes = 16 * 1024;
+    static constexpr size_t max_body_bytes = 1024 * 1024;
+    static constexpr size_t max_connections = 1024;
+    // An idle keep-alive connection, or one that stalls mid-request, is closed after this
+    static constexpr int idle_timeout_seconds = 30;
+
 private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Connection {
+        uint64_t serial = 0;         // Tells a reused fd apart from the connection a worker answers
+        std::string in;              // Received bytes; may hold the start of the next request
+        std::string out;             // Response being sent: head, or the whole response
+        std::shared_ptr<const std::string> out_body;  // Shared body sent after out, if any
+        size_t out_sent = 0;
+        bool busy = false;           // A worker has its request; not reading until the answer is sent
+        bool keep_alive = true;
+        bool peer_closed = false;    // Client shut down its side; answer what's buffered, then close
+        Clock::time_point last_active;
+    };
+    struct Job {
+        int fd;
+        uint64_t serial;
+        std::string request;
+        bool keep_alive;
+        std::shared_ptr<const std::string> body;   // Set with the response when it came from the asset handler
+    };
+
     int port_;
+    int worker_count_;
     int server_fd_;
-    bool running_;
+    int epoll_fd_;
+    int wake_fd_;                    // eventfd: a worker finished, or stop() was called
+    std::atomic<bool> running_;
     std::thread server_thread_;
+    std::vector<std::thread> workers_;
     std::mutex server_mutex_;
 
+    // Only touched by the server thread
+    std::map<int, Connection> connections_;
+    uint64_t next_serial_;
+
+    // Handed between the server thread and the workers under server_mutex_
+    std::deque<Job> jobs_;
+    std::deque<Job> finished_;       // request holds the framed response
+    std::condition_variable jobs_ready_;
+
     // Handlers
-    std::function<std::string(const std::string&)> get_handler_;
+    std::function<std::string(const std::string&, const std::string&)> get_handler_;
     std::function<std::string(const std::string&, const std::string&)> post_handler_;
     std::function<bool(const std::string&)> login_verifier_;
+    std::function<bool(const std::string&, const std::string&, SharedResponse&)> asset_handler_;
 
     void server_loop();
-    void handle_client(int client_fd);
+    void worker_loop();
+    void accept_clients();
+    void handle_client(int client_fd, uint32_t events);
+    bool read_client(int client_fd, Connection& conn);
+    void dispatch_request(int client_fd, Connection& conn);
+    bool send_response(int client_fd, Connection& conn);
+    void deliver_responses();
+    void close_client(int client_fd);
+    int close_idle_clients();
+    void watch_client(int client_fd, uint32_t events);
     std::string process_http_request(const std::string& request);
     std::string handle_get_request(const std::string& path);
     std::string handle_post_request(const std::string& path, const std::string& body);
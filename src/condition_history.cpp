@@ -0,0 +1,151 @@
+/*
+ * Condition History Implementation
+ * Copyright (c) 2025 William Bellvance Jr
+ * Licensed under the MIT License.
+ */
+
+#include "condition_history.h"
+#include <zlib.h>
+#include <cstdio>
+#include <cstring>
+#include <cmath>
+#include <limits>
+
+static constexpr int field_count = static_cast<int>(HistoryField::Count);
+
+static const char* const field_names[field_count] = {
+    "setpoint", "return", "supply", "coil", "compressor", "fan", "valve", "electric_heater"
+};
+
+// Relay columns as they appear in Logger::log_conditions
+static const char* const relay_labels[] = {"Compressor: ", "Fan: ", "Valve: ", "Electric_heater: "};
+
+ConditionHistory::ConditionHistory(const std::string& log_folder)
+    : log_folder_(log_folder) {
+}
+
+const char* ConditionHistory::field_name(HistoryField field) {
+    int index = static_cast<int>(field);
+    return (index >= 0 && index < field_count) ? field_names[index] : "unknown";
+}
+
+bool ConditionHistory::parse_field(const std::string& name, HistoryField& field) {
+    for (int i = 0; i < field_count; ++i) {
+        if (name == field_names[i]) {
+            field = static_cast<HistoryField>(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+bool ConditionHistory::parse_line(const std::string& line, std::time_t& timestamp, float values[]) {
+    // "2025-12-05 14:30:00 - Setpoint: 36.000000, Return Sensor: 38.5, Coil Sensor: 32.1, Supply: 35.2, Status: Cooling, Compressor: True, ..."
+    std::tm tm_buf{};
+    float sp, ret, coil, sup;
+    if (std::sscanf(line.c_str(), "%d-%d-%d %d:%d:%d - Setpoint: %f, Return Sensor: %f, Coil Sensor: %f, Supply: %f",
+                    &tm_buf.tm_year, &tm_buf.tm_mon, &tm_buf.tm_mday, &tm_buf.tm_hour, &tm_buf.tm_min, &tm_buf.tm_sec,
+                    &sp, &ret, &coil, &sup) != 10) {
+        return false;
+    }
+    tm_buf.tm_year -= 1900;
+    tm_buf.tm_mon -= 1;
+    tm_buf.tm_isdst = -1;  // Log times are local time
+    timestamp = std::mktime(&tm_buf);
+
+    values[static_cast<int>(HistoryField::Setpoint)] = sp;
+    values[static_cast<int>(HistoryField::Return)] = ret;
+    values[static_cast<int>(HistoryField::Supply)] = sup;
+    values[static_cast<int>(HistoryField::Coil)] = coil;
+
+    for (int r = 0; r < 4; ++r) {
+        float value = std::numeric_limits<float>::quiet_NaN();
+        const char* found = std::strstr(line.c_str(), relay_labels[r]);
+        if (found) {
+            found += std::strlen(relay_labels[r]);
+            if (std::strncmp(found, "True", 4) == 0) value = 1.0f;
+            else if (std::strncmp(found, "False", 5) == 0) value = 0.0f;
+        }
+        values[static_cast<int>(HistoryField::Compressor) + r] = value;
+    }
+    return true;
+}
+
+HistoryResult ConditionHistory::query(std::time_t from, std::time_t to, int step,
+                                      const std::vector<HistoryField>& fields) const {
+    HistoryResult result;
+    result.from = from;
+    result.to = to;
+    result.step = step;
+    result.fields = fields;
+    if (step <= 0 || to <= from) {
+        return result;
+    }
+
+    size_t buckets = static_cast<size_t>((to - from + step - 1) / step);
+    result.samples.assign(buckets, 0);
+    result.count.assign(fields.size(), std::vector<uint32_t>(buckets, 0));
+    result.min.assign(fields.size(), std::vector<float>(buckets, 0.0f));
+    result.max.assign(fields.size(), std::vector<float>(buckets, 0.0f));
+    std::vector<std::vector<double>> sum(fields.size(), std::vector<double>(buckets, 0.0));
+
+    // Walk the local calendar days the range touches
+    std::tm day{};
+    localtime_r(&from, &day);
+    day.tm_hour = 0;
+    day.tm_min = 0;
+    day.tm_sec = 0;
+    day.tm_isdst = -1;
+    std::time_t day_start = std::mktime(&day);
+
+    float values[field_count];
+    char buffer[512];
+    std::string line;
+    while (day_start < to) {
+        char date[16];
+        std::strftime(date, sizeof(date), "%Y-%m-%d", &day);
+        // gzopen reads plain files as-is, so closed days compressed by log maintenance work too
+        std::string path = log_folder_ + "/conditions-" + date + ".log";
+        gzFile log_file = gzopen(path.c_str(), "rb");
+        if (!log_file) {
+            log_file = gzopen((path + ".gz").c_str(), "rb");
+        }
+
+        while (log_file && gzgets(log_file, buffer, sizeof(buffer))) {
+            line.assign(buffer);
+            std::time_t timestamp;
+            if (!parse_line(line, timestamp, values) || timestamp < from || timestamp >= to) {
+                continue;
+            }
+            size_t bucket = static_cast<size_t>((timestamp - from) / step);
+            result.samples[bucket]++;
+            for (size_t f = 0; f < fields.size(); ++f) {
+                float value = values[static_cast<int>(fields[f])];
+                if (std::isnan(value)) continue;
+                uint32_t& n = result.count[f][bucket];
+                if (n == 0 || value < result.min[f][bucket]) result.min[f][bucket] = value;
+                if (n == 0 || value > result.max[f][bucket]) result.max[f][bucket] = value;
+                sum[f][bucket] += value;
+                n++;
+            }
+        }
+        if (log_file) {
+            gzclose(log_file);
+        }
+
+        day.tm_mday += 1;
+        day.tm_hour = 0;
+        day.tm_isdst = -1;
+        day_start = std::mktime(&day);  // Normalizes month and year rollover
+    }
+
+    result.avg.assign(fields.size(), std::vector<float>(buckets, 0.0f));
+    for (size_t f = 0; f < fields.size(); ++f) {
+        for (size_t b = 0; b < buckets; ++b) {
+            if (result.count[f][b] > 0) {
+                result.avg[f][b] = static_cast<float>(sum[f][b] / result.count[f][b]);
+            }
+        }
+    }
+    return result;
+}
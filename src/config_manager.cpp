@@ -16,7 +16,11 @@
 #include <sstream>
 #include <filesystem>
 #include <sys/file.h>
+#include <fcntl.h>
 #include <unistd.h>
+#include <cstdio>
+#include <cerrno>
+#include <cstring>
 
 ConfigManager::ConfigManager(const std::string& filepath)
     : filepath_(filepath) {
@@ -27,18 +31,32 @@ ConfigManager::ConfigManager(const std::string& filepath)
         saveToDotEnv();
     } else {
         loadFromDotEnv();
+        // A config written by an older version lacks keys added since; they read as their defaults
+        for (const auto& [key, config] : validator_.getSchema()) {
+            configValues_.emplace(key, config.defaultValue);
+        }
     }
+    publishSnapshot();
 }
 
 ConfigManager::~ConfigManager() {
 }
 
 std::string ConfigManager::get(const std::string& key) const {
-    auto it = configValues_.find(key);
-    return (it != configValues_.end()) ? it->second : "";
+    ConfigSnapshot values = std::atomic_load(&snapshot_);
+    auto it = values->find(key);
+    return (it != values->end()) ? it->second : "";
 }
 
-bool ConfigManager::set(const std::string& key, const std::string& value) {
+ConfigSnapshot ConfigManager::snapshot() const {
+    return std::atomic_load(&snapshot_);
+}
+
+void ConfigManager::publishSnapshot() {
+    std::atomic_store(&snapshot_, ConfigSnapshot(std::make_shared<const std::map<std::string, std::string>>(configValues_)));
+}
+
+bool ConfigManager::isValid(const std::string& key, const std::string& value) const {
     if (!validator_.isKeyKnown(key)) {
         std::cerr << "[ConfigManager] Unknown config key: " << key << "\n";
         return false;
@@ -47,19 +65,54 @@ bool ConfigManager::set(const std::string& key, const std::string& value) {
         std::cerr << "[ConfigManager] Invalid value for key: " << key << "\n";
         return false;
     }
+    return true;
+}
+
+bool ConfigManager::set(const std::string& key, const std::string& value) {
+    if (!isValid(key, value)) {
+        return false;
+    }
     configValues_[key] = value;
     return true;
 }
 
 bool ConfigManager::save() {
-    saveToDotEnv();
-    return true;
+    return saveToDotEnv();
 }
 
 bool ConfigManager::update(const std::string& key, const std::string& value) {
+    return transaction({{key, value}});
+}
+
+bool ConfigManager::transaction(const std::map<std::string, std::string>& changes) {
+    for (const auto& [key, value] : changes) {
+        if (!isValid(key, value)) {
+            return false;
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(write_mutex_);
+    int lock_fd = lockForWrite();
+    if (lock_fd == -1) {
+        // Saving without the lock could overwrite another process's write
+        return false;
+    }
+
+    // Pick up edits made by other processes, then apply ours on top.
+    // Readers only see the result once it is on disk; a failed save leaves everything as it was.
+    std::map<std::string, std::string> previous = configValues_;
     loadFromDotEnv();
-    set(key, value);
-    save();
+    for (const auto& [key, value] : changes) {
+        configValues_[key] = value;
+    }
+
+    bool ok = save();
+    unlockForWrite(lock_fd);
+    if (!ok) {
+        configValues_ = std::move(previous);
+        return false;
+    }
+    publishSnapshot();
     return true;
 }
 
@@ -70,9 +123,22 @@ void ConfigManager::initializeWithDefaults() {
 }
 
 bool ConfigManager::resetToDefaults() {
+    std::lock_guard<std::mutex> lock(write_mutex_);
+    int lock_fd = lockForWrite();
+    if (lock_fd == -1) {
+        return false;
+    }
+    std::map<std::string, std::string> previous = std::move(configValues_);
     configValues_.clear();
     initializeWithDefaults();
-    return save();
+    bool ok = save();
+    unlockForWrite(lock_fd);
+    if (!ok) {
+        configValues_ = std::move(previous);
+        return false;
+    }
+    publishSnapshot();
+    return true;
 }
 
 void ConfigManager::loadFromDotEnv() {
@@ -105,33 +171,74 @@ void ConfigManager::loadFromDotEnv() {
     close(fd);
 }
 
-void ConfigManager::saveToDotEnv() const {
-    int fd = open(filepath_.c_str(), O_WRONLY | O_CREAT, 0644);
-    if (fd == -1) {
-        std::cerr << "[ConfigManager] Failed to open file for writing: " << filepath_ << "\n";
-        return;
+int ConfigManager::lockForWrite() const {
+    // Writers in every process (daemon, tech tool) serialize on a side file, since
+    // the config file itself is replaced on each save
+    std::string lock_path = filepath_ + ".lock";
+    int lock_fd = open(lock_path.c_str(), O_WRONLY | O_CREAT, 0644);
+    if (lock_fd == -1) {
+        std::cerr << "[ConfigManager] Failed to open lock file: " << lock_path << "\n";
+        return -1;
     }
-
-    if (flock(fd, LOCK_EX) == -1) {
+    if (flock(lock_fd, LOCK_EX) == -1) {
         std::cerr << "[ConfigManager] Failed to acquire exclusive lock on config file.\n";
-        close(fd);
-        return;
+        close(lock_fd);
+        return -1;
     }
+    return lock_fd;
+}
+
+void ConfigManager::unlockForWrite(int lock_fd) const {
+    if (lock_fd == -1) return;
+    flock(lock_fd, LOCK_UN);
+    close(lock_fd);
+}
 
-    // Use std::ofstream with file descriptor
-    std::ofstream file;
-    file.basic_ios<char>::rdbuf()->pubsetbuf(0, 0); // Disable internal buffering
-    file.open(filepath_);
-    if (file.is_open()) {
-        for (const auto& [key, value] : configValues_) {
-            file << key << "=" << value << "\n";
+bool ConfigManager::saveToDotEnv() const {
+    std::string contents;
+    for (const auto& [key, value] : configValues_) {
+        contents += key + "=" + value + "\n";
+    }
+
+    // Write a temp file, sync it, then rename it over the config so a crash or
+    // power cut leaves either the old file or the new one, never a partial one
+    std::string tmp_path = filepath_ + ".tmp";
+    int fd = open(tmp_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd == -1) {
+        std::cerr << "[ConfigManager] Failed to open file for writing: " << tmp_path << "\n";
+        return false;
+    }
+
+    size_t written = 0;
+    while (written < contents.size()) {
+        ssize_t n = write(fd, contents.data() + written, contents.size() - written);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            std::cerr << "[ConfigManager] Could not write to config file: " << tmp_path << "\n";
+            close(fd);
+            unlink(tmp_path.c_str());
+            return false;
         }
-        file.close();
-    } else {
-        std::cerr << "[ConfigManager] Could not write to config file: " << filepath_ << "\n";
+        written += n;
     }
 
-    flock(fd, LOCK_UN); // Unlock the file
+    if (fsync(fd) == -1) {
+        std::cerr << "[ConfigManager] fsync failed: " << std::strerror(errno) << "\n";
+    }
     close(fd);
-}
 
+    if (std::rename(tmp_path.c_str(), filepath_.c_str()) != 0) {
+        std::cerr << "[ConfigManager] Could not replace config file: " << std::strerror(errno) << "\n";
+        unlink(tmp_path.c_str());
+        return false;
+    }
+
+    // Persist the rename itself
+    std::string dir = std::filesystem::path(filepath_).parent_path().string();
+    int dir_fd = open(dir.empty() ? "." : dir.c_str(), O_RDONLY | O_DIRECTORY);
+    if (dir_fd != -1) {
+        fsync(dir_fd);
+        close(dir_fd);
+    }
+    return true;
+}
@@ -15,13 +15,22 @@
 ConfigValidator::ConfigValidator() {
     schema_ = {
         {"api.key",                   {"refrigeration-api-default-key-change-me", ConfigType::String}},
+        {"api.max_connections",       {"16", ConfigType::Integer}},
+        {"api.max_handshakes",        {"4", ConfigType::Integer}},
+        {"api.max_per_ip",            {"8", ConfigType::Integer}},
+        {"api.max_queued",            {"32", ConfigType::Integer}},
+        {"api.max_streams",           {"8", ConfigType::Integer}},
         {"api.port",                  {"8095", ConfigType::Integer}},
+        {"api.trace_enabled",         {"1", ConfigType::Boolean}},
+        {"api.trace_slow_ms",         {"500", ConfigType::Integer}},
         {"compressor.off_timer",      {"5", ConfigType::Integer}},
         {"debug.code",                {"1", ConfigType::Boolean}},
         {"defrost.coil_temperature",  {"45", ConfigType::Integer}},
         {"defrost.interval_hours",    {"8", ConfigType::Integer}},
         {"defrost.timeout_mins",      {"45", ConfigType::Integer}},
+        {"logging.flight_recorder_hours", {"48", ConfigType::Integer}},
         {"logging.interval_mins",     {"5", ConfigType::Integer}},
+        {"logging.max_total_mb",      {"256", ConfigType::Integer}},
         {"logging.retention_period",  {"30", ConfigType::Integer}},
         {"sensor.coil",               {"0", ConfigType::Integer}},
         {"sensor.return",             {"0", ConfigType::Integer}},
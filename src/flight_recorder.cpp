@@ -0,0 +1,276 @@
+/*
+ * Flight Recorder Implementation
+ * Copyright (c) 2025 William Bellvance Jr
+ * Licensed under the MIT License.
+ */
+
+#include "flight_recorder.h"
+#include <iostream>
+#include <filesystem>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <cstddef>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+static constexpr uint32_t flight_magic = 0x46524543;  // "FREC"
+static constexpr uint32_t flight_layout_version = 1;
+static constexpr size_t header_size = 4096;  // Records start on their own page
+static constexpr size_t alarm_code_count = sizeof(FlightRecorder::alarm_codes) / sizeof(FlightRecorder::alarm_codes[0]);
+static constexpr uint32_t other_alarm_bit = 1u << 31;
+
+static_assert(sizeof(FlightRecord) == 32, "FlightRecord layout is part of the file format");
+
+static int16_t to_hundredths(float value) {
+    if (std::isnan(value)) {
+        return INT16_MIN;
+    }
+    return static_cast<int16_t>(std::lround(std::clamp(value, -327.67f, 327.67f) * 100.0f));
+}
+
+static uint8_t mode_from_status(const std::string& status) {
+    if (status == "Null") return static_cast<uint8_t>(FlightMode::Null);
+    if (status == "Cooling") return static_cast<uint8_t>(FlightMode::Cooling);
+    if (status == "Heating") return static_cast<uint8_t>(FlightMode::Heating);
+    if (status == "Defrost") return static_cast<uint8_t>(FlightMode::Defrost);
+    if (status == "Alarm") return static_cast<uint8_t>(FlightMode::Alarm);
+    return static_cast<uint8_t>(FlightMode::Unknown);
+}
+
+FlightRecorder::FlightRecorder(const std::string& path, size_t capacity)
+    : path_(path), capacity_(capacity), fd_(-1), mapping_(nullptr), mapping_size_(0),
+      records_(nullptr), head_(0), sequence_(1) {
+    if (capacity_ == 0) {
+        return;
+    }
+    if (!open_file()) {
+        std::cerr << "[FlightRecorder] Could not map " << path_ << ", control cycles will not be recorded\n";
+        return;
+    }
+
+    // Resume after the newest record
+    uint32_t newest = 0;
+    for (size_t i = 0; i < capacity_; ++i) {
+        if (slot_valid(records_[i]) && records_[i].sequence >= newest) {
+            newest = records_[i].sequence;
+            head_ = (i + 1) % capacity_;
+        }
+    }
+    sequence_ = newest + 1;
+}
+
+FlightRecorder::~FlightRecorder() {
+    if (mapping_) {
+        munmap(mapping_, mapping_size_);
+    }
+    if (fd_ != -1) {
+        close(fd_);
+    }
+}
+
+bool FlightRecorder::open_file() {
+    std::error_code ec;
+    std::filesystem::path dir = std::filesystem::path(path_).parent_path();
+    if (!dir.empty()) {
+        std::filesystem::create_directories(dir, ec);
+    }
+
+    fd_ = open(path_.c_str(), O_RDWR | O_CREAT, 0644);
+    if (fd_ == -1) {
+        return false;
+    }
+
+    mapping_size_ = header_size + capacity_ * sizeof(FlightRecord);
+    struct stat st;
+    if (fstat(fd_, &st) == -1) {
+        close(fd_);
+        fd_ = -1;
+        return false;
+    }
+    bool fresh = st.st_size != static_cast<off_t>(mapping_size_);
+    if (fresh) {
+        // New file or a different capacity: start over with zeroed (never written) slots
+        if (ftruncate(fd_, 0) == -1 || ftruncate(fd_, mapping_size_) == -1) {
+            close(fd_);
+            fd_ = -1;
+            return false;
+        }
+    }
+
+    void* mapped = mmap(nullptr, mapping_size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+    if (mapped == MAP_FAILED) {
+        close(fd_);
+        fd_ = -1;
+        return false;
+    }
+    mapping_ = mapped;
+
+    Header* header = static_cast<Header*>(mapping_);
+    if (fresh || header->magic != flight_magic || header->layout_version != flight_layout_version ||
+        header->record_size != sizeof(FlightRecord) || header->capacity != capacity_) {
+        if (!fresh) {
+            std::memset(mapping_, 0, mapping_size_);  // ftruncate already zeroed a fresh file
+        }
+        header->magic = flight_magic;
+        header->layout_version = flight_layout_version;
+        header->record_size = sizeof(FlightRecord);
+        header->capacity = capacity_;
+    }
+    records_ = reinterpret_cast<FlightRecord*>(static_cast<char*>(mapping_) + header_size);
+    return true;
+}
+
+uint32_t FlightRecorder::checksum(const FlightRecord& record) {
+    // FNV-1a; cheap and enough to catch a half-written slot
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*>(&record);
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < offsetof(FlightRecord, check); ++i) {
+        hash = (hash ^ bytes[i]) * 16777619u;
+    }
+    return hash;
+}
+
+bool FlightRecorder::slot_valid(const FlightRecord& record) const {
+    return record.sequence != 0 && record.check == checksum(record);
+}
+
+uint32_t FlightRecorder::alarm_bit(int code) {
+    for (size_t i = 0; i < alarm_code_count; ++i) {
+        if (alarm_codes[i] == code) {
+            return 1u << i;
+        }
+    }
+    return other_alarm_bit;
+}
+
+std::vector<int> FlightRecorder::decode_alarms(uint32_t bitmap) {
+    std::vector<int> codes;
+    for (size_t i = 0; i < alarm_code_count; ++i) {
+        if (bitmap & (1u << i)) {
+            codes.push_back(alarm_codes[i]);
+        }
+    }
+    if (bitmap & other_alarm_bit) {
+        codes.push_back(0);  // A code without a bit of its own
+    }
+    return codes;
+}
+
+const char* FlightRecorder::mode_name(uint8_t mode) {
+    switch (static_cast<FlightMode>(mode)) {
+        case FlightMode::Null: return "Null";
+        case FlightMode::Cooling: return "Cooling";
+        case FlightMode::Heating: return "Heating";
+        case FlightMode::Defrost: return "Defrost";
+        case FlightMode::Alarm: return "Alarm";
+        default: return "Unknown";
+    }
+}
+
+void FlightRecorder::record(const StateSnapshot& state, bool anti_cycle, int pretrip_stage, uint32_t cycle_us) {
+    if (!records_) {
+        return;
+    }
+
+    FlightRecord record;
+    record.sequence = sequence_++;
+    record.timestamp = static_cast<uint32_t>(state.timestamp);
+    record.return_temp = to_hundredths(state.return_temp);
+    record.supply_temp = to_hundredths(state.supply_temp);
+    record.coil_temp = to_hundredths(state.coil_temp);
+    record.setpoint = to_hundredths(state.setpoint);
+    record.mode = mode_from_status(state.system_status);
+    record.relays = (state.compressor ? FlightCompressor : 0) | (state.fan ? FlightFan : 0) |
+                    (state.valve ? FlightValve : 0) | (state.electric_heater ? FlightElectricHeater : 0);
+    record.flags = (anti_cycle ? FlightAntiCycle : 0) | (state.alarm_warning ? FlightWarning : 0) |
+                   (state.alarm_shutdown ? FlightShutdown : 0) | (state.demo_mode ? FlightDemo : 0);
+    record.pretrip_stage = static_cast<uint8_t>(std::clamp(pretrip_stage, 0, 255));
+    record.alarms = 0;
+    for (int code : state.active_alarms) {
+        record.alarms |= alarm_bit(code);
+    }
+    record.cycle_us = cycle_us;
+    record.check = checksum(record);
+
+    // The kernel writes dirty pages back on its own schedule; a crash of the daemon loses nothing
+    size_t head = head_.load(std::memory_order_relaxed);
+    std::memcpy(&records_[head], &record, sizeof(record));
+    head_.store((head + 1) % capacity_, std::memory_order_release);
+}
+
+size_t FlightRecorder::oldest_slot() const {
+    // Once the ring has wrapped the slot about to be overwritten is the oldest; before that it's slot 0
+    size_t head = head_.load(std::memory_order_acquire);
+    return slot_valid(records_[head]) ? head : 0;
+}
+
+std::vector<FlightRecord> FlightRecorder::read(std::time_t from, std::time_t to) const {
+    std::vector<FlightRecord> result;
+    if (!records_) {
+        return result;
+    }
+    size_t start = oldest_slot();
+    for (size_t n = 0; n < capacity_; ++n) {
+        FlightRecord record = records_[(start + n) % capacity_];
+        if (!slot_valid(record)) continue;
+        if (record.timestamp >= from && record.timestamp < to) {
+            result.push_back(record);
+        }
+    }
+    return result;
+}
+
+std::time_t FlightRecorder::find_alarm_onset(int code) const {
+    if (!records_) {
+        return 0;
+    }
+    uint32_t bit = alarm_bit(code);
+    size_t start = oldest_slot();
+
+    // Walk newest to oldest; the onset is an active record whose predecessor wasn't
+    std::time_t onset = 0;
+    bool in_alarm = false;
+    for (size_t n = capacity_; n-- > 0;) {
+        FlightRecord record = records_[(start + n) % capacity_];
+        if (!slot_valid(record)) continue;
+        bool active = (record.alarms & bit) != 0;
+        if (active) {
+            in_alarm = true;
+            onset = record.timestamp;
+        } else if (in_alarm) {
+            return onset;
+        }
+    }
+    return onset;  // Active since the oldest record, or never seen
+}
+
+bool FlightRecorder::span(std::time_t& oldest, std::time_t& newest) const {
+    if (!records_) {
+        return false;
+    }
+    size_t start = oldest_slot();
+    bool found = false;
+    for (size_t n = 0; n < capacity_; ++n) {
+        const FlightRecord& record = records_[(start + n) % capacity_];
+        if (slot_valid(record)) {
+            oldest = record.timestamp;
+            found = true;
+            break;
+        }
+    }
+    if (!found) {
+        return false;
+    }
+    for (size_t n = capacity_; n-- > 0;) {
+        const FlightRecord& record = records_[(start + n) % capacity_];
+        if (slot_valid(record)) {
+            newest = record.timestamp;
+            break;
+        }
+    }
+    return true;
+}
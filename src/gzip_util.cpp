@@ -0,0 +1,131 @@
+/*
+ * Gzip Utilities Implementation
+ * Copyright (c) 2025 William Bellvance Jr
+ * Licensed under the MIT License.
+ */
+
+#include "gzip_util.h"
+#include <fstream>
+#include <cstdio>
+#include <cstring>
+#include <cstdlib>
+#include <algorithm>
+#include <unistd.h>
+#include <fcntl.h>
+
+static constexpr size_t gzip_chunk_size = 16384;
+static constexpr int gzip_window_bits = 15 + 16;  // +16 selects the gzip wrapper instead of zlib
+
+GzipStream::GzipStream(int level) {
+    std::memset(&stream_, 0, sizeof(stream_));
+    initialized_ = deflateInit2(&stream_, level, Z_DEFLATED, gzip_window_bits, 8, Z_DEFAULT_STRATEGY) == Z_OK;
+    ok_ = initialized_;
+}
+
+GzipStream::~GzipStream() {
+    if (initialized_) {
+        deflateEnd(&stream_);
+    }
+}
+
+std::string GzipStream::run(const char* data, size_t length, int flush) {
+    std::string output;
+    if (!ok_) {
+        return output;
+    }
+
+    char buffer[gzip_chunk_size];
+    stream_.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data));
+    stream_.avail_in = static_cast<uInt>(length);
+    int result;
+    do {
+        stream_.next_out = reinterpret_cast<Bytef*>(buffer);
+        stream_.avail_out = sizeof(buffer);
+        result = deflate(&stream_, flush);
+        if (result == Z_STREAM_ERROR) {
+            ok_ = false;
+            break;
+        }
+        output.append(buffer, sizeof(buffer) - stream_.avail_out);
+    } while (stream_.avail_out == 0);
+
+    // Finishing only succeeded if zlib wrote the trailer
+    if (flush == Z_FINISH && result != Z_STREAM_END) {
+        ok_ = false;
+    }
+    return output;
+}
+
+std::string GzipStream::write(const char* data, size_t length) {
+    return run(data, length, Z_NO_FLUSH);
+}
+
+std::string GzipStream::finish() {
+    return run(nullptr, 0, Z_FINISH);
+}
+
+std::string gzip_compress(const std::string& data, int level) {
+    GzipStream gzip(level);
+    std::string output = gzip.write(data.data(), data.length());
+    output += gzip.finish();
+    return output;
+}
+
+bool gzip_file(const std::string& source, const std::string& destination) {
+    std::ifstream input(source, std::ios::binary);
+    if (!input.is_open()) {
+        return false;
+    }
+
+    std::string temp_path = destination + ".tmp";
+    std::ofstream output(temp_path, std::ios::binary | std::ios::trunc);
+    if (!output.is_open()) {
+        return false;
+    }
+
+    GzipStream gzip(Z_BEST_COMPRESSION);  // Done once per file, so spend the CPU
+    char buffer[gzip_chunk_size];
+    while (input) {
+        input.read(buffer, sizeof(buffer));
+        std::streamsize count = input.gcount();
+        if (count > 0) {
+            output << gzip.write(buffer, static_cast<size_t>(count));
+        }
+    }
+    output << gzip.finish();
+    output.close();
+    // A deflate or read error leaves a truncated .gz that mustn't replace anything
+    if (!output || !gzip.ok() || input.bad()) {
+        std::remove(temp_path.c_str());
+        return false;
+    }
+
+    // Make sure the data is on disk before it replaces anything
+    int fd = open(temp_path.c_str(), O_RDONLY);
+    if (fd >= 0) {
+        fsync(fd);
+        close(fd);
+    }
+    if (std::rename(temp_path.c_str(), destination.c_str()) != 0) {
+        std::remove(temp_path.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool accepts_gzip(const std::string& accept_encoding) {
+    std::string value = accept_encoding;
+    std::transform(value.begin(), value.end(), value.begin(), ::tolower);
+    size_t pos = value.find("gzip");
+    if (pos == std::string::npos) {
+        return false;
+    }
+    // "gzip;q=0" explicitly refuses it
+    size_t end = value.find(',', pos);
+    std::string params = value.substr(pos + 4, end == std::string::npos ? std::string::npos : end - pos - 4);
+    params.erase(std::remove(params.begin(), params.end(), ' '), params.end());
+    if (params.rfind(";q=", 0) == 0) {
+        return std::atof(params.c_str() + 3) > 0.0;
+    }
+    return true;
+}
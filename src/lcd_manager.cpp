@@ -10,6 +10,7 @@
  */
 
 #include "lcd_manager.h"
+#include "metrics.h"
 #include <stdexcept>
 #include <cstring>
 #include <array>
@@ -37,6 +38,7 @@ SMBusDevice::~SMBusDevice()
 
 void SMBusDevice::smbusWriteByte(uint8_t reg, uint8_t value)
 {
+    MetricTimer timer(MetricHistogram::I2cWrite);
     uint8_t buffer[2] = {reg, value};
     if (write(fd, buffer, 2) != 2)
     {
@@ -46,6 +48,7 @@ void SMBusDevice::smbusWriteByte(uint8_t reg, uint8_t value)
 
 void SMBusDevice::smbusWriteBlock(uint8_t reg, const uint8_t *data, uint8_t length)
 {
+    MetricTimer timer(MetricHistogram::I2cWrite);
     uint8_t *buffer = new uint8_t[length + 1];
     buffer[0] = reg;
     memcpy(buffer + 1, data, length);
@@ -10,6 +10,11 @@
  */
 
 #include "log_manager.h"
+#include "metrics.h"
+#include "gzip_util.h"
+#include <vector>
+#include <algorithm>
+#include <ctime>
 
 namespace fs = std::filesystem;
 
@@ -56,6 +61,7 @@ void Logger::release_file_lock(int lock_fd) {
 }
 
 void Logger::log_to_file(const std::string& log_file_path, const std::string& log_line) {
+    MetricTimer timer(MetricHistogram::LogToFile);
     try {
         std::lock_guard<std::mutex> lock(log_mutex);
 
@@ -113,54 +119,156 @@ std::string Logger::get_log_filename(const std::string& base_name, const std::st
     return log_folder + "/" + base_name + "-" + date_str + ".log";
 }
 
-void Logger::clear_old_logs(int days) {
-    try {
-        auto now = std::chrono::system_clock::now();
-        auto cutoff_time = now - std::chrono::hours(24 * days);
+// Date part of "<name>-YYYY-MM-DD.log[...]", empty if the name doesn't have one
+static std::string log_file_date(const std::string& filename) {
+    size_t ext = filename.find(".log");
+    if (ext == std::string::npos || ext < 11 || filename[ext - 11] != '-') {
+        return "";
+    }
+    std::string date = filename.substr(ext - 10, 10);
+    if (date[4] != '-' || date[7] != '-') {
+        return "";
+    }
+    return date;
+}
+
+// Run action on a log file while holding its .lock without waiting; false if the file is busy
+template <typename Action>
+static bool with_log_lock(const std::string& log_path, Action action) {
+    std::string lock_file = log_path + ".lock";
+    int lock_fd = open(lock_file.c_str(), O_CREAT | O_WRONLY, 0644);
+    if (lock_fd == -1) {
+        return false;
+    }
+    bool locked = flock(lock_fd, LOCK_EX | LOCK_NB) == 0;
+    if (locked) {
+        action();
+        flock(lock_fd, LOCK_UN);
+    }
+    close(lock_fd);
+    return locked;
+}
 
+bool Logger::compress_log(const std::string& path, bool remove_original) {
+    bool done = false;
+    with_log_lock(path, [&]() {
+        // The API may already have cached a .gz for this day
+        std::string gz_path = path + ".gz";
+        std::error_code ec;
+        bool fresh = fs::exists(gz_path, ec) && fs::last_write_time(gz_path, ec) >= fs::last_write_time(path, ec);
+        done = fresh || gzip_file(path, gz_path);
+        if (done && remove_original) {
+            fs::remove(path, ec);
+        }
+    });
+    return done;
+}
+
+void Logger::maintain_logs(int retention_days, uint64_t max_total_bytes) {
+    try {
         if (!fs::exists(log_folder)) {
             std::cerr << "Directory '" << log_folder << "' does not exist." << std::endl;
             return;
         }
 
-        for (const auto& entry : fs::directory_iterator(log_folder)) {
-            if (!entry.is_regular_file()) continue;
+        // File names carry the local date, and YYYY-MM-DD compares correctly as a string
+        std::string today = get_current_date();
+        std::time_t cutoff_time = std::time(nullptr) - static_cast<std::time_t>(retention_days) * 24 * 3600;
+        std::tm cutoff_tm;
+        localtime_r(&cutoff_time, &cutoff_tm);
+        char cutoff[16];
+        std::strftime(cutoff, sizeof(cutoff), "%Y-%m-%d", &cutoff_tm);
 
-            // Skip lock files
+        int compressed = 0;
+        int expired = 0;
+        int capped = 0;
+        int stale_locks = 0;
+        std::error_code ec;
+
+        // Pass 1: compress closed days and drop days past the retention period
+        for (const auto& entry : fs::directory_iterator(log_folder, ec)) {
+            std::string path = entry.path().string();
             std::string filename = entry.path().filename().string();
-            if (filename.find(".lock") != std::string::npos) continue;
-
-            auto file_mtime = fs::last_write_time(entry);
-            auto file_mtime_sys = std::chrono::time_point_cast<std::chrono::system_clock::duration>(
-                file_mtime - fs::file_time_type::clock::now() + std::chrono::system_clock::now());
-
-            if (file_mtime_sys < cutoff_time) {
-                try {
-                    // Try to acquire lock before deleting (non-blocking)
-                    std::string lock_file = entry.path().string() + ".lock";
-                    int lock_fd = open(lock_file.c_str(), O_CREAT | O_WRONLY, 0644);
-
-                    if (lock_fd != -1) {
-                        // Try non-blocking lock
-                        if (flock(lock_fd, LOCK_EX | LOCK_NB) == 0) {
-                            // Lock acquired, safe to delete
-                            fs::remove(entry.path());
-                            fs::remove(lock_file);
-                            std::cout << "Deleted: " << entry.path() << std::endl;
-                            flock(lock_fd, LOCK_UN);
-                        } else {
-                            std::cout << "File still in use, skipping: " << entry.path() << std::endl;
-                        }
-                        close(lock_fd);
-                    }
-                } catch (const std::exception& e) {
-                    std::cerr << "Error deleting file " << entry.path() << ": " << e.what() << std::endl;
+            std::string date = log_file_date(filename);
+            if (date.empty() || date >= today || !entry.is_regular_file(ec)) continue;
+
+            bool is_log = filename.size() > 4 && filename.compare(filename.size() - 4, 4, ".log") == 0;
+            bool is_gz = filename.size() > 7 && filename.compare(filename.size() - 7, 7, ".log.gz") == 0;
+
+            if (date < cutoff && (is_log || is_gz)) {
+                std::string log_path = is_gz ? path.substr(0, path.size() - 3) : path;
+                with_log_lock(log_path, [&]() {
+                    if (fs::remove(path, ec)) expired++;
+                });
+            } else if (is_log) {
+                if (compress_log(path, true)) compressed++;
+            }
+        }
+
+        // Pass 2: lock files and half-written .tmp files whose day has been closed
+        for (const auto& entry : fs::directory_iterator(log_folder, ec)) {
+            std::string path = entry.path().string();
+            std::string filename = entry.path().filename().string();
+            std::string date = log_file_date(filename);
+            if (date.empty() || date >= today) continue;
+
+            if (filename.size() > 5 && filename.compare(filename.size() - 5, 5, ".lock") == 0) {
+                std::string log_path = path.substr(0, path.size() - 5);
+                if (fs::exists(log_path, ec)) continue;
+                with_log_lock(log_path, [&]() {
+                    if (fs::remove(path, ec)) stale_locks++;
+                });
+            } else if (filename.size() > 4 && filename.compare(filename.size() - 4, 4, ".tmp") == 0) {
+                // Left by a crash mid-compression; a recent one may still be in progress
+                auto age = fs::file_time_type::clock::now() - fs::last_write_time(path, ec);
+                if (!ec && age > std::chrono::hours(1)) {
+                    fs::remove(path, ec);
                 }
             }
         }
-        std::cout << "Log cleanup complete." << std::endl;
+
+        // Pass 3: if the folder is still over the cap, delete the oldest closed days first.
+        // Only .log and .log.gz files, each under its log's .lock; lock and .tmp files are pass 2's.
+        if (max_total_bytes > 0) {
+            std::vector<std::pair<std::string, fs::path>> closed;  // (date, path)
+            uint64_t total = 0;
+            for (const auto& entry : fs::directory_iterator(log_folder, ec)) {
+                if (!entry.is_regular_file(ec)) continue;
+                total += entry.file_size(ec);
+                std::string filename = entry.path().filename().string();
+                std::string date = log_file_date(filename);
+                bool is_log = filename.size() > 4 && filename.compare(filename.size() - 4, 4, ".log") == 0;
+                bool is_gz = filename.size() > 7 && filename.compare(filename.size() - 7, 7, ".log.gz") == 0;
+                if (!date.empty() && date < today && (is_log || is_gz)) {
+                    closed.emplace_back(date, entry.path());
+                }
+            }
+            std::sort(closed.begin(), closed.end());
+            for (const auto& file : closed) {
+                if (total <= max_total_bytes) break;
+                std::string path = file.second.string();
+                bool is_gz = path.compare(path.size() - 3, 3, ".gz") == 0;
+                with_log_lock(is_gz ? path.substr(0, path.size() - 3) : path, [&]() {
+                    uint64_t size = fs::file_size(path, ec);
+                    if (!ec && fs::remove(path, ec)) {
+                        total -= size;
+                        capped++;
+                    }
+                });
+            }
+            if (total > max_total_bytes) {
+                log_events("Error", "Log maintenance: " + log_folder + " is " + std::to_string(total / (1024 * 1024)) +
+                           " MB, over the cap, with nothing left to remove but today's logs");
+            }
+        }
+
+        if (compressed || expired || capped || stale_locks) {
+            log_events("Info", "Log maintenance: compressed " + std::to_string(compressed) +
+                       ", expired " + std::to_string(expired) + ", removed for size " + std::to_string(capped) +
+                       ", stale locks " + std::to_string(stale_locks));
+        }
     } catch (const std::exception& e) {
-        std::cerr << "Error during log cleanup: " << e.what() << std::endl;
+        std::cerr << "Error during log maintenance: " << e.what() << std::endl;
     }
 }
 
@@ -0,0 +1,261 @@
+/*
+ * Metrics Implementation
+ * Copyright (c) 2025 William Bellvance Jr
+ * Licensed under the MIT License.
+ */
+
+#include "metrics.h"
+#include <atomic>
+#include <mutex>
+#include <vector>
+#include <sstream>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+
+static constexpr int counter_count = static_cast<int>(MetricCounter::Count);
+static constexpr int histogram_count = static_cast<int>(MetricHistogram::Count);
+
+// Upper bounds in nanoseconds, 100us .. 10s; one extra slot for +Inf
+static constexpr uint64_t bucket_bounds_ns[] = {
+    100000, 250000, 500000, 1000000, 2500000, 5000000, 10000000, 25000000,
+    50000000, 100000000, 250000000, 500000000, 1000000000, 2500000000ULL, 5000000000ULL, 10000000000ULL
+};
+static constexpr int bucket_count = sizeof(bucket_bounds_ns) / sizeof(bucket_bounds_ns[0]);
+
+static const char* const counter_names[counter_count][2] = {
+    {"refrigeration_rate_limit_rejections_total", "Requests rejected by the API rate limiter"},
+    {"refrigeration_api_admission_rejections_total", "API connections turned away by admission control"},
+};
+
+static const char* const sensor_labels[] = {"return", "supply", "coil"};
+static const char* const endpoint_labels[] = {
+    "other", "/health", "/api/v1/status", "/api/v1/relays", "/api/v1/sensors", "/api/v1/setpoint",
+    "/api/v1/alarms/reset", "/api/v1/defrost/trigger", "/api/v1/demo-mode", "/api/v1/system-info",
+    "/api/v1/config", "/api/v1/counters", "/api/v1/logs/events", "/api/v1/logs/conditions", "/api/v1/metrics",
+    "/api/v1/debug/traces", "/api/v1/snapshot",
+    "/api/v1/history", "/api/v1/flight-recorder"
+};
+
+struct HistogramInfo {
+    const char* name;
+    const char* help;
+    const char* label_name;
+    const char* const* label_values;
+    int label_count;
+};
+
+static const HistogramInfo histogram_info[histogram_count] = {
+    {"refrigeration_control_cycle_seconds", "Time spent in one control loop iteration", nullptr, nullptr, 1},
+    {"refrigeration_control_jitter_seconds", "Control loop wake-up delay past its scheduled sleep", nullptr, nullptr, 1},
+    {"refrigeration_sensor_read_seconds", "1-Wire temperature sensor read latency", "sensor", sensor_labels, 3},
+    {"refrigeration_lcd_frame_seconds", "Time to write one frame to both LCDs", nullptr, nullptr, 1},
+    {"refrigeration_i2c_write_seconds", "Latency of a single SMBus write", nullptr, nullptr, 1},
+    {"refrigeration_log_write_seconds", "Logger::log_to_file latency including the file lock", nullptr, nullptr, 1},
+    {"refrigeration_api_tls_handshake_seconds", "API TLS handshake time", nullptr, nullptr, 1},
+    {"refrigeration_api_request_seconds", "API request handling time by endpoint", "endpoint", endpoint_labels,
+     static_cast<int>(sizeof(endpoint_labels) / sizeof(endpoint_labels[0]))},
+};
+
+struct HistogramCells {
+    std::atomic<uint64_t> buckets[bucket_count + 1];
+    std::atomic<uint64_t> sum_ns;
+    std::atomic<uint64_t> count;
+};
+
+// One thread's metrics. Only the owning thread writes, so updates are plain relaxed
+// load/store pairs with no locked instructions; readers sum all shards.
+struct MetricShard {
+    std::atomic<uint64_t> counters[counter_count];
+    HistogramCells histograms[histogram_count][Metrics::max_labels];
+
+    MetricShard() { clear(); }
+
+    void clear() {
+        for (auto& c : counters) c.store(0, std::memory_order_relaxed);
+        for (auto& per_label : histograms) {
+            for (auto& h : per_label) {
+                for (auto& b : h.buckets) b.store(0, std::memory_order_relaxed);
+                h.sum_ns.store(0, std::memory_order_relaxed);
+                h.count.store(0, std::memory_order_relaxed);
+            }
+        }
+    }
+
+    void add_to(MetricShard& total) const {
+        for (int i = 0; i < counter_count; ++i) {
+            total.counters[i].fetch_add(counters[i].load(std::memory_order_relaxed), std::memory_order_relaxed);
+        }
+        for (int h = 0; h < histogram_count; ++h) {
+            for (int l = 0; l < Metrics::max_labels; ++l) {
+                const HistogramCells& src = histograms[h][l];
+                HistogramCells& dst = total.histograms[h][l];
+                for (int b = 0; b <= bucket_count; ++b) {
+                    dst.buckets[b].fetch_add(src.buckets[b].load(std::memory_order_relaxed), std::memory_order_relaxed);
+                }
+                dst.sum_ns.fetch_add(src.sum_ns.load(std::memory_order_relaxed), std::memory_order_relaxed);
+                dst.count.fetch_add(src.count.load(std::memory_order_relaxed), std::memory_order_relaxed);
+            }
+        }
+    }
+};
+
+struct MetricRegistry {
+    std::mutex mutex;
+    std::vector<MetricShard*> live;
+    std::vector<MetricShard*> free_list;
+    MetricShard retired;  // Totals from threads that have exited
+};
+
+static MetricRegistry& registry() {
+    // Never destroyed, so threads exiting during shutdown can still retire their shard
+    static MetricRegistry* instance = new MetricRegistry();
+    return *instance;
+}
+
+// Hands a shard to each thread on first use and folds it back into the totals when the
+// thread exits. Shards are recycled, so short-lived connection threads don't allocate.
+struct ShardHandle {
+    MetricShard* shard = nullptr;
+
+    MetricShard& get() {
+        if (!shard) {
+            MetricRegistry& reg = registry();
+            std::lock_guard<std::mutex> lock(reg.mutex);
+            if (!reg.free_list.empty()) {
+                shard = reg.free_list.back();
+                reg.free_list.pop_back();
+            } else {
+                shard = new MetricShard();
+            }
+            reg.live.push_back(shard);
+        }
+        return *shard;
+    }
+
+    ~ShardHandle() {
+        if (!shard) return;
+        MetricRegistry& reg = registry();
+        std::lock_guard<std::mutex> lock(reg.mutex);
+        shard->add_to(reg.retired);
+        shard->clear();
+        for (size_t i = 0; i < reg.live.size(); ++i) {
+            if (reg.live[i] == shard) {
+                reg.live[i] = reg.live.back();
+                reg.live.pop_back();
+                break;
+            }
+        }
+        reg.free_list.push_back(shard);
+    }
+};
+
+static thread_local ShardHandle local_shard;
+
+static inline void bump(std::atomic<uint64_t>& cell, uint64_t amount) {
+    cell.store(cell.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+}
+
+void Metrics::increment(MetricCounter counter, uint64_t amount) {
+    bump(local_shard.get().counters[static_cast<int>(counter)], amount);
+}
+
+void Metrics::observe(MetricHistogram histogram, uint64_t nanoseconds, int label) {
+    if (label < 0 || label >= max_labels) {
+        label = 0;
+    }
+    int bucket = 0;
+    while (bucket < bucket_count && nanoseconds > bucket_bounds_ns[bucket]) {
+        ++bucket;
+    }
+    HistogramCells& cells = local_shard.get().histograms[static_cast<int>(histogram)][label];
+    bump(cells.buckets[bucket], 1);
+    bump(cells.sum_ns, nanoseconds);
+    bump(cells.count, 1);
+}
+
+int Metrics::endpoint_label(const std::string& path) {
+    const int count = static_cast<int>(sizeof(endpoint_labels) / sizeof(endpoint_labels[0]));
+    for (int i = 1; i < count; ++i) {
+        if (path == endpoint_labels[i]) {
+            return i;
+        }
+    }
+    if (path == "/api/v1/health") return 1;
+    return 0;
+}
+
+static int read_thread_count() {
+    std::ifstream status_file("/proc/self/status");
+    std::string line;
+    while (std::getline(status_file, line)) {
+        if (line.compare(0, 8, "Threads:") == 0) {
+            try {
+                return std::stoi(line.substr(8));
+            } catch (...) {
+                return 0;
+            }
+        }
+    }
+    return 0;
+}
+
+std::string Metrics::render_prometheus() {
+    std::unique_ptr<MetricShard> total(new MetricShard());
+    {
+        MetricRegistry& reg = registry();
+        std::lock_guard<std::mutex> lock(reg.mutex);
+        reg.retired.add_to(*total);
+        for (MetricShard* shard : reg.live) {
+            shard->add_to(*total);
+        }
+    }
+
+    std::ostringstream out;
+    out << std::setprecision(9);
+
+    for (int i = 0; i < counter_count; ++i) {
+        out << "# HELP " << counter_names[i][0] << " " << counter_names[i][1] << "\n";
+        out << "# TYPE " << counter_names[i][0] << " counter\n";
+        out << counter_names[i][0] << " " << total->counters[i].load() << "\n";
+    }
+
+    for (int h = 0; h < histogram_count; ++h) {
+        const HistogramInfo& info = histogram_info[h];
+        out << "# HELP " << info.name << " " << info.help << "\n";
+        out << "# TYPE " << info.name << " histogram\n";
+        for (int l = 0; l < info.label_count; ++l) {
+            const HistogramCells& cells = total->histograms[h][l];
+            uint64_t count = cells.count.load();
+            if (info.label_name && count == 0) continue;
+
+            std::string label_prefix;
+            std::string label_only;
+            if (info.label_name) {
+                label_only = std::string(info.label_name) + "=\"" + info.label_values[l] + "\"";
+                label_prefix = label_only + ",";
+            }
+
+            uint64_t cumulative = 0;
+            for (int b = 0; b <= bucket_count; ++b) {
+                cumulative += cells.buckets[b].load();
+                out << info.name << "_bucket{" << label_prefix << "le=\"";
+                if (b < bucket_count) {
+                    out << static_cast<double>(bucket_bounds_ns[b]) / 1e9;
+                } else {
+                    out << "+Inf";
+                }
+                out << "\"} " << cumulative << "\n";
+            }
+            std::string labels = label_only.empty() ? "" : "{" + label_only + "}";
+            out << info.name << "_sum" << labels << " " << static_cast<double>(cells.sum_ns.load()) / 1e9 << "\n";
+            out << info.name << "_count" << labels << " " << count << "\n";
+        }
+    }
+
+    out << "# HELP refrigeration_threads Number of threads in the daemon\n";
+    out << "# TYPE refrigeration_threads gauge\n";
+    out << "refrigeration_threads " << read_thread_count() << "\n";
+
+    return out.str();
+}
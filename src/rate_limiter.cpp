@@ -7,126 +7,221 @@
 #include "rate_limiter.h"
 #include <algorithm>
 #include <sstream>
+#include <functional>
+
+static constexpr int64_t ns_per_minute = 60LL * 1000 * 1000 * 1000;
+static constexpr int64_t ns_per_second = 1000LL * 1000 * 1000;
 
 RateLimiter::RateLimiter(int global_requests_per_minute,
                          int per_ip_requests_per_minute,
-                         int per_key_requests_per_minute)
-    : global_requests_per_minute_(global_requests_per_minute),
-      per_ip_requests_per_minute_(per_ip_requests_per_minute),
-      per_key_requests_per_minute_(per_key_requests_per_minute) {
-    // Initialize global bucket
-    global_buckets_["global"] = {global_requests_per_minute, std::time(nullptr)};
+                         int per_key_requests_per_minute,
+                         size_t max_tracked_clients)
+    : global_limit_(make_limit(global_requests_per_minute)),
+      ip_limit_(make_limit(per_ip_requests_per_minute)),
+      key_limit_(make_limit(per_key_requests_per_minute)),
+      global_tat_(0),
+      ip_stripes_(stripe_count),
+      key_stripes_(stripe_count),
+      evictions_(0),
+      overflows_(0),
+      rejections_(0) {
+    size_t per_stripe = std::max<size_t>(1, max_tracked_clients / stripe_count);
+    for (size_t i = 0; i < stripe_count; ++i) {
+        ip_stripes_[i].capacity = per_stripe;
+        ip_stripes_[i].index.reserve(per_stripe);
+        key_stripes_[i].capacity = per_stripe;
+        key_stripes_[i].index.reserve(per_stripe);
+    }
 }
 
-void RateLimiter::refill_bucket(TokenBucket& bucket, int capacity) {
-    std::time_t now = std::time(nullptr);
-    std::time_t time_passed = now - bucket.last_refill;
-
-    if (time_passed >= 60) {
-        // Reset bucket if a full minute has passed
-        bucket.tokens = capacity;
-        bucket.last_refill = now;
-    } else if (time_passed > 0) {
-        // Add tokens based on time passed
-        // This allows smooth refill over the minute instead of all-at-once
-        int tokens_to_add = (capacity * time_passed) / 60;
-        bucket.tokens = std::min(capacity, bucket.tokens + tokens_to_add);
-    }
+RateLimiter::Limit RateLimiter::make_limit(int requests_per_minute) {
+    Limit limit;
+    limit.requests_per_minute = std::max(1, requests_per_minute);
+    limit.emission_interval = ns_per_minute / limit.requests_per_minute;
+    // Allow a full minute's worth of requests as a burst, like a bucket that starts full
+    limit.burst_tolerance = limit.emission_interval * (limit.requests_per_minute - 1);
+    return limit;
 }
 
-bool RateLimiter::is_allowed(const std::string& ip_address, const std::string& api_key) {
-    std::lock_guard<std::mutex> lock(mutex_);
+int64_t RateLimiter::now_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now().time_since_epoch()).count();
+}
 
-    // Check global limit
-    auto& global_bucket = global_buckets_["global"];
-    refill_bucket(global_bucket, global_requests_per_minute_);
+uint64_t RateLimiter::hash_client(const std::string& client) {
+    return std::hash<std::string>{}(client);
+}
 
-    if (global_bucket.tokens <= 0) {
-        return false;  // Global rate limit exceeded
+RateLimiter::Stripe& RateLimiter::stripe_for(std::vector<Stripe>& stripes, uint64_t hash) {
+    return stripes[hash % stripe_count];
+}
+
+int64_t& RateLimiter::find_or_insert(Stripe& stripe, uint64_t hash, int64_t now) {
+    auto it = stripe.index.find(hash);
+    if (it != stripe.index.end()) {
+        stripe.lru.splice(stripe.lru.begin(), stripe.lru, it->second);
+        return it->second->tat;
     }
 
-    // Check per-IP limit
-    auto& ip_bucket = ip_buckets_[ip_address];
-    if (ip_bucket.last_refill == 0) {
-        // Initialize bucket for this IP
-        ip_bucket = {per_ip_requests_per_minute_, std::time(nullptr)};
+    if (stripe.lru.size() >= stripe.capacity) {
+        // Reuse the least recently used entry only once its TAT has passed: it then holds no
+        // state a fresh entry wouldn't. A client still paying off a burst is moved to the front
+        // and the next one tried, a few at most; if none is idle, the new client shares the
+        // stripe's overflow bucket, so a flood of new addresses or keys can't reset anyone's limit.
+        bool reused = false;
+        for (int probe = 0; probe < eviction_probes && !reused; ++probe) {
+            auto last = std::prev(stripe.lru.end());
+            stripe.lru.splice(stripe.lru.begin(), stripe.lru, last);
+            if (last->tat <= now) {
+                stripe.index.erase(last->hash);
+                reused = true;
+            }
+        }
+        if (!reused) {
+            overflows_++;
+            return stripe.overflow_tat;
+        }
+        evictions_++;
+    } else {
+        stripe.lru.emplace_front();
+    }
+
+    Entry& entry = stripe.lru.front();
+    entry.hash = hash;
+    entry.tat = now;
+    stripe.index[hash] = stripe.lru.begin();
+    return entry.tat;
+}
+
+bool RateLimiter::try_consume_global(int64_t now) {
+    int64_t tat = global_tat_.load(std::memory_order_relaxed);
+    while (true) {
+        int64_t start = std::max(tat, now);
+        if (start - now > global_limit_.burst_tolerance) {
+            return false;
+        }
+        if (global_tat_.compare_exchange_weak(tat, start + global_limit_.emission_interval,
+                                              std::memory_order_relaxed)) {
+            return true;
+        }
     }
-    refill_bucket(ip_bucket, per_ip_requests_per_minute_);
+}
 
-    if (ip_bucket.tokens <= 0) {
+bool RateLimiter::is_allowed(const std::string& ip_address, const std::string& api_key) {
+    int64_t now = now_ns();
+
+    // Per-IP limit
+    uint64_t ip_hash = hash_client(ip_address);
+    Stripe& ip_stripe = stripe_for(ip_stripes_, ip_hash);
+    std::lock_guard<std::mutex> ip_lock(ip_stripe.mutex);
+    int64_t& ip_tat = find_or_insert(ip_stripe, ip_hash, now);
+    int64_t ip_start = std::max(ip_tat, now);
+    if (ip_start - now > ip_limit_.burst_tolerance) {
+        rejections_++;
         return false;  // Per-IP rate limit exceeded
     }
 
-    // Check per-key limit if API key provided
+    // Per-key limit if API key provided (key and IP tables are separate, so no lock ordering issue)
+    std::unique_lock<std::mutex> key_lock;
+    int64_t* key_tat = nullptr;
+    int64_t key_start = 0;
     if (!api_key.empty()) {
-        auto& key_bucket = key_buckets_[api_key];
-        if (key_bucket.last_refill == 0) {
-            // Initialize bucket for this API key
-            key_bucket = {per_key_requests_per_minute_, std::time(nullptr)};
-        }
-        refill_bucket(key_bucket, per_key_requests_per_minute_);
-
-        if (key_bucket.tokens <= 0) {
+        uint64_t key_hash = hash_client(api_key);
+        Stripe& key_stripe = stripe_for(key_stripes_, key_hash);
+        key_lock = std::unique_lock<std::mutex>(key_stripe.mutex);
+        key_tat = &find_or_insert(key_stripe, key_hash, now);
+        key_start = std::max(*key_tat, now);
+        if (key_start - now > key_limit_.burst_tolerance) {
+            rejections_++;
             return false;  // Per-key rate limit exceeded
         }
-
-        // Consume token from key bucket
-        key_bucket.tokens--;
     }
 
-    // Consume tokens from both global and IP buckets
-    global_bucket.tokens--;
-    ip_bucket.tokens--;
+    // Global limit last, so a rejected client doesn't use up global capacity
+    if (!try_consume_global(now)) {
+        rejections_++;
+        return false;  // Global rate limit exceeded
+    }
 
+    ip_tat = ip_start + ip_limit_.emission_interval;
+    if (key_tat) {
+        *key_tat = key_start + key_limit_.emission_interval;
+    }
     return true;
 }
 
 int RateLimiter::get_remaining_requests(const std::string& ip_address) {
-    std::lock_guard<std::mutex> lock(mutex_);
+    uint64_t hash = hash_client(ip_address);
+    Stripe& stripe = stripe_for(ip_stripes_, hash);
+    std::lock_guard<std::mutex> lock(stripe.mutex);
 
-    auto it = ip_buckets_.find(ip_address);
-    if (it == ip_buckets_.end()) {
-        return per_ip_requests_per_minute_;
+    auto it = stripe.index.find(hash);
+    if (it == stripe.index.end()) {
+        return ip_limit_.requests_per_minute;
     }
 
-    TokenBucket bucket = it->second;
-    refill_bucket(bucket, per_ip_requests_per_minute_);
-    return std::max(0, bucket.tokens);
+    int64_t now = now_ns();
+    int64_t ahead = std::max<int64_t>(0, it->second->tat - now);
+    int64_t headroom = ip_limit_.burst_tolerance - ahead;
+    if (headroom < 0) {
+        return 0;
+    }
+    return static_cast<int>(std::min<int64_t>(ip_limit_.requests_per_minute,
+                                              headroom / ip_limit_.emission_interval + 1));
 }
 
 int RateLimiter::get_reset_time(const std::string& ip_address) {
-    std::lock_guard<std::mutex> lock(mutex_);
+    uint64_t hash = hash_client(ip_address);
+    Stripe& stripe = stripe_for(ip_stripes_, hash);
+    std::lock_guard<std::mutex> lock(stripe.mutex);
 
-    auto it = ip_buckets_.find(ip_address);
-    if (it == ip_buckets_.end()) {
+    auto it = stripe.index.find(hash);
+    if (it == stripe.index.end()) {
         return 0;
     }
 
-    std::time_t now = std::time(nullptr);
-    std::time_t time_since_refill = now - it->second.last_refill;
-    int reset_in = 60 - time_since_refill;
-
-    return std::max(0, reset_in);
+    int64_t wait = it->second->tat - ip_limit_.burst_tolerance - now_ns();
+    if (wait <= 0) {
+        return 0;
+    }
+    return static_cast<int>((wait + ns_per_second - 1) / ns_per_second);
 }
 
 void RateLimiter::reset_all() {
-    std::lock_guard<std::mutex> lock(mutex_);
-    global_buckets_.clear();
-    ip_buckets_.clear();
-    key_buckets_.clear();
-    global_buckets_["global"] = {global_requests_per_minute_, std::time(nullptr)};
+    for (auto* stripes : {&ip_stripes_, &key_stripes_}) {
+        for (Stripe& stripe : *stripes) {
+            std::lock_guard<std::mutex> lock(stripe.mutex);
+            stripe.index.clear();
+            stripe.lru.clear();
+            stripe.overflow_tat = 0;
+        }
+    }
+    global_tat_ = 0;
 }
 
 std::string RateLimiter::get_statistics() {
-    std::lock_guard<std::mutex> lock(mutex_);
+    size_t active_ips = 0;
+    size_t active_keys = 0;
+    size_t capacity = 0;
+    for (Stripe& stripe : ip_stripes_) {
+        std::lock_guard<std::mutex> lock(stripe.mutex);
+        active_ips += stripe.lru.size();
+        capacity += stripe.capacity;
+    }
+    for (Stripe& stripe : key_stripes_) {
+        std::lock_guard<std::mutex> lock(stripe.mutex);
+        active_keys += stripe.lru.size();
+    }
 
     std::ostringstream oss;
     oss << "Rate Limiter Statistics:\n";
-    oss << "Global limit: " << global_requests_per_minute_ << " req/min\n";
-    oss << "Per-IP limit: " << per_ip_requests_per_minute_ << " req/min\n";
-    oss << "Per-Key limit: " << per_key_requests_per_minute_ << " req/min\n";
-    oss << "Active IPs: " << ip_buckets_.size() << "\n";
-    oss << "Active API Keys: " << key_buckets_.size() << "\n";
+    oss << "Global limit: " << global_limit_.requests_per_minute << " req/min\n";
+    oss << "Per-IP limit: " << ip_limit_.requests_per_minute << " req/min\n";
+    oss << "Per-Key limit: " << key_limit_.requests_per_minute << " req/min\n";
+    oss << "Active IPs: " << active_ips << " (capacity " << capacity << ")\n";
+    oss << "Active API Keys: " << active_keys << "\n";
+    oss << "Evictions: " << evictions_.load() << "\n";
+    oss << "Overflows: " << overflows_.load() << "\n";
+    oss << "Rejections: " << rejections_.load() << "\n";
 
     return oss.str();
 }
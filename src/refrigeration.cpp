@@ -10,6 +10,7 @@
  */
 
 #include "refrigeration.h"
+#include "metrics.h"
 
 #include <iostream>
 #include <thread>
@@ -19,6 +20,9 @@
 #include <sstream>
 #include <algorithm>
 #include <future>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
 
 void check_sensor_status(float return_temp, float supply_temp, float coil_temp) {
     // Check if any sensor readings are out of bounds
@@ -44,6 +48,7 @@ void update_sensor_thread() {
     std::this_thread::sleep_for(milliseconds(500)); // Wait for system to load
 
     while (running) {
+        auto cycle_start = steady_clock::now();
         float local_return_temp, local_supply_temp, local_coil_temp, local_setpoint;
         std::map<std::string, std::string> local_status;
         if (demo_mode) {
@@ -56,9 +61,18 @@ void update_sensor_thread() {
             supply_temp = std::round(demo.readSupplyTemp() * 10.0f) / 10.0f;
             coil_temp   = std::round(demo.readCoilTemp()   * 10.0f) / 10.0f;
         } else {
-            return_temp = sensors.readSensor(cfg.get("sensor.return"));
-            supply_temp = sensors.readSensor(cfg.get("sensor.supply"));
-            coil_temp   = sensors.readSensor(cfg.get("sensor.coil"));
+            {
+                MetricTimer sensor_timer(MetricHistogram::SensorRead, SensorReturn);
+                return_temp = sensors.readSensor(cfg.get("sensor.return"));
+            }
+            {
+                MetricTimer sensor_timer(MetricHistogram::SensorRead, SensorSupply);
+                supply_temp = sensors.readSensor(cfg.get("sensor.supply"));
+            }
+            {
+                MetricTimer sensor_timer(MetricHistogram::SensorRead, SensorCoil);
+                coil_temp   = sensors.readSensor(cfg.get("sensor.coil"));
+            }
         }
         local_return_temp = return_temp;
         local_supply_temp = supply_temp;
@@ -83,7 +97,18 @@ void update_sensor_thread() {
             last_log_timestamp = time(nullptr);
         }
 
+        runtime_counters.flush_if_due(counter_flush_interval);
+
+        // Record the snapshot this cycle built and stamped, rather than copying the published one back out
+        StateSnapshot cycle_state = publish_state();
+        auto cycle_ns = duration_cast<nanoseconds>(steady_clock::now() - cycle_start).count();
+        flight_recorder->record(cycle_state, anti_timer, pretrip_stage, static_cast<uint32_t>(cycle_ns / 1000));
+        Metrics::observe(MetricHistogram::ControlCycle, cycle_ns);
+
+        auto sleep_start = steady_clock::now();
         std::this_thread::sleep_for(milliseconds(1000));
+        auto overshoot = steady_clock::now() - sleep_start - milliseconds(1000);
+        Metrics::observe(MetricHistogram::ControlJitter, overshoot.count() > 0 ? duration_cast<nanoseconds>(overshoot).count() : 0);
     }
 
     // On thread exit, set all GPIO outputs to safe state
@@ -101,6 +126,7 @@ void update_sensor_thread() {
         gpio.write("electric_heater_pin", true);
     }
     std::this_thread::sleep_for(milliseconds(100)); // Give time for GPIO to settle
+    runtime_counters.flush();
     logger.log_events("Debug", "Sensor thread stopped");
     // Stop API server and join thread
     api.stop();
@@ -153,6 +179,7 @@ void heating_mode() {
 void defrost_mode() {
     state_timer = time(nullptr);
     defrost_start_time  = time(nullptr);
+    runtime_counters.record_defrost();
 
    {
         std::lock_guard<std::mutex> lock(status_mutex);
@@ -181,20 +208,49 @@ void alarm_mode() {
 }
 
 void update_gpio_from_status() {
-    std::lock_guard<std::mutex> lock(status_mutex);
-    if(cfg.get("unit.fan_continuous") == "1" && status["status"] != "Alarm" && status["status"] != "Defrost") {
-        status["fan"] = "True"; // Force fan to be ON in continuous mode
-    }
-    bool relayNO = (cfg.get("unit.relay_active_low") != "0");
-    gpio.write("fan_pin", relayNO ? (status["fan"] == "False") : (status["fan"] == "True"));
-    gpio.write("compressor_pin", relayNO ? (status["compressor"] == "False") : (status["compressor"] == "True"));
-    gpio.write("valve_pin", relayNO ? (status["valve"] == "False") : (status["valve"] == "True"));
-    if ((cfg.get("unit.electric_heat") == "1" ? true : false)) {
-        gpio.write("electric_heater_pin", relayNO ? (status["electric_heater"] == "False") : (status["electric_heater"] == "True"));
-    } else {
-        logger.log_events("Debug", "Electric heater not configured, skipping GPIO update for electric_heater_pin");
+    {
+        std::lock_guard<std::mutex> lock(status_mutex);
+        if(cfg.get("unit.fan_continuous") == "1" && status["status"] != "Alarm" && status["status"] != "Defrost") {
+            status["fan"] = "True"; // Force fan to be ON in continuous mode
+        }
+        bool relayNO = (cfg.get("unit.relay_active_low") != "0");
+        gpio.write("fan_pin", relayNO ? (status["fan"] == "False") : (status["fan"] == "True"));
+        gpio.write("compressor_pin", relayNO ? (status["compressor"] == "False") : (status["compressor"] == "True"));
+        gpio.write("valve_pin", relayNO ? (status["valve"] == "False") : (status["valve"] == "True"));
+        if ((cfg.get("unit.electric_heat") == "1" ? true : false)) {
+            gpio.write("electric_heater_pin", relayNO ? (status["electric_heater"] == "False") : (status["electric_heater"] == "True"));
+        } else {
+            logger.log_events("Debug", "Electric heater not configured, skipping GPIO update for electric_heater_pin");
+        }
+        runtime_counters.update_relays(status["compressor"] == "True", status["fan"] == "True",
+                                       status["valve"] == "True", status["electric_heater"] == "True");
     }
-    update_compressor_on_time(status["compressor"]);
+    // Push mode/relay changes to API listeners right away instead of on the next cycle
+    publish_state();
+}
+
+StateSnapshot publish_state() {
+    StateSnapshot snapshot;
+    {
+        std::lock_guard<std::mutex> lock(status_mutex);
+        snapshot.system_status = status["status"];
+        snapshot.compressor = (status["compressor"] == "True");
+        snapshot.fan = (status["fan"] == "True");
+        snapshot.valve = (status["valve"] == "True");
+        snapshot.electric_heater = (status["electric_heater"] == "True");
+        snapshot.active_alarms = systemAlarm.getAlarmCodes();
+        snapshot.alarm_warning = systemAlarm.getWarningStatus();
+        snapshot.alarm_shutdown = systemAlarm.getShutdownStatus();
+    }
+    snapshot.return_temp = return_temp.load();
+    snapshot.supply_temp = supply_temp.load();
+    snapshot.coil_temp = coil_temp.load();
+    snapshot.setpoint = setpoint.load();
+    snapshot.demo_mode = demo_mode.load();
+    snapshot.pretrip_stage = pretrip_enable ? pretrip_stage.load() : 0;
+    snapshot.timestamp = time(nullptr);
+    state_publisher.publish(snapshot);
+    return snapshot;
 }
 
 void refrigeration_system(float return_temp_, float supply_temp_, float coil_temp_, float setpoint_) {
@@ -262,20 +318,6 @@ void refrigeration_system(float return_temp_, float supply_temp_, float coil_tem
     }
 }
 
-void update_compressor_on_time(const std::string& new_status) {
-    if (last_compressor_status == "False" && new_status == "True") {
-        // Compressor just turned ON
-        compressor_on_start_time = time(nullptr);
-    } else if (last_compressor_status == "True" && new_status == "False") {
-        // Compressor just turned OFF
-        time_t now = time(nullptr);
-        compressor_on_total_seconds += (now - compressor_on_start_time);
-        cfg.update("unit.compressor_run_seconds", std::to_string(compressor_on_total_seconds));
-        compressor_on_start_time = 0;
-    }
-    last_compressor_status = new_status;
-}
-
 void display_system_thread() {
     float return_temp_;
     float supply_temp_;
@@ -304,6 +346,7 @@ void display_system_thread() {
         }
 
         try {
+            MetricTimer frame_timer(MetricHistogram::LcdFrame);
             if (anti_timer) {
                 display1.display("Status: " + status_ + " AC", 0);
             } else {
@@ -350,13 +393,8 @@ void display_system_thread() {
             std::string ap_ip = wifi_manager.get_ip_address("wlan0_ap");
             if (ap_ip == "xxx.xxx.xxx.xxx") {
                 // Display compressor run seconds as HH:MM
-                int run_seconds = 0;
-                try {
-                    run_seconds = std::stoi(cfg.get("unit.compressor_run_seconds"));
-                } catch (...) {
-                    run_seconds = 0;
-                }
-                int ch = run_seconds / 3600;
+                long run_seconds = static_cast<long>(runtime_counters.values().run_seconds[static_cast<int>(CounterRelay::Compressor)]);
+                long ch = run_seconds / 3600;
                 int cm = (run_seconds % 3600) / 60;
                 std::stringstream css;
                 css << "Run Hours: ";
@@ -777,6 +815,25 @@ void api_system_thread() {
     logger.log_events("Error", "API api_system_thread Stopped");
 }
 
+void log_maintenance_thread() {
+    // Idle I/O class and lowest CPU priority for this thread only, so compressing a day of
+    // logs never delays sensor reads or log writes. ioprio_set has no glibc wrapper.
+    constexpr int ioprio_who_process = 1;
+    constexpr int ioprio_class_idle = 3;
+    constexpr int ioprio_class_shift = 13;
+    pid_t tid = static_cast<pid_t>(syscall(SYS_gettid));
+    if (syscall(SYS_ioprio_set, ioprio_who_process, tid, ioprio_class_idle << ioprio_class_shift) != 0) {
+        logger.log_events("Debug", "Log maintenance: ioprio_set failed, running at normal I/O priority");
+    }
+    setpriority(PRIO_PROCESS, static_cast<id_t>(tid), 19);
+
+    while (running) {
+        uint64_t max_total_bytes = static_cast<uint64_t>(std::max(0, stoi(cfg.get("logging.max_total_mb")))) * 1024 * 1024;
+        logger.maintain_logs(stoi(cfg.get("logging.retention_period")), max_total_bytes);
+        interruptible_sleep(log_maintenance_interval);
+    }
+}
+
 void interruptible_sleep(int total_seconds) {
     for (int i = 0; i < total_seconds && running; ++i) {
         std::this_thread::sleep_for(std::chrono::seconds(1));
@@ -841,6 +898,11 @@ int main(int argc, char* argv[]) {
 
 
 
+            // Sized from the config, so it's opened here rather than during static initialization
+            int recorder_hours = std::max(0, std::stoi(cfg.get("logging.flight_recorder_hours")));
+            flight_recorder = std::make_unique<FlightRecorder>("/var/lib/refrigeration/flight.rec",
+                                                               static_cast<size_t>(recorder_hours) * 3600);
+
             std::thread refrigeration_thread = start_thread(update_sensor_thread, "refrigeration_thread");
             std::thread setpoint_thread = start_thread(setpoint_system_thread, "setpoint_thread");
             std::thread display_system = start_thread(display_system_thread, "display_system_thread");
@@ -848,6 +910,7 @@ int main(int argc, char* argv[]) {
             std::thread button_system = start_thread(button_system_thread, "button_system_thread");
             std::thread alarm_system = start_thread(checkAlarms_system, "alarm_system_thread");
             std::thread api_system = start_thread(api_system_thread, "api_system_thread");
+            std::thread log_maintenance = start_thread(log_maintenance_thread, "log_maintenance_thread");
             std::thread hotspot_system(hotspot_start); // Hotspot: do not restart
 
 
@@ -859,8 +922,7 @@ int main(int argc, char* argv[]) {
             hotspot_system.join();
             alarm_system.join();
             api_system.join();
-
-            logger.clear_old_logs((stoi(cfg.get("logging.retention_period"))));
+            log_maintenance.join();
         }
     } catch (const std::exception& e) {
         std::cerr << "Error: " << e.what() << std::endl;
@@ -8,22 +8,37 @@
 #include "config_manager.h"
 #include "config_validator.h"
 #include "alarm.h"
+#include "runtime_counters.h"
 #include "ssl_utils.h"
+#include "metrics.h"
+#include "request_trace.h"
+#include "condition_history.h"
+#include "gzip_util.h"
+#include "flight_recorder.h"
 #include <iostream>
 #include <fstream>
 #include <sstream>
 #include <algorithm>
 #include <thread>
 #include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <set>
+#include <unordered_map>
 #include <atomic>
 #include <cstring>
 #include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
 #include <netinet/in.h>
 #include <arpa/inet.h>
 #include <unistd.h>
 #include <ctime>
 #include <iomanip>
 #include <cerrno>
+#include <cmath>
+#include <csignal>
 
 // Forward declarations - these globals are defined in refrigeration.cpp
 extern std::atomic<float> return_temp;
@@ -34,16 +49,163 @@ extern std::map<std::string, std::string> status;
 extern std::mutex status_mutex;
 extern bool trigger_defrost;
 extern std::atomic<bool> demo_mode;
+extern StatePublisher state_publisher;
+extern StateSnapshot publish_state();
 
 extern Alarm systemAlarm;  // Forward declare global alarm system
+extern RuntimeCounters runtime_counters;
+extern std::unique_ptr<FlightRecorder> flight_recorder;
+
+// Server-Sent Events tuning
+static constexpr int stream_heartbeat_seconds = 15;
+static constexpr float stream_temp_threshold = 0.5f;  // Degrees F a temperature must move before it is pushed
+
+// Used when api.key is missing from the config
+static const char* const default_api_key = "refrigeration-api-default-key-change-me";
+
+// Longest a ?wait=<version> status request is held open
+static constexpr int status_long_poll_seconds = 30;
+
+// History queries: default bucket count and the longest range a query may cover
+static constexpr int history_default_buckets = 288;
+static constexpr std::time_t history_max_range_seconds = 366 * 24 * 3600;
+static constexpr int16_t history_missing_value = INT16_MIN;  // Empty bucket in packed binary columns
+static constexpr int flight_default_before_seconds = 15 * 60;  // Flight recorder window around an alarm
+static constexpr int flight_default_after_seconds = 5 * 60;
+static constexpr std::time_t flight_max_range_seconds = 6 * 3600;
+
+// Response encoding the client asked for; the earliest supported type in Accept wins
+static BodyFormat negotiate_format(const std::string& accept) {
+    BodyFormat format = BodyFormat::Json;
+    size_t best = accept.find("application/json");
+    auto consider = [&](const char* type, BodyFormat candidate) {
+        size_t pos = accept.find(type);
+        if (pos < best) {
+            best = pos;
+            format = candidate;
+        }
+    };
+    consider("application/cbor", BodyFormat::Cbor);
+    consider("application/msgpack", BodyFormat::MsgPack);
+    consider("application/x-msgpack", BodyFormat::MsgPack);
+    return format;
+}
+
+static const char* format_content_type(BodyFormat format) {
+    switch (format) {
+        case BodyFormat::Cbor: return "application/cbor";
+        case BodyFormat::MsgPack: return "application/msgpack";
+        default: return "application/json";
+    }
+}
+
+static std::string encode_body(const json& body, BodyFormat format) {
+    std::string encoded;
+    switch (format) {
+        case BodyFormat::Cbor:
+            json::to_cbor(body, encoded);
+            break;
+        case BodyFormat::MsgPack:
+            json::to_msgpack(body, encoded);
+            break;
+        default:
+            encoded = body.dump();
+            break;
+    }
+    return encoded;
+}
+
+// JSON bodies smaller than this aren't worth gzipping
+static constexpr size_t gzip_min_body_bytes = 1024;
+
+// Gzip a response body in place if the client accepts it and it is large enough to matter
+static bool gzip_body_if_accepted(std::string& body, const std::string& accept_encoding) {
+    if (body.length() < gzip_min_body_bytes || !accepts_gzip(accept_encoding)) {
+        return false;
+    }
+    body = gzip_compress(body);
+    return true;
+}
+
+// 200 response carrying json in the negotiated format, gzipped when it pays off
+static std::string encoded_response(const json& response, BodyFormat format, const std::string& accept_encoding) {
+    std::string body = encode_body(response, format);
+    bool gzipped = gzip_body_if_accepted(body, accept_encoding);
+    std::string http_response = "HTTP/1.1 200 OK\r\n";
+    http_response += "Content-Type: " + std::string(format_content_type(format)) + "\r\n";
+    if (gzipped) {
+        http_response += "Content-Encoding: gzip\r\n";
+    }
+    http_response += "Vary: Accept, Accept-Encoding\r\n";
+    http_response += "Content-Length: " + std::to_string(body.length()) + "\r\n";
+    http_response += "Access-Control-Allow-Origin: *\r\n";
+    http_response += "Connection: close\r\n";
+    http_response += "\r\n";
+    http_response += body;
+    return http_response;
+}
+
+// Value of name=... in a query string, empty if absent
+static std::string query_param(const std::string& query_string, const std::string& name) {
+    size_t pos = 0;
+    while (pos < query_string.length()) {
+        size_t end = query_string.find('&', pos);
+        if (end == std::string::npos) end = query_string.length();
+        if (query_string.compare(pos, name.length(), name) == 0 && pos + name.length() < end &&
+            query_string[pos + name.length()] == '=') {
+            return query_string.substr(pos + name.length() + 1, end - pos - name.length() - 1);
+        }
+        pos = end + 1;
+    }
+    return "";
+}
+
+// Niceness of API worker threads, so request load can't delay the control loop
+static constexpr int api_worker_nice = 10;
+
+// Retry-After sent with 503 when a connection is turned away
+static constexpr int overload_retry_after_seconds = 2;
+
+// Longest a TLS connection waits for a handshake slot before it is dropped
+static constexpr int handshake_wait_seconds = 5;
+
+// 503 sent when a connection or a stream is turned away at a limit
+static const std::string& server_busy_response() {
+    static const std::string body = "{\"error\":\"Server busy\"}";
+    static const std::string response =
+        "HTTP/1.1 503 Service Unavailable\r\n"
+        "Content-Type: application/json\r\n"
+        "Content-Length: " + std::to_string(body.length()) + "\r\n"
+        "Retry-After: " + std::to_string(overload_retry_after_seconds) + "\r\n"
+        "Access-Control-Allow-Origin: *\r\n"
+        "Connection: close\r\n"
+        "\r\n" + body;
+    return response;
+}
+
+// Limits checked before a connection is given a worker
+struct AdmissionLimits {
+    int max_connections = 16;   // Worker threads, each serving one connection at a time
+    int max_queued = 32;        // Accepted connections waiting for a free worker
+    int max_handshakes = 4;     // TLS handshakes in progress at once
+    int max_per_ip = 8;         // Queued plus active connections from one address
+    int max_streams = 8;        // Workers held by event streams and long-polls; the rest stay free for short requests
+};
 
 // Simple HTTP Server implementation
 class HTTPServer {
 public:
-    using RequestHandler = std::function<std::string(const std::string&, const std::string&)>;
-
-    HTTPServer(int port, Logger* logger = nullptr, SSL_CTX* ssl_ctx = nullptr)
-        : port_(port), running_(false), server_fd_(-1), logger_(logger), ssl_ctx_(ssl_ctx) {}
+    using StreamWriter = std::function<bool(const std::string&)>;
+    // Handlers return the full response, or an empty string if they already wrote it through the writer
+    using RequestHandler = std::function<std::string(const std::string&, const std::string&, const StreamWriter&)>;
+
+    HTTPServer(int port, const AdmissionLimits& limits, Logger* logger = nullptr, SSL_CTX* ssl_ctx = nullptr,
+               RequestTracer* tracer = nullptr)
+        : port_(port), running_(false), server_fd_(-1), logger_(logger), ssl_ctx_(ssl_ctx), tracer_(tracer),
+          limits_(limits), active_(0), long_lived_(0), handshakes_(0) {
+        // A stream never takes the last worker
+        limits_.max_streams = std::max(0, std::min(limits_.max_streams, limits_.max_connections - 1));
+    }
 
     ~HTTPServer() {
         if (running_) stop();
@@ -53,6 +215,9 @@ public:
         running_ = true;
         handler_ = handler;
 
+        // Streaming clients can disappear mid-write; report that as a write error instead of a signal
+        std::signal(SIGPIPE, SIG_IGN);
+
         server_fd_ = socket(AF_INET, SOCK_STREAM, 0);
         if (server_fd_ < 0) {
             if (logger_) {
@@ -77,7 +242,7 @@ public:
             return;
         }
 
-        if (listen(server_fd_, 10) < 0) {
+        if (listen(server_fd_, limits_.max_queued) < 0) {
             if (logger_) {
                 logger_->log_events("Error", "Failed to listen on HTTP socket");
             }
@@ -86,14 +251,28 @@ public:
         }
 
         if (logger_) {
-            logger_->log_events("Debug", "HTTP Server listening on port " + std::to_string(port_));
+            logger_->log_events("Debug", "HTTP Server listening on port " + std::to_string(port_) +
+                                " (" + std::to_string(limits_.max_connections) + " workers, queue " +
+                                std::to_string(limits_.max_queued) + ", streams " +
+                                std::to_string(limits_.max_streams) + ")");
+        }
+
+        for (int i = 0; i < limits_.max_connections; ++i) {
+            workers_.emplace_back([this]() { worker_loop(); });
         }
 
         accept_loop();
+
+        queue_cv_.notify_all();
+        for (std::thread& worker : workers_) {
+            worker.join();
+        }
+        workers_.clear();
     }
 
     void stop() {
         running_ = false;
+        queue_cv_.notify_all();
         if (server_fd_ != -1) {
             shutdown(server_fd_, SHUT_RDWR);
             close(server_fd_);
@@ -101,13 +280,53 @@ public:
         }
     }
 
+    /**
+     * Claim one of the workers set aside for requests that stay open (event streams, long-polls).
+     * Returns false when all of them are taken; the caller answers with server_busy_response().
+     */
+    bool begin_long_lived() {
+        std::lock_guard<std::mutex> lock(queue_mutex_);
+        if (long_lived_ >= limits_.max_streams) {
+            Metrics::increment(MetricCounter::AdmissionRejections);
+            return false;
+        }
+        long_lived_++;
+        return true;
+    }
+
+    void end_long_lived() {
+        std::lock_guard<std::mutex> lock(queue_mutex_);
+        long_lived_--;
+    }
+
 private:
+    struct PendingConnection {
+        int fd;
+        uint32_t ip;
+        std::chrono::steady_clock::time_point accepted;
+    };
+
     int port_;
-    bool running_;
+    std::atomic<bool> running_;
     int server_fd_;
     Logger* logger_;
     SSL_CTX* ssl_ctx_;
+    RequestTracer* tracer_;
     RequestHandler handler_;
+    AdmissionLimits limits_;
+
+    // Accepted connections waiting for a worker, and per-address counts of queued plus active ones
+    std::mutex queue_mutex_;
+    std::condition_variable queue_cv_;
+    std::deque<PendingConnection> queue_;
+    std::unordered_map<uint32_t, int> per_ip_;
+    int active_;
+    int long_lived_;                        // Workers inside begin/end_long_lived()
+    std::vector<std::thread> workers_;
+
+    std::mutex handshake_mutex_;
+    std::condition_variable handshake_cv_;
+    int handshakes_;
 
     void accept_loop() {
         while (running_) {
@@ -117,13 +336,82 @@ private:
             int client_fd = accept(server_fd_, (struct sockaddr*)&client_addr, &client_len);
             if (client_fd < 0) continue;
 
-            std::thread([this, client_fd]() {
-                handle_client(client_fd);
-            }).detach();
+            PendingConnection conn{client_fd, client_addr.sin_addr.s_addr, std::chrono::steady_clock::now()};
+            if (!admit(conn)) {
+                reject(client_fd);
+            }
+        }
+    }
+
+    bool admit(const PendingConnection& conn) {
+        {
+            std::lock_guard<std::mutex> lock(queue_mutex_);
+            // Count queued connections against idle workers too, they just haven't been picked up yet
+            if (active_ + queue_.size() >= static_cast<size_t>(limits_.max_connections + limits_.max_queued)) {
+                return false;
+            }
+            int& from_ip = per_ip_[conn.ip];
+            if (from_ip >= limits_.max_per_ip) {
+                return false;
+            }
+            from_ip++;
+            queue_.push_back(conn);
         }
+        queue_cv_.notify_one();
+        return true;
     }
 
-    void handle_client(int client_fd) {
+    // Turn a connection away without giving it a worker. Plain HTTP clients get a 503 straight
+    // from the accept thread; a TLS client can't be answered without a handshake, which is the
+    // work we are shedding, so it is just closed.
+    void reject(int client_fd) {
+        Metrics::increment(MetricCounter::AdmissionRejections);
+        if (!ssl_ctx_) {
+            const std::string& response = server_busy_response();
+            send(client_fd, response.c_str(), response.length(), MSG_DONTWAIT | MSG_NOSIGNAL);
+            shutdown(client_fd, SHUT_WR);
+        }
+        close(client_fd);
+    }
+
+    void worker_loop() {
+        // Linux applies the nice value to the calling thread only
+        setpriority(PRIO_PROCESS, static_cast<id_t>(syscall(SYS_gettid)), api_worker_nice);
+
+        while (true) {
+            PendingConnection conn;
+            {
+                std::unique_lock<std::mutex> lock(queue_mutex_);
+                queue_cv_.wait(lock, [this]() { return !running_ || !queue_.empty(); });
+                if (queue_.empty()) {
+                    return;
+                }
+                conn = queue_.front();
+                queue_.pop_front();
+                active_++;
+            }
+
+            if (running_) {
+                handle_client(conn.fd, conn.accepted);
+            } else {
+                close(conn.fd);
+            }
+
+            std::lock_guard<std::mutex> lock(queue_mutex_);
+            active_--;
+            auto it = per_ip_.find(conn.ip);
+            if (it != per_ip_.end() && --it->second <= 0) {
+                per_ip_.erase(it);
+            }
+        }
+    }
+
+    void handle_client(int client_fd, std::chrono::steady_clock::time_point accepted) {
+        RequestTrace trace;
+        if (tracer_) {
+            tracer_->begin(trace, accepted);
+        }
+
         // Set read timeout (5 seconds)
         struct timeval tv;
         tv.tv_sec = 5;
@@ -139,11 +427,42 @@ private:
                 return;
             }
             SSL_set_fd(ssl, client_fd);
-            if (SSL_accept(ssl) <= 0) {
+
+            // Handshakes are the expensive part of a connection; only a few run at once.
+            // A client still waiting after handshake_wait_seconds has likely given up anyway.
+            {
+                std::unique_lock<std::mutex> lock(handshake_mutex_);
+                if (!handshake_cv_.wait_for(lock, std::chrono::seconds(handshake_wait_seconds),
+                                            [this]() { return handshakes_ < limits_.max_handshakes; })) {
+                    lock.unlock();
+                    Metrics::increment(MetricCounter::AdmissionRejections);
+                    RequestTracer::discard();
+                    finish_trace(trace, 0);
+                    SSL_free(ssl);
+                    close(client_fd);
+                    return;
+                }
+                handshakes_++;
+            }
+            int handshake_result;
+            {
+                MetricTimer handshake_timer(MetricHistogram::TlsHandshake);
+                handshake_result = SSL_accept(ssl);
+            }
+            {
+                std::lock_guard<std::mutex> lock(handshake_mutex_);
+                handshakes_--;
+            }
+            handshake_cv_.notify_one();
+
+            if (handshake_result <= 0) {
+                RequestTracer::discard();
+                finish_trace(trace, 0);
                 SSL_free(ssl);
                 close(client_fd);
                 return;
             }
+            RequestTracer::mark(TracePhase::TlsHandshake);
         }
 
         char buffer[4096] = {0};
@@ -155,12 +474,16 @@ private:
         }
 
         if (bytes_read <= 0) {
+            RequestTracer::discard();
+            finish_trace(trace, 0);
             if (ssl) SSL_free(ssl);
             close(client_fd);
             return;
         }
 
         buffer[bytes_read] = '\0';
+        RequestTracer::mark(TracePhase::Read);
+        RequestTracer::set_request(buffer, bytes_read);
         std::string request(buffer);
 
         // Parse HTTP request for body
@@ -170,29 +493,86 @@ private:
             body = request.substr(body_start + 4);
         }
 
+        // Don't let a stalled client hold a writer forever
+        struct timeval send_tv;
+        send_tv.tv_sec = 10;
+        send_tv.tv_usec = 0;
+        setsockopt(client_fd, SOL_SOCKET, SO_SNDTIMEO, (const char*)&send_tv, sizeof(send_tv));
+
+        StreamWriter writer = [ssl, client_fd](const std::string& data) -> bool {
+            return write_all(ssl, client_fd, data);
+        };
+
         // Pass the full HTTP request (including headers) to the handler
-        std::string response = handler_(request, body);
+        std::string response = handler_(request, body, writer);
+        RequestTracer::mark(TracePhase::Handler);
 
         // Send HTTP response
-        if (ssl) {
-            SSL_write(ssl, response.c_str(), response.length());
-        } else {
-            send(client_fd, response.c_str(), response.length(), 0);
+        if (!response.empty()) {
+            write_all(ssl, client_fd, response);
         }
+        RequestTracer::mark(TracePhase::Write);
+        finish_trace(trace, response_status(response));
 
         if (ssl) SSL_free(ssl);
         close(client_fd);
     }
+
+    void finish_trace(RequestTrace& trace, int status) {
+        if (tracer_ && tracer_->finish(trace, status) && logger_) {
+            logger_->log_events("Info", "API: Slow request " + RequestTracer::describe(trace));
+        }
+    }
+
+    // Status code from "HTTP/1.1 200 OK", 0 if the handler wrote the response itself
+    static int response_status(const std::string& response) {
+        if (response.length() < 12 || response.compare(0, 5, "HTTP/") != 0) {
+            return 0;
+        }
+        return std::atoi(response.c_str() + 9);
+    }
+
+    static bool write_all(SSL* ssl, int client_fd, const std::string& data) {
+        size_t sent = 0;
+        while (sent < data.length()) {
+            int n;
+            if (ssl) {
+                n = SSL_write(ssl, data.c_str() + sent, data.length() - sent);
+            } else {
+                n = send(client_fd, data.c_str() + sent, data.length() - sent, MSG_NOSIGNAL);
+            }
+            if (n <= 0) return false;
+            sent += n;
+        }
+        return true;
+    }
 };
 
-RefrigerationAPI::RefrigerationAPI(int port, const std::string& config_file, Logger* logger,
+// One of the server's long-lived workers, held until the stream or long-poll returns
+class LongLivedSlot {
+public:
+    explicit LongLivedSlot(HTTPServer* server) : server_(server), held_(server->begin_long_lived()) {}
+    ~LongLivedSlot() {
+        if (held_) server_->end_long_lived();
+    }
+    bool held() const { return held_; }
+
+private:
+    HTTPServer* server_;
+    bool held_;
+};
+
+RefrigerationAPI::RefrigerationAPI(int port, ConfigManager* config, Logger* logger,
                                    bool enable_https, const std::string& cert_file, const std::string& key_file)
-    : port_(port), running_(false), enable_https_(enable_https), config_file_(config_file),
+    : port_(port), running_(false), enable_https_(enable_https), config_(config),
       cert_file_(cert_file), key_file_(key_file), logger_(logger),
       ssl_context_(nullptr, &SSL_CTX_free) {
-    load_api_key();
+    if (logger_ && (config_->get("api.key").empty() || config_->get("api.key") == default_api_key)) {
+        logger_->log_events("Error", "Using default API key. Update 'api.key' in config for production!");
+    }
     // Initialize rate limiter: 1000 global/min, 100 per-IP/min, 200 per-key/min
     rate_limiter_ = std::make_unique<RateLimiter>(1000, 100, 200);
+    apply_trace_config();
 
     // Initialize SSL context if HTTPS is enabled
     if (enable_https_) {
@@ -213,30 +593,6 @@ RefrigerationAPI::~RefrigerationAPI() {
     stop();
 }
 
-void RefrigerationAPI::load_api_key() {
-    try {
-        ConfigManager config(config_file_);
-        api_key_ = config.get("api.key");
-
-        if (api_key_.empty()) {
-            // Generate default API key if not present
-            api_key_ = "refrigeration-api-default-key-change-me";
-            if (logger_) {
-                logger_->log_events("Error", "Using default API key. Update 'api.key' in config for production!");
-            }
-        } else {
-            if (logger_) {
-                logger_->log_events("Debug", "API key loaded successfully");
-            }
-        }
-    } catch (const std::exception& e) {
-        if (logger_) {
-            logger_->log_events("Error", "Failed to load API key: " + std::string(e.what()));
-        }
-        api_key_ = "refrigeration-api-default-key-change-me";
-    }
-}
-
 std::string RefrigerationAPI::extract_client_ip(const std::string& request) {
     // Try to extract from X-Forwarded-For header (for reverse proxies)
     std::istringstream req_stream(request);
@@ -270,8 +626,63 @@ std::string RefrigerationAPI::extract_client_ip(const std::string& request) {
     return "127.0.0.1";
 }
 
+std::string RefrigerationAPI::extract_header(const std::string& request, const std::string& name) {
+    std::string name_lower = name;
+    std::transform(name_lower.begin(), name_lower.end(), name_lower.begin(), ::tolower);
+
+    std::istringstream req_stream(request);
+    std::string line;
+    std::getline(req_stream, line);  // Skip request line
+    while (std::getline(req_stream, line)) {
+        if (line == "\r" || line.empty()) break;  // End of headers
+        size_t colon = line.find(":");
+        if (colon == std::string::npos) continue;
+        std::string key = line.substr(0, colon);
+        key.erase(0, key.find_first_not_of(" \t"));
+        key.erase(key.find_last_not_of(" \t") + 1);
+        std::transform(key.begin(), key.end(), key.begin(), ::tolower);
+        if (key != name_lower) continue;
+        std::string value = line.substr(colon + 1);
+        value.erase(0, value.find_first_not_of(" \t\r\n"));
+        value.erase(value.find_last_not_of(" \t\r\n") + 1);
+        return value;
+    }
+    return "";
+}
+
+AdmissionLimits RefrigerationAPI::get_admission_limits() {
+    AdmissionLimits limits;
+    auto read_limit = [this](const std::string& key, int fallback) {
+        try {
+            return std::max(1, std::stoi(config_->get(key)));
+        } catch (...) {
+            return fallback;
+        }
+    };
+    limits.max_connections = read_limit("api.max_connections", limits.max_connections);
+    limits.max_queued = read_limit("api.max_queued", limits.max_queued);
+    limits.max_handshakes = read_limit("api.max_handshakes", limits.max_handshakes);
+    limits.max_per_ip = read_limit("api.max_per_ip", limits.max_per_ip);
+    limits.max_streams = read_limit("api.max_streams", limits.max_streams);
+    return limits;
+}
+
+void RefrigerationAPI::apply_trace_config() {
+    tracer_.set_enabled(config_->get("api.trace_enabled") != "0");
+    try {
+        tracer_.set_slow_threshold_ms(std::stoi(config_->get("api.trace_slow_ms")));
+    } catch (...) {
+        tracer_.set_slow_threshold_ms(500);
+    }
+}
+
 bool RefrigerationAPI::validate_api_key(const std::string& key) {
-    return !key.empty() && key == api_key_;
+    // Read through the shared config so key changes apply without a restart
+    std::string api_key = config_->get("api.key");
+    if (api_key.empty()) {
+        api_key = default_api_key;
+    }
+    return !key.empty() && key == api_key;
 }
 
 std::string RefrigerationAPI::get_error_response(int code, const std::string& message) {
@@ -337,6 +748,133 @@ json RefrigerationAPI::handle_status_request() {
     return status_response;
 }
 
+json RefrigerationAPI::build_status_json(const StateSnapshot& state) {
+    json status_response;
+    status_response["timestamp"] = state.timestamp;
+    status_response["system"] = "Refrigeration Control System";
+    status_response["version"] = REFRIGERATION_API_VERSION;
+    status_response["relays"] = json::object();
+    status_response["relays"]["compressor"] = state.compressor;
+    status_response["relays"]["fan"] = state.fan;
+    status_response["relays"]["valve"] = state.valve;
+    status_response["relays"]["electric_heater"] = state.electric_heater;
+    status_response["system_status"] = state.system_status;
+    status_response["active_alarms"] = state.active_alarms;
+    status_response["alarm_warning"] = state.alarm_warning;
+    status_response["alarm_shutdown"] = state.alarm_shutdown;
+    status_response["pretrip_stage"] = state.pretrip_stage;
+    status_response["sensors"] = json::object();
+    status_response["sensors"]["return_temp"] = state.return_temp;
+    status_response["sensors"]["supply_temp"] = state.supply_temp;
+    status_response["sensors"]["coil_temp"] = state.coil_temp;
+    status_response["setpoint"] = state.setpoint;
+    return status_response;
+}
+
+std::shared_ptr<const RefrigerationAPI::StatusCache> RefrigerationAPI::get_status_cache() {
+    std::lock_guard<std::mutex> lock(status_cache_mutex_);
+    if (status_cache_ && status_cache_->version == state_publisher.version() &&
+        status_cache_->timestamp == state_publisher.timestamp()) {
+        return status_cache_;
+    }
+
+    // Serialize once per state version, and again when the control loop re-stamps an unchanged
+    // state (about once a second) so the bodies' timestamp stays current. Concurrent requests
+    // wait here and reuse the result.
+    StateSnapshot state = state_publisher.current();
+    auto cache = std::make_shared<StatusCache>();
+    cache->version = state.version;
+    cache->timestamp = state.timestamp;
+    // Weak: bodies of one version differ in their timestamp, so the tag can't promise identical bytes
+    cache->etag = "W/\"" + std::to_string(state_publisher.instance_id()) + "-" + std::to_string(state.version) + "\"";
+
+    json status_json = build_status_json(state);
+    status_json["state_version"] = state.version;
+
+    json relays;
+    relays["compressor"] = state.compressor;
+    relays["fan"] = state.fan;
+    relays["valve"] = state.valve;
+    relays["electric_heater"] = state.electric_heater;
+    relays["timestamp"] = state.timestamp;
+    relays["state_version"] = state.version;
+
+    json sensors;
+    sensors["return_temp"] = state.return_temp;
+    sensors["supply_temp"] = state.supply_temp;
+    sensors["coil_temp"] = state.coil_temp;
+    sensors["setpoint"] = state.setpoint;
+    sensors["timestamp"] = state.timestamp;
+    sensors["state_version"] = state.version;
+
+    for (int f = 0; f < static_cast<int>(BodyFormat::Count); ++f) {
+        cache->status_body[f] = encode_body(status_json, static_cast<BodyFormat>(f));
+        cache->relays_body[f] = encode_body(relays, static_cast<BodyFormat>(f));
+        cache->sensors_body[f] = encode_body(sensors, static_cast<BodyFormat>(f));
+    }
+
+    status_cache_ = cache;
+    return status_cache_;
+}
+
+std::string RefrigerationAPI::handle_cached_status_request(const std::string& request, const std::string& path,
+                                                           const std::string& query_string) {
+    // Long-poll: hold the request while the client already has the current version
+    std::string wait_param = query_param(query_string, "wait");
+    if (!wait_param.empty()) {
+        uint64_t wait_version;
+        try {
+            wait_version = std::stoull(wait_param);
+        } catch (...) {
+            return get_error_response(400, "Invalid 'wait' parameter. Use ?wait=<state_version>");
+        }
+        LongLivedSlot slot(server_.get());
+        if (!slot.held()) {
+            return server_busy_response();
+        }
+        RequestTracer::mark(TracePhase::Handler);
+        state_publisher.wait_for_change(wait_version, std::chrono::seconds(status_long_poll_seconds), &running_);
+        RequestTracer::mark(TracePhase::Wait);
+    }
+
+    std::shared_ptr<const StatusCache> cache = get_status_cache();
+    BodyFormat format = negotiate_format(extract_header(request, "Accept"));
+    int f = static_cast<int>(format);
+    const std::string& body = (path == "/api/v1/relays") ? cache->relays_body[f]
+                            : (path == "/api/v1/sensors") ? cache->sensors_body[f]
+                            : cache->status_body[f];
+
+    // Each encoding is its own representation, so binary bodies get their own ETag
+    std::string etag = cache->etag;
+    if (format != BodyFormat::Json) {
+        etag.insert(etag.length() - 1, format == BodyFormat::Cbor ? "-cbor" : "-msgpack");
+    }
+
+    std::string response;
+    std::string if_none_match = extract_header(request, "If-None-Match");
+    // If-None-Match uses weak comparison, so a tag sent back without the W/ matches too
+    bool not_modified = !if_none_match.empty() && if_none_match.find(etag.substr(2)) != std::string::npos;
+    if (not_modified) {
+        response = "HTTP/1.1 304 Not Modified\r\n";
+    } else {
+        response = "HTTP/1.1 200 OK\r\n";
+        response += "Content-Type: " + std::string(format_content_type(format)) + "\r\n";
+        response += "Content-Length: " + std::to_string(body.length()) + "\r\n";
+    }
+    response += "ETag: " + etag + "\r\n";
+    response += "Vary: Accept\r\n";
+    response += "X-State-Version: " + std::to_string(cache->version) + "\r\n";
+    response += "Cache-Control: no-cache\r\n";
+    response += "Access-Control-Allow-Origin: *\r\n";
+    response += "Access-Control-Expose-Headers: ETag, X-State-Version\r\n";
+    response += "Connection: close\r\n";
+    response += "\r\n";
+    if (!not_modified) {
+        response += body;
+    }
+    return response;
+}
+
 json RefrigerationAPI::handle_relay_status_request() {
     json relays;
 
@@ -396,9 +934,8 @@ json RefrigerationAPI::handle_setpoint_set_request(float new_setpoint) {
     json response;
 
     try {
-        ConfigManager config(config_file_);
-        float min_sp = std::stof(config.get("setpoint.low_limit"));
-        float max_sp = std::stof(config.get("setpoint.high_limit"));
+        float min_sp = std::stof(config_->get("setpoint.low_limit"));
+        float max_sp = std::stof(config_->get("setpoint.high_limit"));
 
         if (new_setpoint < min_sp || new_setpoint > max_sp) {
             response["error"] = true;
@@ -412,7 +949,8 @@ json RefrigerationAPI::handle_setpoint_set_request(float new_setpoint) {
         }
 
         setpoint.store(new_setpoint);
-        config.update("unit.setpoint", std::to_string(static_cast<int>(new_setpoint)));
+        config_->update("unit.setpoint", std::to_string(static_cast<int>(new_setpoint)));
+        publish_state();
 
         response["success"] = true;
         response["setpoint"] = new_setpoint;
@@ -437,6 +975,7 @@ json RefrigerationAPI::handle_alarm_reset_request() {
 
     try {
         systemAlarm.resetAlarm();
+        publish_state();
         // Sleep briefly to allow the alarm reset to take effect
         std::this_thread::sleep_for(std::chrono::milliseconds(200));
 
@@ -486,8 +1025,7 @@ json RefrigerationAPI::handle_demo_mode_request(bool enable) {
 
     try {
         // Check if debug mode is enabled - if it is, block demo mode
-        ConfigManager config(config_file_);
-        std::string debug_code = config.get("debug.code");
+        std::string debug_code = config_->get("debug.code");
 
         if (debug_code == "0") {
             response["success"] = false;
@@ -500,6 +1038,7 @@ json RefrigerationAPI::handle_demo_mode_request(bool enable) {
         // Otherwise allow demo mode change
         bool old_mode = demo_mode.load();
         demo_mode.store(enable);
+        publish_state();
         response["success"] = true;
         response["message"] = enable ? "Demo mode enabled" : "Demo mode disabled";
         response["demo_mode"] = enable;
@@ -524,32 +1063,15 @@ json RefrigerationAPI::handle_system_info_request() {
     json info;
 
     try {
-        ConfigManager config("/etc/refrigeration/config.env");
-
-        // Return all configuration values
-        info["api.key"] = config.get("api.key");
-        info["api.port"] = config.get("api.port");
-        info["compressor.off_timer"] = config.get("compressor.off_timer");
-        info["debug.code"] = config.get("debug.code");
-        info["defrost.coil_temperature"] = config.get("defrost.coil_temperature");
-        info["defrost.interval_hours"] = config.get("defrost.interval_hours");
-        info["defrost.timeout_mins"] = config.get("defrost.timeout_mins");
-        info["logging.interval_mins"] = config.get("logging.interval_mins");
-        info["logging.retention_period"] = config.get("logging.retention_period");
-        info["sensor.coil"] = config.get("sensor.coil");
-        info["sensor.return"] = config.get("sensor.return");
-        info["sensor.supply"] = config.get("sensor.supply");
-        info["setpoint.high_limit"] = config.get("setpoint.high_limit");
-        info["setpoint.low_limit"] = config.get("setpoint.low_limit");
-        info["setpoint.offset"] = config.get("setpoint.offset");
-        info["unit.compressor_run_seconds"] = config.get("unit.compressor_run_seconds");
-        info["unit.electric_heat"] = config.get("unit.electric_heat");
-        info["unit.fan_continuous"] = config.get("unit.fan_continuous");
-        info["unit.number"] = config.get("unit.number");
-        info["unit.relay_active_low"] = config.get("unit.relay_active_low");
-        info["unit.setpoint"] = config.get("unit.setpoint");
-        info["wifi.enable_hotspot"] = config.get("wifi.enable_hotspot");
-        info["wifi.hotspot_password"] = config.get("wifi.hotspot_password");
+        // Return all configuration values from the shared snapshot
+        ConfigSnapshot values = config_->snapshot();
+        for (const auto& [key, entry] : config_->getSchema()) {
+            auto it = values->find(key);
+            info[key] = (it != values->end()) ? it->second : "";
+        }
+        // The stored value only seeds the runtime counters on first start; report the live one
+        info["unit.compressor_run_seconds"] =
+            std::to_string(runtime_counters.values().run_seconds[static_cast<int>(CounterRelay::Compressor)]);
 
         info["timestamp"] = std::time(nullptr);
     } catch (const std::exception& e) {
@@ -562,6 +1084,273 @@ json RefrigerationAPI::handle_system_info_request() {
     return info;
 }
 
+std::string RefrigerationAPI::handle_history_request(const std::string& query_string, BodyFormat format,
+                                                     const std::string& accept_encoding) {
+    std::time_t to;
+    std::time_t from;
+    int step;
+    std::vector<HistoryField> fields;
+    try {
+        std::string to_param = query_param(query_string, "to");
+        std::string from_param = query_param(query_string, "from");
+        std::string step_param = query_param(query_string, "step");
+        to = to_param.empty() ? std::time(nullptr) : static_cast<std::time_t>(std::stoll(to_param));
+        from = from_param.empty() ? to - 24 * 3600 : static_cast<std::time_t>(std::stoll(from_param));
+        step = step_param.empty() ? 0 : std::stoi(step_param);
+    } catch (...) {
+        return get_error_response(400, "Invalid 'from', 'to' or 'step'. Use unix timestamps and seconds");
+    }
+    if (to <= from || to - from > history_max_range_seconds) {
+        return get_error_response(400, "'from' must be before 'to' and the range at most 366 days");
+    }
+    if (step <= 0) {
+        step = std::max<int>(60, static_cast<int>((to - from + history_default_buckets - 1) / history_default_buckets));
+    }
+    if (static_cast<size_t>((to - from + step - 1) / step) > ConditionHistory::max_buckets) {
+        return get_error_response(400, "Too many buckets, use a larger 'step' (at most " +
+                                  std::to_string(ConditionHistory::max_buckets) + " buckets)");
+    }
+
+    std::string field_list = query_param(query_string, "fields");
+    if (field_list.empty()) {
+        field_list = "return,supply,coil,setpoint";
+    }
+    std::istringstream field_stream(field_list);
+    std::string name;
+    while (std::getline(field_stream, name, ',')) {
+        HistoryField field;
+        if (name.empty()) continue;
+        if (!ConditionHistory::parse_field(name, field)) {
+            return get_error_response(400, "Unknown field '" + name + "'");
+        }
+        fields.push_back(field);
+    }
+
+    ConditionHistory history;
+    HistoryResult result = history.query(from, to, step, fields);
+
+    // Columnar: one array per aggregate, indexed by bucket; empty buckets are null.
+    // Binary encodings pack each column into a byte string of little-endian int16
+    // hundredths instead, with history_missing_value for empty buckets.
+    bool packed = format != BodyFormat::Json;
+    auto round2 = [](float value) { return std::round(value * 100.0) / 100.0; };
+    auto column = [&](const std::vector<float>& values, const std::vector<uint32_t>& count) {
+        if (packed) {
+            std::vector<uint8_t> bytes;
+            bytes.reserve(values.size() * 2);
+            for (size_t b = 0; b < values.size(); ++b) {
+                int16_t v = history_missing_value;
+                if (count[b] != 0) {
+                    v = static_cast<int16_t>(std::clamp<long>(std::lround(values[b] * 100.0f), INT16_MIN + 1, INT16_MAX));
+                }
+                bytes.push_back(static_cast<uint8_t>(v & 0xff));
+                bytes.push_back(static_cast<uint8_t>((static_cast<uint16_t>(v) >> 8) & 0xff));
+            }
+            return json::binary(bytes);
+        }
+        json array = json::array();
+        for (size_t b = 0; b < values.size(); ++b) {
+            if (count[b] == 0) {
+                array.push_back(nullptr);
+            } else {
+                array.push_back(round2(values[b]));
+            }
+        }
+        return array;
+    };
+
+    json response;
+    response["from"] = result.from;
+    response["to"] = result.to;
+    response["step"] = result.step;
+    response["buckets"] = result.buckets();
+    if (packed) {
+        response["encoding"] = "int16_le_x100";  // Bucket times are from + i * step
+    } else {
+        json times = json::array();
+        for (size_t b = 0; b < result.buckets(); ++b) {
+            times.push_back(result.from + static_cast<std::time_t>(b) * result.step);
+        }
+        response["time"] = times;
+    }
+    response["samples"] = result.samples;
+    json series = json::object();
+    for (size_t f = 0; f < result.fields.size(); ++f) {
+        json columns;
+        columns["min"] = column(result.min[f], result.count[f]);
+        columns["avg"] = column(result.avg[f], result.count[f]);
+        columns["max"] = column(result.max[f], result.count[f]);
+        series[ConditionHistory::field_name(result.fields[f])] = columns;
+    }
+    response["series"] = series;
+    response["timestamp"] = std::time(nullptr);
+    return encoded_response(response, format, accept_encoding);
+}
+
+std::string RefrigerationAPI::handle_flight_recorder_request(const std::string& query_string, BodyFormat format,
+                                                             const std::string& accept_encoding) {
+    if (!flight_recorder || !flight_recorder->is_recording()) {
+        return get_error_response(404, "Flight recorder is disabled");
+    }
+
+    int alarm = 0;
+    std::time_t center = 0;
+    std::time_t from;
+    std::time_t to;
+    try {
+        std::string alarm_param = query_param(query_string, "alarm");
+        std::string at_param = query_param(query_string, "at");
+        std::string before_param = query_param(query_string, "before");
+        std::string after_param = query_param(query_string, "after");
+        std::string from_param = query_param(query_string, "from");
+        std::string to_param = query_param(query_string, "to");
+        int before = before_param.empty() ? flight_default_before_seconds : std::stoi(before_param);
+        int after = after_param.empty() ? flight_default_after_seconds : std::stoi(after_param);
+
+        if (!alarm_param.empty()) {
+            alarm = std::stoi(alarm_param);
+            center = flight_recorder->find_alarm_onset(alarm);
+            if (center == 0) {
+                return get_error_response(404, "Alarm " + std::to_string(alarm) + " is not in the flight recording");
+            }
+        } else if (!at_param.empty()) {
+            center = static_cast<std::time_t>(std::stoll(at_param));
+        }
+
+        if (!from_param.empty() || !to_param.empty()) {
+            to = to_param.empty() ? std::time(nullptr) + 1 : static_cast<std::time_t>(std::stoll(to_param));
+            from = from_param.empty() ? to - before : static_cast<std::time_t>(std::stoll(from_param));
+        } else if (center != 0) {
+            from = center - before;
+            to = center + after;
+        } else {
+            to = std::time(nullptr) + 1;
+            from = to - before;
+        }
+    } catch (...) {
+        return get_error_response(400, "Invalid 'alarm', 'at', 'before', 'after', 'from' or 'to'");
+    }
+    if (to <= from || to - from > flight_max_range_seconds) {
+        return get_error_response(400, "The window must be non-empty and at most 6 hours");
+    }
+
+    std::vector<FlightRecord> records = flight_recorder->read(from, to);
+
+    // Columnar like /api/v1/history: one array per field, indexed by sample
+    auto temperature = [](int16_t hundredths) -> json {
+        if (hundredths == INT16_MIN) return nullptr;
+        return hundredths / 100.0;
+    };
+    json times = json::array();
+    json return_temps = json::array();
+    json supply_temps = json::array();
+    json coil_temps = json::array();
+    json setpoints = json::array();
+    json modes = json::array();
+    json relays = json::array();
+    json flags = json::array();
+    json pretrip_stages = json::array();
+    json alarms = json::array();
+    json cycle_ms = json::array();
+    for (const FlightRecord& record : records) {
+        times.push_back(record.timestamp);
+        return_temps.push_back(temperature(record.return_temp));
+        supply_temps.push_back(temperature(record.supply_temp));
+        coil_temps.push_back(temperature(record.coil_temp));
+        setpoints.push_back(temperature(record.setpoint));
+        modes.push_back(FlightRecorder::mode_name(record.mode));
+        relays.push_back(record.relays);
+        flags.push_back(record.flags);
+        pretrip_stages.push_back(record.pretrip_stage);
+        alarms.push_back(FlightRecorder::decode_alarms(record.alarms));
+        cycle_ms.push_back(std::round(record.cycle_us / 100.0) / 10.0);
+    }
+
+    json response;
+    response["from"] = from;
+    response["to"] = to;
+    if (alarm != 0) {
+        response["alarm"] = alarm;
+        response["alarm_time"] = center;
+    }
+    std::time_t oldest;
+    std::time_t newest;
+    if (flight_recorder->span(oldest, newest)) {
+        response["recorded_from"] = oldest;
+        response["recorded_to"] = newest;
+    }
+    response["count"] = records.size();
+    response["time"] = times;
+    response["return"] = return_temps;
+    response["supply"] = supply_temps;
+    response["coil"] = coil_temps;
+    response["setpoint"] = setpoints;
+    response["mode"] = modes;
+    response["relays"] = relays;
+    response["relay_bits"] = {{"compressor", FlightCompressor}, {"fan", FlightFan},
+                              {"valve", FlightValve}, {"electric_heater", FlightElectricHeater}};
+    response["flags"] = flags;
+    response["flag_bits"] = {{"anti_cycle", FlightAntiCycle}, {"warning", FlightWarning},
+                             {"shutdown", FlightShutdown}, {"demo", FlightDemo}};
+    response["pretrip_stage"] = pretrip_stages;
+    response["alarms"] = alarms;
+    response["cycle_ms"] = cycle_ms;
+    response["timestamp"] = std::time(nullptr);
+    return encoded_response(response, format, accept_encoding);
+}
+
+json RefrigerationAPI::handle_snapshot_request(const std::set<std::string>& fields) {
+    json snapshot;
+
+    // Status and demo mode come from the same published state so they always agree
+    StateSnapshot state = state_publisher.current();
+    bool published = state.version != 0;
+    if (published) {
+        snapshot["state_version"] = state.version;
+    }
+
+    if (fields.count("status")) {
+        snapshot["status"] = published ? build_status_json(state) : handle_status_request();
+        snapshot["status"].erase("timestamp");
+    }
+    if (fields.count("demo")) {
+        snapshot["demo_mode"] = published ? state.demo_mode : demo_mode.load();
+    }
+    if (fields.count("config")) {
+        snapshot["config"] = handle_system_info_request();
+        snapshot["config"].erase("timestamp");
+    }
+    if (fields.count("counters")) {
+        snapshot["counters"] = handle_counters_request();
+        snapshot["counters"].erase("timestamp");
+    }
+
+    return snapshot;
+}
+
+json RefrigerationAPI::handle_counters_request() {
+    json counters;
+    CounterValues values = runtime_counters.values();
+
+    auto relay_json = [&values](CounterRelay relay) {
+        json entry;
+        entry["run_seconds"] = values.run_seconds[static_cast<int>(relay)];
+        entry["run_hours"] = std::round(values.run_seconds[static_cast<int>(relay)] / 36.0) / 100.0;
+        entry["starts"] = values.starts[static_cast<int>(relay)];
+        return entry;
+    };
+    counters["compressor"] = relay_json(CounterRelay::Compressor);
+    counters["fan"] = relay_json(CounterRelay::Fan);
+    counters["valve"] = relay_json(CounterRelay::Valve);
+    counters["electric_heater"] = relay_json(CounterRelay::ElectricHeater);
+    counters["defrost_count"] = values.defrost_count;
+    counters["compressor_starts_last_hour"] = runtime_counters.compressor_starts_last_hour();
+    counters["persistent"] = runtime_counters.is_persistent();
+    counters["timestamp"] = std::time(nullptr);
+
+    return counters;
+}
+
 json RefrigerationAPI::handle_config_update_request(const json& config_updates) {
     json response;
 
@@ -570,12 +1359,11 @@ json RefrigerationAPI::handle_config_update_request(const json& config_updates)
     }
 
     try {
-        ConfigManager config(config_file_);
-
         // Track what was updated
         json updated_items;
         json skipped_items;
         json errors;
+        std::map<std::string, std::string> batch;
 
         // Iterate through all provided updates
         for (auto& [key, value] : config_updates.items()) {
@@ -606,23 +1394,15 @@ json RefrigerationAPI::handle_config_update_request(const json& config_updates)
                     str_value = value.get<std::string>();
                 }
 
-                // Validate using ConfigValidator
-                ConfigValidator validator;
-                if (!validator.validate(key, str_value)) {
+                // Validate against the schema; valid items are saved together below
+                if (!config_->isValid(key, str_value)) {
                     errors[key] = "Invalid value or key not found in schema";
                     if (logger_) {
                         logger_->log_events("Error", "API: Validation failed for " + key + " = " + str_value);
                     }
                     continue;
                 }
-
-                // Update the config
-                config.update(key, str_value);
-                updated_items[key] = str_value;
-
-                if (logger_) {
-                    logger_->log_events("Debug", "API: Config updated - " + key + " = " + str_value);
-                }
+                batch[key] = str_value;
             } catch (const std::exception& e) {
                 errors[key] = e.what();
                 if (logger_) {
@@ -631,10 +1411,31 @@ json RefrigerationAPI::handle_config_update_request(const json& config_updates)
             }
         }
 
-        // Save config if there were successful updates
+        // Save all valid items with a single config write
+        if (!batch.empty()) {
+            if (config_->transaction(batch)) {
+                for (const auto& [key, value] : batch) {
+                    updated_items[key] = value;
+                    if (logger_) {
+                        logger_->log_events("Debug", "API: Config updated - " + key + " = " + value);
+                    }
+                }
+            } else {
+                for (const auto& [key, value] : batch) {
+                    errors[key] = "Failed to save config";
+                }
+                if (logger_) {
+                    logger_->log_events("Error", "API: Failed to save config update");
+                }
+            }
+        }
+
         if (!updated_items.empty()) {
             response["success"] = true;
             response["updated"] = updated_items;
+            if (updated_items.contains("api.trace_enabled") || updated_items.contains("api.trace_slow_ms")) {
+                apply_trace_config();
+            }
 
             if (logger_) {
                 logger_->log_events("Debug", "API: Config file saved successfully");
@@ -665,7 +1466,8 @@ json RefrigerationAPI::handle_config_update_request(const json& config_updates)
     return response;
 }
 
-std::string RefrigerationAPI::handle_download_events_request(const std::string& date) {
+std::string RefrigerationAPI::handle_download_events_request(const std::string& date, const std::string& request,
+                                                             const StreamWriter& write) {
     try {
         // Validate date format (YYYY-MM-DD)
         if (date.length() != 10 || date[4] != '-' || date[7] != '-') {
@@ -677,31 +1479,15 @@ std::string RefrigerationAPI::handle_download_events_request(const std::string&
 
         std::string log_file_path = "/var/log/refrigeration/events-" + date + ".log";
 
-        // Check if file exists
-        std::ifstream log_file(log_file_path);
-        if (!log_file.is_open()) {
+        // Check if file exists, either as written or compressed by log maintenance
+        if (access(log_file_path.c_str(), R_OK) != 0 && access((log_file_path + ".gz").c_str(), R_OK) != 0) {
             if (logger_) {
                 logger_->log_events("Debug", "API: Events log file not found: " + log_file_path);
             }
             return "HTTP/1.1 404 Not Found\r\nContent-Type: application/json\r\n\r\n{\"error\": \"Log file not found for date: " + date + "\"}";
         }
 
-        // Read entire file
-        std::stringstream buffer;
-        buffer << log_file.rdbuf();
-        log_file.close();
-        std::string file_content = buffer.str();
-
-        // Return file with proper headers
-        std::string response = "HTTP/1.1 200 OK\r\n";
-        response += "Content-Type: text/plain\r\n";
-        response += "Content-Disposition: attachment; filename=\"events-" + date + ".log\"\r\n";
-        response += "Content-Length: " + std::to_string(file_content.length()) + "\r\n";
-        response += "Connection: close\r\n";
-        response += "\r\n";
-        response += file_content;
-
-        return response;
+        return send_log_file(log_file_path, "events-" + date + ".log", request, write);
     } catch (const std::exception& e) {
         if (logger_) {
             logger_->log_events("Error", "API: Exception downloading events - " + std::string(e.what()));
@@ -710,7 +1496,94 @@ std::string RefrigerationAPI::handle_download_events_request(const std::string&
     }
 }
 
-std::string RefrigerationAPI::handle_download_conditions_request(const std::string& date) {
+std::string RefrigerationAPI::send_log_file(const std::string& path, const std::string& filename,
+                                            const std::string& request, const StreamWriter& write) {
+    std::string headers = "HTTP/1.1 200 OK\r\n";
+    headers += "Content-Type: text/plain\r\n";
+    headers += "Content-Disposition: attachment; filename=\"" + filename + "\"\r\n";
+    headers += "Vary: Accept-Encoding\r\n";
+
+    auto read_file = [](const std::string& file_path) {
+        std::ifstream file(file_path, std::ios::binary);
+        std::stringstream buffer;
+        buffer << file.rdbuf();
+        return buffer.str();
+    };
+
+    bool gzip = accepts_gzip(extract_header(request, "Accept-Encoding"));
+    struct stat log_stat;
+    if (stat(path.c_str(), &log_stat) != 0) {
+        // Log maintenance compressed this day and removed the original
+        std::string gz_path = path + ".gz";
+        if (gzip) {
+            std::string compressed = read_file(gz_path);
+            return headers + "Content-Encoding: gzip\r\n" +
+                   "Content-Length: " + std::to_string(compressed.length()) + "\r\n" +
+                   "Connection: close\r\n\r\n" + compressed;
+        }
+        gzFile compressed = gzopen(gz_path.c_str(), "rb");
+        if (!compressed) {
+            return get_error_response(404, "Log file not found");
+        }
+        if (write(headers + "Connection: close\r\n\r\n")) {
+            char buffer[16384];
+            int count;
+            while ((count = gzread(compressed, buffer, sizeof(buffer))) > 0 &&
+                   write(std::string(buffer, static_cast<size_t>(count)))) {
+            }
+        }
+        gzclose(compressed);
+        return "";
+    }
+
+    if (!gzip) {
+        std::string file_content = read_file(path);
+        return headers + "Content-Length: " + std::to_string(file_content.length()) + "\r\n" +
+               "Connection: close\r\n\r\n" + file_content;
+    }
+
+    // Days before today are no longer written, so compress them once and reuse the .gz
+    std::time_t now = std::time(nullptr);
+    std::tm midnight;
+    localtime_r(&now, &midnight);
+    midnight.tm_hour = 0;
+    midnight.tm_min = 0;
+    midnight.tm_sec = 0;
+    bool rotated = log_stat.st_mtime < std::mktime(&midnight);
+
+    // Log maintenance compresses these too, so go through the same per-file lock. If it holds the
+    // lock right now, or the .gz is gone by the time it is read, stream-compress instead.
+    if (rotated && logger_ && logger_->compress_log(path)) {
+        std::string compressed = read_file(path + ".gz");
+        if (!compressed.empty()) {
+            return headers + "Content-Encoding: gzip\r\n" +
+                   "Content-Length: " + std::to_string(compressed.length()) + "\r\n" +
+                   "Connection: close\r\n\r\n" + compressed;
+        }
+    }
+
+    // Today's file is still growing (or no .gz was available): compress while sending, the connection close ends the body
+    std::ifstream log_file(path, std::ios::binary);
+    if (!write(headers + "Content-Encoding: gzip\r\nConnection: close\r\n\r\n")) {
+        return "";
+    }
+    GzipStream encoder;
+    char buffer[16384];
+    while (log_file) {
+        log_file.read(buffer, sizeof(buffer));
+        std::streamsize count = log_file.gcount();
+        if (count <= 0) break;
+        std::string chunk = encoder.write(buffer, static_cast<size_t>(count));
+        if (!chunk.empty() && !write(chunk)) {
+            return "";
+        }
+    }
+    write(encoder.finish());
+    return "";
+}
+
+std::string RefrigerationAPI::handle_download_conditions_request(const std::string& date, const std::string& request,
+                                                                 const StreamWriter& write) {
     try {
         // Validate date format (YYYY-MM-DD)
         if (date.length() != 10 || date[4] != '-' || date[7] != '-') {
@@ -722,31 +1595,15 @@ std::string RefrigerationAPI::handle_download_conditions_request(const std::stri
 
         std::string log_file_path = "/var/log/refrigeration/conditions-" + date + ".log";
 
-        // Check if file exists
-        std::ifstream log_file(log_file_path);
-        if (!log_file.is_open()) {
+        // Check if file exists, either as written or compressed by log maintenance
+        if (access(log_file_path.c_str(), R_OK) != 0 && access((log_file_path + ".gz").c_str(), R_OK) != 0) {
             if (logger_) {
                 logger_->log_events("Error", "API: Conditions log file not found: " + log_file_path);
             }
             return "HTTP/1.1 404 Not Found\r\nContent-Type: application/json\r\n\r\n{\"error\": \"Log file not found for date: " + date + "\"}";
         }
 
-        // Read entire file
-        std::stringstream buffer;
-        buffer << log_file.rdbuf();
-        log_file.close();
-        std::string file_content = buffer.str();
-
-        // Return file with proper headers
-        std::string response = "HTTP/1.1 200 OK\r\n";
-        response += "Content-Type: text/plain\r\n";
-        response += "Content-Disposition: attachment; filename=\"conditions-" + date + ".log\"\r\n";
-        response += "Content-Length: " + std::to_string(file_content.length()) + "\r\n";
-        response += "Connection: close\r\n";
-        response += "\r\n";
-        response += file_content;
-
-        return response;
+        return send_log_file(log_file_path, "conditions-" + date + ".log", request, write);
     } catch (const std::exception& e) {
         if (logger_) {
             logger_->log_events("Error", "API: Exception downloading conditions - " + std::string(e.what()));
@@ -755,6 +1612,157 @@ std::string RefrigerationAPI::handle_download_conditions_request(const std::stri
     }
 }
 
+// Fields of `after` that differ from `before`, recursing into objects
+static json json_delta(const json& before, const json& after) {
+    json delta = json::object();
+    for (auto it = after.begin(); it != after.end(); ++it) {
+        if (!before.contains(it.key())) {
+            delta[it.key()] = it.value();
+        } else if (it.value().is_object() && before[it.key()].is_object()) {
+            json nested = json_delta(before[it.key()], it.value());
+            if (!nested.empty()) delta[it.key()] = nested;
+        } else if (before[it.key()] != it.value()) {
+            delta[it.key()] = it.value();
+        }
+    }
+    return delta;
+}
+
+// Whether a new state is worth pushing to stream clients. Temperatures only
+// count once they have moved far enough from what the client last saw.
+static bool stream_change_is_significant(const StateSnapshot& sent, const StateSnapshot& state) {
+    if (sent.system_status != state.system_status ||
+        sent.compressor != state.compressor ||
+        sent.fan != state.fan ||
+        sent.valve != state.valve ||
+        sent.electric_heater != state.electric_heater ||
+        sent.setpoint != state.setpoint ||
+        sent.active_alarms != state.active_alarms ||
+        sent.alarm_warning != state.alarm_warning ||
+        sent.alarm_shutdown != state.alarm_shutdown ||
+        sent.demo_mode != state.demo_mode ||
+        sent.pretrip_stage != state.pretrip_stage) {
+        return true;
+    }
+    return std::fabs(sent.return_temp - state.return_temp) >= stream_temp_threshold ||
+           std::fabs(sent.supply_temp - state.supply_temp) >= stream_temp_threshold ||
+           std::fabs(sent.coil_temp - state.coil_temp) >= stream_temp_threshold;
+}
+
+std::string RefrigerationAPI::handle_stream_request(const std::string& request, const StreamWriter& write) {
+    LongLivedSlot slot(server_.get());
+    if (!slot.held()) {
+        return server_busy_response();
+    }
+
+    std::string headers = "HTTP/1.1 200 OK\r\n";
+    headers += "Content-Type: text/event-stream\r\n";
+    headers += "Cache-Control: no-cache\r\n";
+    headers += "Access-Control-Allow-Origin: *\r\n";
+    headers += "Connection: close\r\n";
+    headers += "\r\n";
+    headers += "retry: 3000\n\n";
+    if (!write(headers)) {
+        return "";
+    }
+
+    const std::string instance = std::to_string(state_publisher.instance_id());
+    auto stream_json = [this](const StateSnapshot& state) {
+        json data = build_status_json(state);
+        data["demo_mode"] = state.demo_mode;
+        data["state_version"] = state.version;
+        return data;
+    };
+    auto send_event = [&](const std::string& event, const StateSnapshot& state, const json& data) {
+        std::string message = "id: " + instance + "-" + std::to_string(state.version) + "\n";
+        message += "event: " + event + "\n";
+        message += "data: " + data.dump() + "\n\n";
+        return write(message);
+    };
+
+    // Resume from Last-Event-ID (<instance>-<version>) if that version is still in the history
+    StateSnapshot last_sent;
+    bool resumed = false;
+    std::string last_event_id = extract_header(request, "Last-Event-ID");
+    size_t dash = last_event_id.rfind('-');
+    if (dash != std::string::npos && last_event_id.substr(0, dash) == instance) {
+        try {
+            uint64_t last_version = std::stoull(last_event_id.substr(dash + 1));
+            resumed = state_publisher.find(last_version, last_sent);
+        } catch (...) {
+            resumed = false;
+        }
+    }
+
+    StateSnapshot state = state_publisher.current();
+    json last_json;
+    if (resumed) {
+        last_json = stream_json(last_sent);
+        if (state.version != last_sent.version) {
+            json data = stream_json(state);
+            if (!send_event("delta", state, json_delta(last_json, data))) return "";
+            last_sent = state;
+            last_json = data;
+        }
+    } else {
+        last_json = stream_json(state);
+        if (!send_event("snapshot", state, last_json)) return "";
+        last_sent = state;
+    }
+
+    if (logger_) {
+        logger_->log_events("Debug", std::string("API: Stream client connected") + (resumed ? " (resumed)" : ""));
+    }
+
+    uint64_t seen_version = state.version;
+    while (running_) {
+        if (!state_publisher.wait_for_change(seen_version, std::chrono::seconds(stream_heartbeat_seconds), &running_)) {
+            if (!running_ || !write(": heartbeat\n\n")) break;
+            continue;
+        }
+
+        state = state_publisher.current();
+        seen_version = state.version;
+        if (!stream_change_is_significant(last_sent, state)) continue;
+
+        json data = stream_json(state);
+        if (!send_event("delta", state, json_delta(last_json, data))) break;
+        last_sent = state;
+        last_json = data;
+    }
+
+    if (logger_) {
+        logger_->log_events("Debug", "API: Stream client disconnected");
+    }
+    return "";
+}
+
+json RefrigerationAPI::handle_traces_request(size_t limit) {
+    json response;
+    json traces = json::array();
+
+    for (const RequestTrace& trace : tracer_.recent(limit)) {
+        json entry;
+        entry["id"] = trace.id;
+        entry["timestamp"] = trace.timestamp;
+        entry["method"] = trace.method;
+        entry["path"] = trace.path;
+        entry["status"] = trace.status;
+        entry["total_ms"] = trace.total_ns / 1e6;
+        json phases;
+        for (int i = 0; i < static_cast<int>(TracePhase::Count); ++i) {
+            phases[RequestTracer::phase_name(static_cast<TracePhase>(i))] = trace.phase_ns[i] / 1e6;
+        }
+        entry["phases_ms"] = phases;
+        traces.push_back(entry);
+    }
+
+    response["enabled"] = tracer_.enabled();
+    response["slow_threshold_ms"] = tracer_.slow_threshold_ms();
+    response["traces"] = traces;
+    return response;
+}
+
 void RefrigerationAPI::start() {
     running_ = true;
 
@@ -767,9 +1775,9 @@ void RefrigerationAPI::start() {
         }
     }
 
-    server_ = std::make_unique<HTTPServer>(port_, logger_, ssl_context_.get());
+    server_ = std::make_unique<HTTPServer>(port_, get_admission_limits(), logger_, ssl_context_.get(), &tracer_);
 
-    server_->start([this](const std::string& request, const std::string& body) -> std::string {
+    server_->start([this](const std::string& request, const std::string& body, const StreamWriter& write) -> std::string {
         std::istringstream iss(request);
         std::string method, path;
         iss >> method >> path;
@@ -783,6 +1791,8 @@ void RefrigerationAPI::start() {
         }
 
 
+        MetricTimer request_timer(MetricHistogram::ApiRequest, Metrics::endpoint_label(path));
+
         // Extract API key from X-API-Key header (case-insensitive) or query string
         std::string api_key;
         bool found_header = false;
@@ -818,6 +1828,7 @@ void RefrigerationAPI::start() {
 
         // Extract client IP for rate limiting
         std::string client_ip = extract_client_ip(request);
+        RequestTracer::mark(TracePhase::Parse);
 
         // Check rate limit (applies to all endpoints)
         if (!rate_limiter_->is_allowed(client_ip, api_key)) {
@@ -834,6 +1845,7 @@ void RefrigerationAPI::start() {
             response += "\r\n";
             response += error_body;
 
+            Metrics::increment(MetricCounter::RateLimitRejections);
             if (logger_) {
                 logger_->log_events("Error", "API: Rate limit exceeded for IP " + client_ip);
             }
@@ -855,7 +1867,14 @@ void RefrigerationAPI::start() {
                 response_json["status"] = "ok";
                 response_json["timestamp"] = std::time(nullptr);
             }
-            // Status endpoints
+            // Status endpoints (served from the per-version cache once the control loop has published)
+            else if ((path == "/api/v1/status" || path == "/api/v1/relays" || path == "/api/v1/sensors") &&
+                     method == "GET" && state_publisher.version() != 0) {
+                if (!query_param(query_string, "wait").empty()) {
+                    request_timer.cancel();  // A long-poll's wait for a change isn't request latency
+                }
+                return handle_cached_status_request(request, path, query_string);
+            }
             else if (path == "/api/v1/status") {
                 response_json = handle_status_request();
             }
@@ -910,6 +1929,71 @@ void RefrigerationAPI::start() {
                 response_json["demo_mode"] = demo_mode.load();
                 response_json["timestamp"] = std::time(nullptr);
             }
+            // Live status stream (Server-Sent Events)
+            else if (path == "/api/v1/stream" && method == "GET") {
+                request_timer.cancel();  // Streams stay open; their lifetime isn't request latency
+                RequestTracer::discard();
+                return handle_stream_request(request, write);
+            }
+            // Prometheus metrics
+            else if (path == "/api/v1/metrics" && method == "GET") {
+                std::string metrics_body = Metrics::render_prometheus();
+                std::string metrics_response = "HTTP/1.1 200 OK\r\n";
+                metrics_response += "Content-Type: text/plain; version=0.0.4\r\n";
+                metrics_response += "Content-Length: " + std::to_string(metrics_body.length()) + "\r\n";
+                metrics_response += "Access-Control-Allow-Origin: *\r\n";
+                metrics_response += "Connection: close\r\n";
+                metrics_response += "\r\n";
+                metrics_response += metrics_body;
+                return metrics_response;
+            }
+            // Aggregated history from the conditions logs
+            else if (path == "/api/v1/history" && method == "GET") {
+                return handle_history_request(query_string, negotiate_format(extract_header(request, "Accept")),
+                                              extract_header(request, "Accept-Encoding"));
+            }
+            // 1 Hz control cycle records around an alarm or time
+            else if (path == "/api/v1/flight-recorder" && method == "GET") {
+                return handle_flight_recorder_request(query_string, negotiate_format(extract_header(request, "Accept")),
+                                                      extract_header(request, "Accept-Encoding"));
+            }
+            // Combined status, config, demo mode and counters in one response
+            else if (path == "/api/v1/snapshot" && method == "GET") {
+                std::string fields = "status,config,demo,counters";
+                size_t fields_pos = query_string.find("fields=");
+                if (fields_pos != std::string::npos) {
+                    fields = query_string.substr(fields_pos + 7);
+                    fields = fields.substr(0, fields.find('&'));
+                }
+                std::set<std::string> selected;
+                std::istringstream field_stream(fields);
+                std::string field;
+                while (std::getline(field_stream, field, ',')) {
+                    if (field.empty()) continue;
+                    if (field != "status" && field != "config" && field != "demo" && field != "counters") {
+                        return get_error_response(400, "Unknown field '" + field + "'. Use status, config, demo, counters");
+                    }
+                    selected.insert(field);
+                }
+                response_json = handle_snapshot_request(selected);
+            }
+            // Recent request traces
+            else if (path == "/api/v1/debug/traces" && method == "GET") {
+                size_t limit = 50;
+                size_t limit_pos = query_string.find("limit=");
+                if (limit_pos != std::string::npos) {
+                    try {
+                        limit = std::stoul(query_string.substr(limit_pos + 6));
+                    } catch (...) {
+                        return get_error_response(400, "Invalid 'limit' parameter. Use ?limit=<count>");
+                    }
+                }
+                response_json = handle_traces_request(limit);
+            }
+            // Runtime counters
+            else if (path == "/api/v1/counters" && method == "GET") {
+                response_json = handle_counters_request();
+            }
             // System info
             else if (path == "/api/v1/system-info") {
                 response_json = handle_system_info_request();
@@ -947,7 +2031,7 @@ void RefrigerationAPI::start() {
                 } else {
                     return get_error_response(400, "Missing 'date' parameter. Use ?date=YYYY-MM-DD");
                 }
-                return handle_download_events_request(date);
+                return handle_download_events_request(date, request, write);
             }
             else if (path.find("/api/v1/logs/conditions") == 0) {
                 // Extract date from query string: /api/v1/logs/conditions?date=2025-12-05
@@ -967,7 +2051,7 @@ void RefrigerationAPI::start() {
                 } else {
                     return get_error_response(400, "Missing 'date' parameter. Use ?date=YYYY-MM-DD");
                 }
-                return handle_download_conditions_request(date);
+                return handle_download_conditions_request(date, request, write);
             }
             else {
                 http_code = 404;
@@ -979,16 +2063,24 @@ void RefrigerationAPI::start() {
         }
 
         response_json["timestamp"] = std::time(nullptr);
+        RequestTracer::mark(TracePhase::Handler);
 
-        std::string body_str = response_json.dump();
+        BodyFormat format = negotiate_format(extract_header(request, "Accept"));
+        std::string body_str = encode_body(response_json, format);
+        bool gzipped = gzip_body_if_accepted(body_str, extract_header(request, "Accept-Encoding"));
         std::string http_response = "HTTP/1.1 " + std::to_string(http_code) + " OK\r\n";
-        http_response += "Content-Type: application/json\r\n";
+        http_response += "Content-Type: " + std::string(format_content_type(format)) + "\r\n";
+        if (gzipped) {
+            http_response += "Content-Encoding: gzip\r\n";
+        }
+        http_response += "Vary: Accept, Accept-Encoding\r\n";
         http_response += "Content-Length: " + std::to_string(body_str.length()) + "\r\n";
         http_response += "Access-Control-Allow-Origin: *\r\n";
         http_response += "Access-Control-Allow-Methods: GET, POST, OPTIONS\r\n";
         http_response += "Connection: close\r\n";
         http_response += "\r\n";
         http_response += body_str;
+        RequestTracer::mark(TracePhase::Serialize);
 
         return http_response;
     });
@@ -996,6 +2088,8 @@ void RefrigerationAPI::start() {
 
 void RefrigerationAPI::stop() {
     running_ = false;
+    // Streams and long-polls return now instead of at their next heartbeat or timeout
+    state_publisher.wake_waiters();
     if (server_) {
         server_->stop();
     }
@@ -0,0 +1,131 @@
+/*
+ * Request Tracing Implementation
+ * Copyright (c) 2025 William Bellvance Jr
+ * Licensed under the MIT License.
+ */
+
+#include "request_trace.h"
+#include <algorithm>
+#include <cstring>
+#include <cstdio>
+
+thread_local RequestTrace* RequestTracer::active_ = nullptr;
+
+RequestTracer::RequestTracer(size_t capacity)
+    : enabled_(true), slow_threshold_ms_(500), next_id_(1),
+      ring_(capacity == 0 ? 1 : capacity), ring_next_(0), ring_size_(0) {
+}
+
+void RequestTracer::begin(RequestTrace& trace, std::chrono::steady_clock::time_point accepted) {
+    if (!enabled_) {
+        active_ = nullptr;
+        return;
+    }
+    auto now = std::chrono::steady_clock::now();
+    trace.id = next_id_++;
+    trace.timestamp = std::time(nullptr);
+    trace.start = accepted;
+    trace.last_mark = now;
+    trace.phase_ns[static_cast<int>(TracePhase::Queue)] =
+        std::chrono::duration_cast<std::chrono::nanoseconds>(now - accepted).count();
+    active_ = &trace;
+}
+
+void RequestTracer::mark(TracePhase phase) {
+    RequestTrace* trace = active_;
+    if (!trace) return;
+    auto now = std::chrono::steady_clock::now();
+    trace->phase_ns[static_cast<int>(phase)] +=
+        std::chrono::duration_cast<std::chrono::nanoseconds>(now - trace->last_mark).count();
+    trace->last_mark = now;
+}
+
+void RequestTracer::set_request(const char* request, size_t length) {
+    RequestTrace* trace = active_;
+    if (!trace) return;
+
+    // "METHOD /path?query HTTP/1.1"
+    size_t i = 0;
+    size_t m = 0;
+    while (i < length && request[i] != ' ' && request[i] != '\r' && request[i] != '\n') {
+        if (m < sizeof(trace->method) - 1) trace->method[m++] = request[i];
+        ++i;
+    }
+    trace->method[m] = '\0';
+    if (i < length && request[i] == ' ') ++i;
+    size_t p = 0;
+    while (i < length && request[i] != ' ' && request[i] != '?' && request[i] != '\r' && request[i] != '\n') {
+        if (p < sizeof(trace->path) - 1) trace->path[p++] = request[i];
+        ++i;
+    }
+    trace->path[p] = '\0';
+}
+
+void RequestTracer::discard() {
+    if (active_) {
+        active_->discard = true;
+    }
+}
+
+bool RequestTracer::finish(RequestTrace& trace, int status) {
+    if (active_ != &trace) {
+        return false;  // Tracing was off when the request started
+    }
+    active_ = nullptr;
+    if (trace.discard) {
+        return false;
+    }
+
+    trace.status = status;
+    trace.total_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - trace.start).count();
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        ring_[ring_next_] = trace;
+        ring_next_ = (ring_next_ + 1) % ring_.size();
+        if (ring_size_ < ring_.size()) ring_size_++;
+    }
+
+    int64_t active_ns = trace.total_ns - trace.phase_ns[static_cast<int>(TracePhase::Wait)];
+    return active_ns > static_cast<int64_t>(slow_threshold_ms_.load()) * 1000000;
+}
+
+std::vector<RequestTrace> RequestTracer::recent(size_t limit) const {
+    std::vector<RequestTrace> traces;
+    std::lock_guard<std::mutex> lock(mutex_);
+    size_t count = std::min(limit, ring_size_);
+    traces.reserve(count);
+    for (size_t i = 1; i <= count; ++i) {
+        traces.push_back(ring_[(ring_next_ + ring_.size() - i) % ring_.size()]);
+    }
+    return traces;
+}
+
+const char* RequestTracer::phase_name(TracePhase phase) {
+    switch (phase) {
+        case TracePhase::Queue: return "queue";
+        case TracePhase::TlsHandshake: return "tls_handshake";
+        case TracePhase::Read: return "read";
+        case TracePhase::Parse: return "parse";
+        case TracePhase::Handler: return "handler";
+        case TracePhase::Wait: return "wait";
+        case TracePhase::Serialize: return "serialize";
+        case TracePhase::Write: return "write";
+        default: return "unknown";
+    }
+}
+
+std::string RequestTracer::describe(const RequestTrace& trace) {
+    char line[512];
+    int n = std::snprintf(line, sizeof(line), "#%llu %s %s -> %d in %.1f ms (",
+                          static_cast<unsigned long long>(trace.id), trace.method, trace.path,
+                          trace.status, trace.total_ns / 1e6);
+    for (int i = 0; i < static_cast<int>(TracePhase::Count) && n > 0 && n < static_cast<int>(sizeof(line)); ++i) {
+        n += std::snprintf(line + n, sizeof(line) - n, "%s%s %.1f", i ? ", " : "",
+                           phase_name(static_cast<TracePhase>(i)), trace.phase_ns[i] / 1e6);
+    }
+    std::string result(line);
+    result += ")";
+    return result;
+}
@@ -0,0 +1,214 @@
+/*
+ * Runtime Counters Implementation
+ * Copyright (c) 2025 William Bellvance Jr
+ * Licensed under the MIT License.
+ */
+
+#include "runtime_counters.h"
+#include <iostream>
+#include <filesystem>
+#include <cstring>
+#include <cstddef>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+static constexpr uint32_t counter_magic = 0x52434E54;  // "RCNT"
+static constexpr uint32_t counter_layout_version = 1;
+static constexpr int relay_count = static_cast<int>(CounterRelay::Count);
+
+RuntimeCounters::RuntimeCounters(const std::string& path, uint64_t seed_compressor_seconds)
+    : path_(path), file_(nullptr), fd_(-1), sequence_(0), dirty_(false) {
+    std::memset(&values_, 0, sizeof(values_));
+    for (int i = 0; i < relay_count; ++i) {
+        relay_on_[i] = false;
+    }
+    last_flush_ = std::chrono::steady_clock::now();
+
+    if (!open_file()) {
+        std::cerr << "[RuntimeCounters] Could not map " << path_ << ", counters will not persist\n";
+    }
+
+    // Load the newest valid slot
+    bool loaded = false;
+    if (file_) {
+        const Slot* best = nullptr;
+        for (const Slot& slot : file_->slots) {
+            if (slot_valid(slot) && (!best || slot.sequence > best->sequence)) {
+                best = &slot;
+            }
+        }
+        if (best) {
+            values_ = best->values;
+            sequence_ = best->sequence;
+            loaded = true;
+        }
+    }
+
+    if (!loaded) {
+        // New store: carry over the run time previously kept in config.env
+        values_.run_seconds[static_cast<int>(CounterRelay::Compressor)] = seed_compressor_seconds;
+        dirty_ = true;
+        flush();
+    }
+}
+
+RuntimeCounters::~RuntimeCounters() {
+    flush();
+    if (file_) {
+        munmap(file_, sizeof(File));
+    }
+    if (fd_ != -1) {
+        close(fd_);
+    }
+}
+
+bool RuntimeCounters::open_file() {
+    std::error_code ec;
+    std::filesystem::path dir = std::filesystem::path(path_).parent_path();
+    if (!dir.empty()) {
+        std::filesystem::create_directories(dir, ec);
+    }
+
+    fd_ = open(path_.c_str(), O_RDWR | O_CREAT, 0644);
+    if (fd_ == -1) {
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(fd_, &st) == -1 || (st.st_size != static_cast<off_t>(sizeof(File)) && ftruncate(fd_, sizeof(File)) == -1)) {
+        close(fd_);
+        fd_ = -1;
+        return false;
+    }
+
+    void* mapped = mmap(nullptr, sizeof(File), PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+    if (mapped == MAP_FAILED) {
+        close(fd_);
+        fd_ = -1;
+        return false;
+    }
+    file_ = static_cast<File*>(mapped);
+    return true;
+}
+
+void RuntimeCounters::update_relays(bool compressor, bool fan, bool valve, bool electric_heater) {
+    const bool states[relay_count] = {compressor, fan, valve, electric_heater};
+    auto now = std::chrono::steady_clock::now();
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (int i = 0; i < relay_count; ++i) {
+        if (states[i] == relay_on_[i]) continue;
+        if (states[i]) {
+            values_.starts[i]++;
+            on_since_[i] = now;
+            if (i == static_cast<int>(CounterRelay::Compressor)) {
+                compressor_starts_.push_back(now);
+            }
+        } else {
+            values_.run_seconds[i] += std::chrono::duration_cast<std::chrono::seconds>(now - on_since_[i]).count();
+        }
+        relay_on_[i] = states[i];
+        dirty_ = true;
+    }
+}
+
+void RuntimeCounters::record_defrost() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    values_.defrost_count++;
+    dirty_ = true;
+}
+
+CounterValues RuntimeCounters::values() {
+    auto now = std::chrono::steady_clock::now();
+    std::lock_guard<std::mutex> lock(mutex_);
+    CounterValues current = values_;
+    for (int i = 0; i < relay_count; ++i) {
+        if (relay_on_[i]) {
+            current.run_seconds[i] += std::chrono::duration_cast<std::chrono::seconds>(now - on_since_[i]).count();
+        }
+    }
+    return current;
+}
+
+int RuntimeCounters::compressor_starts_last_hour() {
+    auto cutoff = std::chrono::steady_clock::now() - std::chrono::hours(1);
+    std::lock_guard<std::mutex> lock(mutex_);
+    while (!compressor_starts_.empty() && compressor_starts_.front() < cutoff) {
+        compressor_starts_.pop_front();
+    }
+    return static_cast<int>(compressor_starts_.size());
+}
+
+bool RuntimeCounters::flush_if_due(int interval_seconds) {
+    auto now = std::chrono::steady_clock::now();
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (now - last_flush_ < std::chrono::seconds(interval_seconds)) {
+            return false;
+        }
+    }
+    flush();
+    return true;
+}
+
+void RuntimeCounters::flush() {
+    auto now = std::chrono::steady_clock::now();
+    std::lock_guard<std::mutex> lock(mutex_);
+    last_flush_ = now;
+    accumulate_running(now);
+    if (!dirty_) return;
+    write_slot();
+    dirty_ = false;
+}
+
+void RuntimeCounters::accumulate_running(std::chrono::steady_clock::time_point now) {
+    // Fold time for relays that are still on into the totals so a power cut loses at most one interval
+    for (int i = 0; i < relay_count; ++i) {
+        if (!relay_on_[i]) continue;
+        auto whole = std::chrono::duration_cast<std::chrono::seconds>(now - on_since_[i]);
+        if (whole.count() > 0) {
+            values_.run_seconds[i] += whole.count();
+            on_since_[i] += whole;
+            dirty_ = true;
+        }
+    }
+}
+
+void RuntimeCounters::write_slot() {
+    if (!file_) return;
+
+    Slot& slot = file_->slots[(sequence_ + 1) % 2];
+    slot.magic = counter_magic;
+    slot.layout_version = counter_layout_version;
+    slot.sequence = sequence_ + 1;
+    slot.values = values_;
+    slot.reserved = 0;
+    slot.crc = crc32(&slot, offsetof(Slot, crc));
+
+    if (msync(file_, sizeof(File), MS_SYNC) == -1) {
+        std::cerr << "[RuntimeCounters] msync failed: " << std::strerror(errno) << "\n";
+        return;
+    }
+    sequence_++;
+}
+
+bool RuntimeCounters::slot_valid(const Slot& slot) {
+    return slot.magic == counter_magic &&
+           slot.layout_version == counter_layout_version &&
+           slot.crc == crc32(&slot, offsetof(Slot, crc));
+}
+
+uint32_t RuntimeCounters::crc32(const void* data, size_t length) {
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    uint32_t crc = 0xFFFFFFFF;
+    for (size_t i = 0; i < length; ++i) {
+        crc ^= bytes[i];
+        for (int bit = 0; bit < 8; ++bit) {
+            crc = (crc >> 1) ^ (0xEDB88320 & (0u - (crc & 1)));
+        }
+    }
+    return ~crc;
+}
@@ -0,0 +1,94 @@
+/*
+ * State Publisher Implementation
+ * Copyright (c) 2025 William Bellvance Jr
+ * Licensed under the MIT License.
+ */
+
+#include "state_publisher.h"
+
+StatePublisher::StatePublisher(size_t history_size)
+    : version_(0), timestamp_(0), history_size_(history_size == 0 ? 1 : history_size),
+      instance_id_(std::time(nullptr)) {
+}
+
+bool StatePublisher::same_state(const StateSnapshot& a, const StateSnapshot& b) {
+    return a.system_status == b.system_status &&
+           a.compressor == b.compressor &&
+           a.fan == b.fan &&
+           a.valve == b.valve &&
+           a.electric_heater == b.electric_heater &&
+           a.return_temp == b.return_temp &&
+           a.supply_temp == b.supply_temp &&
+           a.coil_temp == b.coil_temp &&
+           a.setpoint == b.setpoint &&
+           a.active_alarms == b.active_alarms &&
+           a.alarm_warning == b.alarm_warning &&
+           a.alarm_shutdown == b.alarm_shutdown &&
+           a.demo_mode == b.demo_mode &&
+           a.pretrip_stage == b.pretrip_stage;
+}
+
+uint64_t StatePublisher::publish(const StateSnapshot& snapshot) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::time_t stamp = snapshot.timestamp != 0 ? snapshot.timestamp : std::time(nullptr);
+        timestamp_.store(stamp);
+        if (version_.load() != 0 && same_state(current_, snapshot)) {
+            // Still the same version, but readers should see that it was current as of now
+            current_.timestamp = stamp;
+            return version_.load();
+        }
+
+        current_ = snapshot;
+        current_.version = version_.load() + 1;
+        current_.timestamp = stamp;
+
+        history_.push_back(current_);
+        while (history_.size() > history_size_) {
+            history_.pop_front();
+        }
+        version_.store(current_.version);
+    }
+    changed_.notify_all();
+    return version_.load();
+}
+
+uint64_t StatePublisher::version() const {
+    return version_.load();
+}
+
+std::time_t StatePublisher::timestamp() const {
+    return timestamp_.load();
+}
+
+StateSnapshot StatePublisher::current() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return current_;
+}
+
+bool StatePublisher::find(uint64_t version, StateSnapshot& out) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto it = history_.rbegin(); it != history_.rend(); ++it) {
+        if (it->version == version) {
+            out = *it;
+            return true;
+        }
+        if (it->version < version) break;
+    }
+    return false;
+}
+
+bool StatePublisher::wait_for_change(uint64_t since_version, std::chrono::milliseconds timeout,
+                                     const std::atomic<bool>* keep_waiting) const {
+    std::unique_lock<std::mutex> lock(mutex_);
+    changed_.wait_for(lock, timeout, [this, since_version, keep_waiting]() {
+        return version_.load() != since_version || (keep_waiting && !keep_waiting->load());
+    });
+    return version_.load() != since_version;
+}
+
+void StatePublisher::wake_waiters() const {
+    // Taking the lock orders this after any waiter's predicate check, so none misses the wakeup
+    std::lock_guard<std::mutex> lock(mutex_);
+    changed_.notify_all();
+}
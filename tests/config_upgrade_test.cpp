@@ -0,0 +1,66 @@
+/*
+ * Refrigeration Server
+ * Copyright (c) 2025 William Bellvance Jr
+ * Licensed under the MIT License.
+ *
+ * Startup check for upgraded units: a config.env written by an older release must still
+ * give every key the daemon parses at startup a usable value.
+ */
+
+#include "config_manager.h"
+#include "config_validator.h"
+#include <iostream>
+#include <fstream>
+#include <filesystem>
+#include <string>
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        std::cerr << "usage: " << argv[0] << " <config.env from an older release>\n";
+        return 2;
+    }
+
+    // Work on a copy; ConfigManager may take a lock file next to it
+    std::filesystem::path copy = std::filesystem::temp_directory_path() / "config_upgrade_test.env";
+    std::filesystem::copy_file(argv[1], copy, std::filesystem::copy_options::overwrite_existing);
+
+    int failures = 0;
+    {
+        ConfigManager cfg(copy.string());
+        ConfigValidator validator;
+        for (const auto& [key, entry] : validator.getSchema()) {
+            std::string value = cfg.get(key);
+            if (value.empty() && entry.type != ConfigType::String) {
+                std::cerr << "FAIL " << key << ": missing\n";
+                failures++;
+            } else if (!validator.validate(key, value)) {
+                std::cerr << "FAIL " << key << ": invalid value \"" << value << "\"\n";
+                failures++;
+            }
+        }
+
+        // The reads the daemon makes before and right after main() starts
+        try {
+            std::stoi(cfg.get("debug.code"));
+            std::stoi(cfg.get("api.port"));
+            std::stof(cfg.get("unit.setpoint"));
+            std::stoull(cfg.get("unit.compressor_run_seconds"));
+            std::stoi(cfg.get("logging.flight_recorder_hours"));
+            std::stoi(cfg.get("logging.max_total_mb"));
+            std::stoi(cfg.get("logging.retention_period"));
+        } catch (const std::exception& e) {
+            std::cerr << "FAIL startup read: " << e.what() << "\n";
+            failures++;
+        }
+    }
+
+    std::filesystem::remove(copy);
+    std::filesystem::remove(copy.string() + ".lock");
+
+    if (failures) {
+        std::cerr << failures << " config keys unusable after upgrade\n";
+        return 1;
+    }
+    std::cout << "PASS config_upgrade_test (" << argv[1] << ")\n";
+    return 0;
+}
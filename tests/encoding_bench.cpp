@@ -0,0 +1,140 @@
+/*
+ * Refrigeration Server
+ * Copyright (c) 2025 William Bellvance Jr
+ * Licensed under the MIT License.
+ *
+ * Response encoding benchmark: size, encode and decode time and throughput of the status,
+ * snapshot and history bodies as JSON, CBOR and MessagePack. The history body is also run in
+ * the packed form the binary encodings get (int16 hundredths columns instead of number arrays).
+ */
+
+#include <nlohmann/json.hpp>
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <algorithm>
+#include <climits>
+#include <cmath>
+
+using json = nlohmann::json;
+
+enum class Format { Json, Cbor, MsgPack };
+
+static std::string encode(const json& body, Format format) {
+    std::string encoded;
+    switch (format) {
+        case Format::Cbor:
+            json::to_cbor(body, encoded);
+            break;
+        case Format::MsgPack:
+            json::to_msgpack(body, encoded);
+            break;
+        default:
+            encoded = body.dump();
+            break;
+    }
+    return encoded;
+}
+
+static json decode(const std::string& body, Format format) {
+    switch (format) {
+        case Format::Cbor: return json::from_cbor(body);
+        case Format::MsgPack: return json::from_msgpack(body);
+        default: return json::parse(body);
+    }
+}
+
+// What the history handler sends to CBOR and MessagePack clients: no time column, and each
+// series column as little-endian int16 hundredths with INT16_MIN for empty buckets
+static json pack_history(const json& history) {
+    json packed = history;
+    packed.erase("time");
+    packed["encoding"] = "int16_le_x100";
+    for (auto& [name, aggregates] : packed["series"].items()) {
+        for (auto& [aggregate, column] : aggregates.items()) {
+            std::vector<uint8_t> bytes;
+            bytes.reserve(column.size() * 2);
+            for (const json& value : column) {
+                int16_t v = INT16_MIN;
+                if (!value.is_null()) {
+                    v = static_cast<int16_t>(std::clamp<long>(std::lround(value.get<double>() * 100.0), INT16_MIN + 1, INT16_MAX));
+                }
+                bytes.push_back(static_cast<uint8_t>(v & 0xff));
+                bytes.push_back(static_cast<uint8_t>((static_cast<uint16_t>(v) >> 8) & 0xff));
+            }
+            column = json::binary(bytes);
+        }
+    }
+    return packed;
+}
+
+// Mean microseconds per call over enough calls to run for roughly a tenth of a second
+template <typename Call>
+static double mean_us(Call call) {
+    int calls = 0;
+    auto start = std::chrono::steady_clock::now();
+    double elapsed = 0;
+    do {
+        call();
+        calls++;
+        elapsed = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+    } while (elapsed < 100000.0);
+    return elapsed / calls;
+}
+
+int main(int argc, char* argv[]) {
+    std::string fixtures = argc > 1 ? argv[1] : "tests/fixtures/bodies";
+    int failures = 0;
+
+    std::vector<std::pair<std::string, json>> bodies;
+    for (const char* name : {"status", "snapshot", "history"}) {
+        std::ifstream file(fixtures + "/" + name + ".json");
+        std::stringstream text;
+        text << file.rdbuf();
+        json body = json::parse(text.str(), nullptr, false);
+        if (!file || body.is_discarded()) {
+            std::cerr << "FAIL can't read " << fixtures << "/" << name << ".json\n";
+            return 1;
+        }
+        bodies.emplace_back(name, body);
+    }
+    bodies.emplace_back("history packed", pack_history(bodies.back().second));
+
+    const std::pair<const char*, Format> formats[] = {
+        {"json", Format::Json}, {"cbor", Format::Cbor}, {"msgpack", Format::MsgPack}};
+
+    std::cout << std::left << std::setw(16) << "body" << std::setw(9) << "format" << std::right
+              << std::setw(8) << "bytes" << std::setw(12) << "encode us" << std::setw(12) << "decode us"
+              << std::setw(14) << "enc bytes/us" << std::setw(14) << "dec bytes/us" << "\n";
+    for (const auto& [name, body] : bodies) {
+        for (const auto& [format_name, format] : formats) {
+            // The packed form only goes to binary clients
+            if (name == "history packed" && format == Format::Json) continue;
+
+            std::string encoded = encode(body, format);
+            if (decode(encoded, format) != body) {
+                std::cerr << "FAIL " << name << " doesn't round-trip through " << format_name << "\n";
+                failures++;
+            }
+            double encode_us = mean_us([&]() { encoded = encode(body, format); });
+            json decoded;
+            double decode_us = mean_us([&]() { decoded = decode(encoded, format); });
+
+            std::cout << std::left << std::setw(16) << name << std::setw(9) << format_name << std::right
+                      << std::setw(8) << encoded.size() << std::fixed << std::setprecision(1)
+                      << std::setw(12) << encode_us << std::setw(12) << decode_us
+                      << std::setw(14) << encoded.size() / encode_us
+                      << std::setw(14) << encoded.size() / decode_us << "\n";
+        }
+    }
+
+    if (failures) {
+        return 1;
+    }
+    std::cout << "PASS encoding_bench\n";
+    return 0;
+}
@@ -0,0 +1,126 @@
+/*
+ * Refrigeration Server
+ * Copyright (c) 2025 William Bellvance Jr
+ * Licensed under the MIT License.
+ *
+ * Rate limiter benchmark: is_allowed() throughput with several API worker threads at once,
+ * and a stress run that churns through far more addresses than the table tracks while a throttled
+ * client must stay throttled.
+ */
+
+#include "rate_limiter.h"
+#include <iostream>
+#include <iomanip>
+#include <thread>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <cstring>
+#include <cstdio>
+
+static double seconds_since(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Peak resident memory in kB, from /proc
+static long peak_rss_kb() {
+    FILE* status = std::fopen("/proc/self/status", "r");
+    if (!status) return 0;
+    char line[256];
+    long kb = 0;
+    while (std::fgets(line, sizeof(line), status)) {
+        if (std::strncmp(line, "VmHWM:", 6) == 0) {
+            kb = std::atol(line + 6);
+        }
+    }
+    std::fclose(status);
+    return kb;
+}
+
+int main(int argc, char* argv[]) {
+    int threads = argc > 1 ? std::atoi(argv[1]) : 8;
+    const int calls_per_thread = 200000;
+    const int churn_clients = 1000000;
+    int failures = 0;
+
+    // Limits high enough that every call takes the full path without being rejected
+    {
+        RateLimiter limiter(1000000000, 1000000000, 1000000000);
+        std::vector<std::string> ips;
+        for (int i = 0; i < 256; ++i) {
+            ips.push_back("10.0.0." + std::to_string(i));
+        }
+
+        for (int n = 1; n <= threads; n *= 2) {
+            auto start = std::chrono::steady_clock::now();
+            std::vector<std::thread> workers;
+            for (int t = 0; t < n; ++t) {
+                workers.emplace_back([&, t]() {
+                    for (int i = 0; i < calls_per_thread; ++i) {
+                        limiter.is_allowed(ips[(i * 7 + t) % ips.size()], "bench-key");
+                    }
+                });
+            }
+            for (std::thread& worker : workers) {
+                worker.join();
+            }
+            double elapsed = seconds_since(start);
+            double total = static_cast<double>(n) * calls_per_thread;
+            std::cout << "contention " << n << " threads: " << std::fixed << std::setprecision(2)
+                      << total / elapsed / 1e6 << " M calls/s, " << std::setprecision(0)
+                      << elapsed * 1e9 / calls_per_thread << " ns per call per thread\n";
+        }
+    }
+
+    // A throttled client, then far more new addresses than the table holds
+    {
+        RateLimiter limiter(1000000000, 100, 200);
+        int allowed = 0;
+        for (int i = 0; i < 150; ++i) {
+            allowed += limiter.is_allowed("192.168.1.10") ? 1 : 0;
+        }
+        if (allowed != 100) {
+            std::cerr << "FAIL client allowed " << allowed << " of 150, limit is 100\n";
+            failures++;
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < churn_clients; ++i) {
+            limiter.is_allowed("172.16." + std::to_string(i));
+        }
+        double elapsed = seconds_since(start);
+        std::cout << "churn " << churn_clients << " distinct addresses: " << std::fixed << std::setprecision(2)
+                  << elapsed << " s, peak RSS " << peak_rss_kb() / 1024 << " MB\n";
+        std::string statistics = limiter.get_statistics();
+        for (const char* counter : {"Evictions:", "Overflows:"}) {
+            size_t at = statistics.find(counter);
+            if (at == std::string::npos) continue;
+            std::cout << "  " << statistics.substr(at, statistics.find('\n', at) - at) << "\n";
+        }
+
+        // The flood must not have pushed the throttled client out and handed it a fresh burst
+        if (limiter.is_allowed("192.168.1.10") || limiter.get_remaining_requests("192.168.1.10") != 0) {
+            std::cerr << "FAIL throttled client got requests back after the churn\n";
+            failures++;
+        }
+    }
+
+    // Idle entries are still reused: with a fast limit every entry's TAT passes almost at once
+    {
+        RateLimiter limiter(1000000000, 600000000, 600000000, 64);
+        for (int i = 0; i < 10000; ++i) {
+            limiter.is_allowed("10.1." + std::to_string(i));
+        }
+        std::string statistics = limiter.get_statistics();
+        if (statistics.find("Evictions: 0\n") != std::string::npos) {
+            std::cerr << "FAIL idle entries weren't reused\n";
+            failures++;
+        }
+    }
+
+    if (failures) {
+        return 1;
+    }
+    std::cout << "PASS rate_limiter_bench\n";
+    return 0;
+}
@@ -0,0 +1,92 @@
+/*
+ * Refrigeration Server
+ * Copyright (c) 2025 William Bellvance Jr
+ * Licensed under the MIT License.
+ *
+ * /api/v1/system-info benchmark: the handler body built from the shared ConfigManager snapshot,
+ * against the old per-request ConfigManager (open, flock, parse and validate config.env), and
+ * the snapshot path again while another thread keeps writing the config.
+ */
+
+#include "config_manager.h"
+#include <nlohmann/json.hpp>
+#include <iostream>
+#include <iomanip>
+#include <filesystem>
+#include <thread>
+#include <atomic>
+#include <vector>
+#include <chrono>
+#include <algorithm>
+#include <functional>
+#include <ctime>
+
+using json = nlohmann::json;
+
+// Mean, p50 and p99 of one call in microseconds
+static void report(const std::string& name, int calls, const std::function<void()>& call) {
+    std::vector<double> us(calls);
+    for (int i = 0; i < calls; ++i) {
+        auto start = std::chrono::steady_clock::now();
+        call();
+        us[i] = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+    }
+    double total = 0;
+    for (double v : us) total += v;
+    std::sort(us.begin(), us.end());
+    std::cout << std::left << std::setw(28) << name << std::right << std::fixed << std::setprecision(1)
+              << " mean " << std::setw(7) << total / calls << " us  p50 " << std::setw(7) << us[calls / 2]
+              << " us  p99 " << std::setw(7) << us[calls * 99 / 100] << " us\n";
+}
+
+// What handle_system_info_request() does with the shared ConfigManager
+static json system_info(const ConfigManager& config) {
+    json info;
+    ConfigSnapshot values = config.snapshot();
+    for (const auto& [key, entry] : config.getSchema()) {
+        auto it = values->find(key);
+        info[key] = (it != values->end()) ? it->second : "";
+    }
+    info["timestamp"] = std::time(nullptr);
+    return info;
+}
+
+int main(int argc, char* argv[]) {
+    const int calls = 5000;
+    std::string fixture = argc > 1 ? argv[1] : "tests/fixtures/baseline_config.env";
+    std::filesystem::path path = std::filesystem::temp_directory_path() / "system_info_bench.env";
+    std::filesystem::copy_file(fixture, path, std::filesystem::copy_options::overwrite_existing);
+
+    size_t bytes = 0;
+    {
+        ConfigManager shared(path.string());
+
+        report("per-request ConfigManager", calls, [&]() {
+            ConfigManager config(path.string());
+            bytes += system_info(config).dump().size();
+        });
+        report("shared snapshot", calls, [&]() {
+            bytes += system_info(shared).dump().size();
+        });
+
+        // Readers take the published snapshot and never wait for a save
+        std::atomic<bool> writing{true};
+        std::thread writer([&]() {
+            int setpoint = 30;
+            while (writing) {
+                shared.update("unit.setpoint", std::to_string(setpoint));
+                setpoint = setpoint == 40 ? 30 : setpoint + 1;
+            }
+        });
+        report("shared snapshot, writer", calls, [&]() {
+            bytes += system_info(shared).dump().size();
+        });
+        writing = false;
+        writer.join();
+    }
+
+    std::filesystem::remove(path);
+    std::filesystem::remove(path.string() + ".lock");
+    std::cout << "(" << bytes / (3 * calls) << " byte bodies)\n";
+    return 0;
+}
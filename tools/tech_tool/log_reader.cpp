@@ -4,6 +4,17 @@
 #include <filesystem>
 #include <thread>
 #include <cstring>
+#include <zlib.h>
+
+// Open a log for reading; falls back to the .gz copy left by log maintenance.
+// gzopen reads uncompressed files as-is.
+static gzFile OpenLogFile(const std::string& log_path) {
+    gzFile file = gzopen(log_path.c_str(), "rb");
+    if (!file) {
+        file = gzopen((log_path + ".gz").c_str(), "rb");
+    }
+    return file;
+}
 
 std::string LogReader::GetTodaysEventLogPath() {
     auto now = std::time(nullptr);
@@ -38,21 +49,21 @@ std::vector<std::string> LogReader::ReadEventsLog() {
 
     WaitForLogLock(lock_file);
 
-    FILE* file = fopen(log_path.c_str(), "r");
+    gzFile file = OpenLogFile(log_path);
     if (!file) {
         lines.push_back("[Log file not found: " + log_path + "]");
         return lines;
     }
 
     char buffer[512];
-    while (fgets(buffer, sizeof(buffer), file)) {
+    while (gzgets(file, buffer, sizeof(buffer))) {
         size_t len = strlen(buffer);
         if (len > 0 && buffer[len-1] == '\n') {
             buffer[len-1] = '\0';
         }
         lines.push_back(buffer);
     }
-    fclose(file);
+    gzclose(file);
     return lines;
 }
 
@@ -63,20 +74,20 @@ std::vector<std::string> LogReader::ReadConditionsLog() {
 
     WaitForLogLock(lock_file);
 
-    FILE* file = fopen(log_path.c_str(), "r");
+    gzFile file = OpenLogFile(log_path);
     if (!file) {
         lines.push_back("[Log file not found: " + log_path + "]");
         return lines;
     }
 
     char buffer[512];
-    while (fgets(buffer, sizeof(buffer), file)) {
+    while (gzgets(file, buffer, sizeof(buffer))) {
         size_t len = strlen(buffer);
         if (len > 0 && buffer[len-1] == '\n') {
             buffer[len-1] = '\0';
         }
         lines.push_back(buffer);
     }
-    fclose(file);
+    gzclose(file);
     return lines;
 }
@@ -0,0 +1,227 @@
+/*
+ * Fleet Simulator Implementation
+ */
+
+#include "fleet_simulator.h"
+#include <openssl/x509.h>
+#include <openssl/evp.h>
+#include <nlohmann/json.hpp>
+#include <cerrno>
+#include <csignal>
+#include <chrono>
+#include <ctime>
+#include <poll.h>
+#include <unistd.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#include <sys/eventfd.h>
+
+FleetSimulator::FleetSimulator(int response_delay_ms)
+    : response_delay_ms_(response_delay_ms), ssl_ctx_(nullptr), running_(false),
+      requests_served_(0), stop_fd_(-1) {
+}
+
+FleetSimulator::~FleetSimulator() {
+    stop();
+}
+
+// Throwaway P-256 key and certificate for localhost, valid for a day
+bool FleetSimulator::create_ssl_ctx(std::string& problems) {
+    EVP_PKEY* pkey = EVP_EC_gen("P-256");
+    X509* x509 = X509_new();
+    bool ok = pkey && x509;
+    if (ok) {
+        X509_set_version(x509, 2);
+        ASN1_INTEGER_set(X509_get_serialNumber(x509), 1);
+        X509_gmtime_adj(X509_get_notBefore(x509), 0);
+        X509_gmtime_adj(X509_get_notAfter(x509), 60 * 60 * 24);
+        X509_NAME* name = X509_get_subject_name(x509);
+        X509_NAME_add_entry_by_txt(name, "CN", MBSTRING_ASC, reinterpret_cast<const unsigned char*>("localhost"), -1, -1, 0);
+        X509_set_issuer_name(x509, name);
+        X509_set_pubkey(x509, pkey);
+        ok = X509_sign(x509, pkey, EVP_sha256()) != 0;
+    }
+    if (ok) {
+        ssl_ctx_ = SSL_CTX_new(TLS_server_method());
+        ok = ssl_ctx_ && SSL_CTX_use_certificate(ssl_ctx_, x509) == 1 && SSL_CTX_use_PrivateKey(ssl_ctx_, pkey) == 1;
+    }
+    X509_free(x509);
+    EVP_PKEY_free(pkey);
+    if (!ok) {
+        problems = "can't create a TLS certificate";
+        if (ssl_ctx_) {
+            SSL_CTX_free(ssl_ctx_);
+            ssl_ctx_ = nullptr;
+        }
+    }
+    return ok;
+}
+
+std::vector<Unit> FleetSimulator::start(int answering, int hung, std::string& problems) {
+    std::vector<Unit> units;
+    problems.clear();
+    if (running_ || !create_ssl_ctx(problems)) {
+        return units;
+    }
+    std::signal(SIGPIPE, SIG_IGN);  // A client that timed out closes before the answer is written
+    stop_fd_ = eventfd(0, EFD_CLOEXEC);
+
+    for (int i = 0; i < answering + hung; ++i) {
+        auto unit = std::make_unique<SimulatedUnit>();
+        unit->hung = i >= answering;
+        unit->listen_fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+
+        struct sockaddr_in addr = {};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        addr.sin_port = 0;  // Any free port
+        socklen_t length = sizeof(addr);
+        if (unit->listen_fd == -1 ||
+            bind(unit->listen_fd, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) == -1 ||
+            listen(unit->listen_fd, 64) == -1 ||
+            getsockname(unit->listen_fd, reinterpret_cast<struct sockaddr*>(&addr), &length) == -1) {
+            problems = "can't listen for unit " + std::to_string(i) + ": " + std::to_string(errno);
+            if (unit->listen_fd != -1) close(unit->listen_fd);
+            break;
+        }
+
+        Unit config;
+        config.id = (unit->hung ? "hung-" : "unit-") + std::to_string(i);
+        config.api_address = "127.0.0.1";
+        config.api_port = ntohs(addr.sin_port);
+        config.api_key = "bench-key";
+        units.push_back(config);
+        units_.push_back(std::move(unit));
+    }
+    if (!problems.empty() || stop_fd_ == -1) {
+        if (problems.empty()) problems = "eventfd unavailable";
+        running_ = true;
+        stop();
+        return {};
+    }
+
+    running_ = true;
+    accept_thread_ = std::thread(&FleetSimulator::accept_loop, this);
+    return units;
+}
+
+void FleetSimulator::stop() {
+    if (!running_) return;
+
+    running_ = false;
+    uint64_t one = 1;
+    ssize_t written = write(stop_fd_, &one, sizeof(one));
+    (void)written;
+    if (accept_thread_.joinable()) {
+        accept_thread_.join();
+    }
+
+    std::vector<std::thread> threads;
+    {
+        std::lock_guard<std::mutex> lock(connections_mutex_);
+        for (int fd : connection_fds_) {
+            shutdown(fd, SHUT_RDWR);  // Their threads close them
+        }
+        threads.swap(connection_threads_);
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    connection_fds_.clear();
+
+    for (const auto& unit : units_) {
+        close(unit->listen_fd);
+    }
+    units_.clear();
+    if (stop_fd_ != -1) {
+        close(stop_fd_);
+        stop_fd_ = -1;
+    }
+    if (ssl_ctx_) {
+        SSL_CTX_free(ssl_ctx_);
+        ssl_ctx_ = nullptr;
+    }
+}
+
+size_t FleetSimulator::units_answered() const {
+    size_t answered = 0;
+    for (const auto& unit : units_) {
+        if (unit->served > 0) answered++;
+    }
+    return answered;
+}
+
+void FleetSimulator::accept_loop() {
+    std::vector<struct pollfd> fds;
+    fds.push_back({stop_fd_, POLLIN, 0});
+    for (const auto& unit : units_) {
+        fds.push_back({unit->listen_fd, POLLIN, 0});
+    }
+
+    while (running_) {
+        if (poll(fds.data(), fds.size(), -1) < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        if (fds[0].revents & POLLIN) {
+            break;
+        }
+        for (size_t i = 1; i < fds.size(); ++i) {
+            if (!(fds[i].revents & POLLIN)) continue;
+            int fd = accept4(fds[i].fd, nullptr, nullptr, SOCK_CLOEXEC);
+            if (fd == -1) continue;
+
+            std::lock_guard<std::mutex> lock(connections_mutex_);
+            connection_fds_.push_back(fd);
+            connection_threads_.emplace_back(&FleetSimulator::serve_connection, this, fd, units_[i - 1].get());
+        }
+    }
+}
+
+// One thread per connection with blocking TLS; keep-alive until the client closes or stop()
+void FleetSimulator::serve_connection(int fd, SimulatedUnit* unit) {
+    // Like a real unit: the same state, re-stamped with the current time on every answer
+    auto response = []() {
+        std::string body = nlohmann::json{
+            {"system_status", "Cooling"}, {"return_temp", 38.1}, {"supply_temp", 33.0}, {"coil_temp", 28.0},
+            {"setpoint", 36.0}, {"alarm_warning", false}, {"alarm_shutdown", false},
+            {"active_alarms", nlohmann::json::array()}, {"state_version", 1}, {"timestamp", std::time(nullptr)}}.dump();
+        return "HTTP/1.1 200 OK\r\nContent-Type: application/json\r\nContent-Length: " +
+               std::to_string(body.size()) + "\r\nConnection: keep-alive\r\n\r\n" + body;
+    };
+
+    SSL* ssl = SSL_new(ssl_ctx_);
+    SSL_set_fd(ssl, fd);
+    if (SSL_accept(ssl) == 1) {
+        std::string request;
+        char buffer[4096];
+        while (running_) {
+            int n = SSL_read(ssl, buffer, sizeof(buffer));
+            if (n <= 0) break;
+            request.append(buffer, n);
+
+            // Requests are GETs without a body; a hung unit reads them and never answers
+            size_t end;
+            while ((end = request.find("\r\n\r\n")) != std::string::npos) {
+                request.erase(0, end + 4);
+                if (unit->hung) continue;
+                std::this_thread::sleep_for(std::chrono::milliseconds(response_delay_ms_));
+                std::string answer = response();
+                if (SSL_write(ssl, answer.data(), static_cast<int>(answer.size())) <= 0) break;
+                unit->served++;
+                requests_served_++;
+            }
+        }
+    }
+    SSL_free(ssl);
+
+    std::lock_guard<std::mutex> lock(connections_mutex_);
+    for (auto it = connection_fds_.begin(); it != connection_fds_.end(); ++it) {
+        if (*it == fd) {
+            connection_fds_.erase(it);
+            break;
+        }
+    }
+    close(fd);
+}
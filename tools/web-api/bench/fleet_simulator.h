@@ -0,0 +1,61 @@
+/*
+ * Fleet Simulator
+ * Local HTTPS stand-ins for refrigeration units, for benchmarking the web-api against a fleet
+ */
+
+#ifndef FLEET_SIMULATOR_H
+#define FLEET_SIMULATOR_H
+
+#include "tools/web_interface/config_manager.h"
+#include <openssl/ssl.h>
+#include <string>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <memory>
+
+class FleetSimulator {
+public:
+    // How long a unit takes to answer /api/v1/status, like the control loop on a real unit
+    explicit FleetSimulator(int response_delay_ms = 50);
+    ~FleetSimulator();
+
+    /**
+     * Listen on 127.0.0.1 with a self-signed certificate, one port per unit.
+     * Answering units serve a Cooling status on keep-alive connections; hung units accept
+     * and complete the TLS handshake but never answer, so only the client's timeout ends the request.
+     * @return The units to poll, answering ones first; empty on failure with problems set
+     */
+    std::vector<Unit> start(int answering, int hung, std::string& problems);
+    void stop();
+
+    // Responses sent in total, and the number of units that have answered at least once
+    uint64_t requests_served() const { return requests_served_; }
+    size_t units_answered() const;
+
+private:
+    struct SimulatedUnit {
+        int listen_fd = -1;
+        bool hung = false;
+        std::atomic<uint64_t> served{0};
+    };
+
+    int response_delay_ms_;
+    SSL_CTX* ssl_ctx_;
+    std::vector<std::unique_ptr<SimulatedUnit>> units_;
+    std::atomic<bool> running_;
+    std::atomic<uint64_t> requests_served_;
+    int stop_fd_;                         // eventfd that wakes the accept thread for stop
+    std::thread accept_thread_;
+
+    std::mutex connections_mutex_;
+    std::vector<std::thread> connection_threads_;
+    std::vector<int> connection_fds_;     // Shut down on stop() to unblock their threads
+
+    bool create_ssl_ctx(std::string& problems);
+    void accept_loop();
+    void serve_connection(int fd, SimulatedUnit* unit);
+};
+
+#endif // FLEET_SIMULATOR_H
@@ -0,0 +1,123 @@
+/*
+ * Unit poller benchmark against a simulated fleet
+ * For each fleet size, with every unit answering and with one in ten hung: how long the first round
+ * over the fleet takes, and the steady-state cycle (time between two polls of the same unit) at a
+ * 1 s poll interval. A cycle above the interval means the concurrency limit, not the schedule, sets the pace.
+ */
+
+#include "fleet_simulator.h"
+#include "tools/web_interface/unit_poller.h"
+#include "tools/web_interface/connection_cache.h"
+#include <curl/curl.h>
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <chrono>
+#include <thread>
+#include <cstdlib>
+
+using Clock = std::chrono::steady_clock;
+
+static double seconds_since(Clock::time_point start) {
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+struct RunResult {
+    double first_round = 0;   // Seconds until every answering unit had been polled once
+    double cycle = 0;         // Seconds between polls of one unit, averaged over the window
+    double polls_per_second = 0;
+    int failures = 0;
+};
+
+static RunResult run(int answering, int hung, const PollSettings& settings) {
+    RunResult result;
+    FleetSimulator fleet;
+    std::string problems;
+    std::vector<Unit> units = fleet.start(answering, hung, problems);
+    if (units.empty()) {
+        std::cerr << "FAIL simulator: " << problems << "\n";
+        result.failures++;
+        return result;
+    }
+
+    ConnectionCache connections;
+    UnitPoller poller(&connections);
+    poller.set_poll_settings(settings);
+    auto start = Clock::now();
+    poller.start(units);
+
+    while (fleet.units_answered() < static_cast<size_t>(answering) && seconds_since(start) < 60) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    result.first_round = seconds_since(start);
+
+    const double window = 5.0;
+    uint64_t served_before = fleet.requests_served();
+    auto window_start = Clock::now();
+    std::this_thread::sleep_for(std::chrono::duration<double>(window));
+    double elapsed = seconds_since(window_start);
+    double polls = static_cast<double>(fleet.requests_served() - served_before);
+    result.polls_per_second = polls / elapsed;
+    result.cycle = polls > 0 ? elapsed * answering / polls : 0;
+
+    for (const Unit& unit : units) {
+        bool is_hung = unit.id.rfind("hung-", 0) == 0;
+        json data = poller.get_unit_data(unit.id);
+        if (!is_hung && data.value("system_status", "") != "Cooling") {
+            std::cerr << "FAIL " << unit.id << " has no polled status\n";
+            result.failures++;
+        }
+        if (is_hung && poller.get_schedule()[unit.id].value("failures", 0) == 0) {
+            std::cerr << "FAIL " << unit.id << " never timed out\n";
+            result.failures++;
+        }
+    }
+
+    poller.stop();
+    fleet.stop();
+    return result;
+}
+
+int main(int argc, char* argv[]) {
+    int max_units = argc > 1 ? std::atoi(argv[1]) : 400;
+    curl_global_init(CURL_GLOBAL_ALL);
+
+    // The poller logs every poll to stdout; keep the table readable
+    std::ostream out(std::cout.rdbuf());
+    std::ofstream discard("/dev/null");
+    std::cout.rdbuf(discard.rdbuf());
+
+    PollSettings settings;
+    settings.connect_timeout = 1;
+    settings.timeout = 2;
+    settings.interval = 1;
+    settings.fast_interval = 1;
+
+    out << "units  hung  concurrency  first round s  cycle s  polls/s\n";
+    int failures = 0;
+    auto report = [&](int units, int hung, int concurrency) {
+        PollSettings run_settings = settings;
+        run_settings.concurrency = concurrency;
+        RunResult result = run(units - hung, hung, run_settings);
+        out << std::setw(5) << units << std::setw(6) << hung << std::setw(13) << concurrency
+            << std::fixed << std::setprecision(2) << std::setw(15) << result.first_round
+            << std::setw(9) << result.cycle << std::setprecision(0) << std::setw(9) << result.polls_per_second
+            << std::endl;
+        failures += result.failures;
+    };
+
+    // One request at a time, as the poller used to, for comparison
+    report(25, 2, 1);
+    for (int units = 25; units <= max_units; units *= 2) {
+        report(units, 0, settings.concurrency);
+        report(units, units / 10, settings.concurrency);
+    }
+
+    std::cout.rdbuf(out.rdbuf());
+    curl_global_cleanup();
+    if (failures) {
+        return 1;
+    }
+    std::cout << "PASS poller_bench\n";
+    return 0;
+}
@@ -0,0 +1,227 @@
+/*
+ * WebServer latency and throughput benchmark
+ * Client threads on loopback against the epoll server with trivial handlers, so the numbers are the
+ * server's own overhead: small and large responses on keep-alive connections, a new connection per
+ * request, shared asset bodies, and POST bodies far larger than one read. Every response is checked.
+ */
+
+#include "tools/web_interface/web_server.h"
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <algorithm>
+#include <csignal>
+#include <cstdlib>
+#include <unistd.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+
+using Clock = std::chrono::steady_clock;
+
+static const std::string big_body(75000, 'x');   // About the size of the dashboard script
+static const auto asset_body = std::make_shared<const std::string>(20000, 'a');
+
+// A port nothing is listening on, for the server to bind
+static int free_port() {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t length = sizeof(addr);
+    bind(fd, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr));
+    getsockname(fd, reinterpret_cast<struct sockaddr*>(&addr), &length);
+    close(fd);
+    return ntohs(addr.sin_port);
+}
+
+static int connect_to(int port) {
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    struct sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (connect(fd, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) == -1) {
+        close(fd);
+        return -1;
+    }
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    return fd;
+}
+
+// Read one response framed by Content-Length into body; leftover bytes stay in buffer
+static bool read_response(int fd, std::string& buffer, std::string& body) {
+    char chunk[65536];
+    while (true) {
+        size_t header_end = buffer.find("\r\n\r\n");
+        if (header_end != std::string::npos) {
+            size_t length_at = buffer.find("Content-Length: ");
+            if (length_at == std::string::npos || length_at > header_end) return false;
+            size_t length = std::strtoul(buffer.c_str() + length_at + 16, nullptr, 10);
+            if (buffer.size() >= header_end + 4 + length) {
+                body.assign(buffer, header_end + 4, length);
+                buffer.erase(0, header_end + 4 + length);
+                return true;
+            }
+        }
+        ssize_t n = recv(fd, chunk, sizeof(chunk), 0);
+        if (n <= 0) return false;
+        buffer.append(chunk, n);
+    }
+}
+
+struct Scenario {
+    std::string name;
+    std::string request;
+    std::string expected_body;
+    int clients;
+    bool keep_alive;
+};
+
+// Each client sends its request back to back for the duration; returns the number of failures
+static int run(int port, const Scenario& scenario, double seconds, std::ostream& out) {
+    std::vector<std::vector<double>> latencies(scenario.clients);
+    std::atomic<int> errors{0};
+    auto end = Clock::now() + std::chrono::duration<double>(seconds);
+
+    std::vector<std::thread> clients;
+    for (int c = 0; c < scenario.clients; ++c) {
+        clients.emplace_back([&, c]() {
+            int fd = -1;
+            std::string buffer, body;
+            while (Clock::now() < end) {
+                auto start = Clock::now();
+                if (fd == -1) {
+                    fd = connect_to(port);
+                    buffer.clear();
+                    if (fd == -1) {
+                        errors++;
+                        continue;
+                    }
+                }
+                const std::string& request = scenario.request;
+                size_t sent = 0;
+                while (sent < request.size()) {
+                    ssize_t n = send(fd, request.data() + sent, request.size() - sent, MSG_NOSIGNAL);
+                    if (n <= 0) break;
+                    sent += n;
+                }
+                if (sent < request.size() || !read_response(fd, buffer, body) || body != scenario.expected_body) {
+                    errors++;
+                    close(fd);
+                    fd = -1;
+                    continue;
+                }
+                latencies[c].push_back(std::chrono::duration<double, std::milli>(Clock::now() - start).count());
+                if (!scenario.keep_alive) {
+                    close(fd);
+                    fd = -1;
+                }
+            }
+            if (fd != -1) close(fd);
+        });
+    }
+    for (std::thread& client : clients) {
+        client.join();
+    }
+
+    std::vector<double> all;
+    for (const auto& client : latencies) {
+        all.insert(all.end(), client.begin(), client.end());
+    }
+    std::sort(all.begin(), all.end());
+    out << std::left << std::setw(24) << scenario.name << std::right << std::setw(8) << scenario.clients
+        << std::setw(11) << (scenario.keep_alive ? "keep-alive" : "close") << std::fixed << std::setprecision(0)
+        << std::setw(10) << all.size() / seconds << std::setprecision(2)
+        << std::setw(10) << (all.empty() ? 0.0 : all[all.size() / 2])
+        << std::setw(10) << (all.empty() ? 0.0 : all[all.size() * 99 / 100])
+        << std::setw(8) << errors << std::endl;
+    if (all.empty()) {
+        std::cerr << "FAIL " << scenario.name << ": no responses\n";
+        return 1;
+    }
+    if (errors) {
+        std::cerr << "FAIL " << scenario.name << ": " << errors << " failed requests\n";
+        return 1;
+    }
+    return 0;
+}
+
+int main(int argc, char* argv[]) {
+    double seconds = argc > 1 ? std::atof(argv[1]) : 2.0;
+    std::signal(SIGPIPE, SIG_IGN);
+
+    // The server logs every request to stdout; keep the table readable
+    std::ostream out(std::cout.rdbuf());
+    std::ofstream discard("/dev/null");
+    std::cout.rdbuf(discard.rdbuf());
+
+    int port = free_port();
+    WebServer server(port);
+    server.set_get_handler([](const std::string& path, const std::string&) {
+        std::string body = path == "/big" ? big_body : "{\"ok\":true}";
+        return "HTTP/1.1 200 OK\r\nContent-Type: application/json\r\n\r\n" + body;
+    });
+    server.set_post_handler([](const std::string&, const std::string& body) {
+        return "HTTP/1.1 200 OK\r\nContent-Type: application/json\r\n\r\n{\"received\":" +
+               std::to_string(body.size()) + "}";
+    });
+    server.set_asset_handler([](const std::string& path, const std::string&, WebServer::SharedResponse& response) {
+        if (path != "/static/script.js") return false;
+        response.head = "HTTP/1.1 200 OK\r\nContent-Type: application/javascript\r\nContent-Length: " +
+                        std::to_string(asset_body->size());
+        response.body = asset_body;
+        return true;
+    });
+    server.start();
+
+    // The listening socket is opened on the server thread
+    int probe = -1;
+    for (int i = 0; i < 200 && (probe = connect_to(port)) == -1; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    if (probe == -1) {
+        std::cerr << "FAIL server never listened on port " << port << "\n";
+        return 1;
+    }
+    close(probe);
+
+    auto get = [](const std::string& path) { return "GET " + path + " HTTP/1.1\r\nHost: bench\r\n\r\n"; };
+    std::string post_body(256 * 1024, 'p');
+    std::string post = "POST /api/v1/setpoint HTTP/1.1\r\nHost: bench\r\nContent-Length: " +
+                       std::to_string(post_body.size()) + "\r\n\r\n" + post_body;
+    std::string received = "{\"received\":" + std::to_string(post_body.size()) + "}";
+
+    const std::vector<Scenario> scenarios = {
+        {"GET small", get("/api/units"), "{\"ok\":true}", 1, true},
+        {"GET small", get("/api/units"), "{\"ok\":true}", 32, true},
+        {"GET small, new conn", get("/api/units"), "{\"ok\":true}", 1, false},
+        {"GET small, new conn", get("/api/units"), "{\"ok\":true}", 32, false},
+        {"GET 75 KB", get("/big"), big_body, 8, true},
+        {"GET shared asset 20 KB", get("/static/script.js"), *asset_body, 8, true},
+        {"POST 256 KB", post, received, 8, true},
+    };
+
+    out << std::left << std::setw(24) << "scenario" << std::right << std::setw(8) << "clients"
+        << std::setw(11) << "conn" << std::setw(10) << "req/s" << std::setw(10) << "p50 ms"
+        << std::setw(10) << "p99 ms" << std::setw(8) << "errors" << std::endl;
+    int failures = 0;
+    for (const Scenario& scenario : scenarios) {
+        failures += run(port, scenario, seconds, out);
+    }
+
+    server.stop();
+    std::cout.rdbuf(out.rdbuf());
+    if (failures) {
+        return 1;
+    }
+    std::cout << "PASS web_server_bench\n";
+    return 0;
+}
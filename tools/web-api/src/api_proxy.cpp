@@ -13,24 +13,43 @@ static size_t api_proxy_curl_write_callback(void* contents, size_t size, size_t
     return size * nmemb;
 }
 
-APIProxy::APIProxy() {
+APIProxy::APIProxy(ConnectionCache* connections) : connections_(connections) {
 }
 
 APIProxy::~APIProxy() {
 }
 
 json APIProxy::call_unit_api(const Unit& unit, const std::string& endpoint) {
-    std::string url = "https://" + unit.api_address + ":" + std::to_string(unit.api_port) + "/api/v1" + endpoint;
-    return perform_http_request(url, "GET", "", unit.api_key);
+    return perform_http_request(unit, endpoint, "GET", "");
+}
+
+json APIProxy::get_snapshot(const Unit& unit, const std::string& fields) {
+    return perform_http_request(unit, "/snapshot?fields=" + fields, "GET", "");
 }
 
 json APIProxy::get_system_info(const Unit& unit) {
-    // Fetch both status and system-info for complete data
-    std::string base_url = "https://" + unit.api_address + ":" + std::to_string(unit.api_port) + "/api/v1";
+    // One request for status, config and demo mode, flattened into the shape the web UI expects
+    json snapshot = get_snapshot(unit, "status,config,demo");
+    if (snapshot.is_object() && snapshot.contains("status") && snapshot["status"].is_object()) {
+        json info = snapshot["status"];
+        if (snapshot.contains("config") && snapshot["config"].is_object()) {
+            for (auto& el : snapshot["config"].items()) {
+                info[el.key()] = el.value();
+            }
+        }
+        info["demo_mode"] = snapshot.value("demo_mode", false);
+        info["timestamp"] = snapshot.value("timestamp", static_cast<long>(std::time(nullptr)));
+        if (snapshot.contains("state_version")) {
+            info["state_version"] = snapshot["state_version"];
+        }
+        return info;
+    }
 
-    json status = perform_http_request(base_url + "/status", "GET", "", unit.api_key);
-    json config = perform_http_request(base_url + "/system-info", "GET", "", unit.api_key);
-    json demo_data = perform_http_request(base_url + "/demo-mode", "GET", "", unit.api_key);
+    // Units without /snapshot: fetch status, system-info and demo mode separately
+    write_log("APIProxy: Unit " + unit.id + " has no /snapshot endpoint, using separate requests");
+    json status = perform_http_request(unit, "/status", "GET", "");
+    json config = perform_http_request(unit, "/system-info", "GET", "");
+    json demo_data = perform_http_request(unit, "/demo-mode", "GET", "");
 
     if (status.is_object()) {
         // Merge config and demo data into status
@@ -47,18 +66,15 @@ json APIProxy::get_system_info(const Unit& unit) {
 }
 
 json APIProxy::get_status(const Unit& unit) {
-    std::string url = "https://" + unit.api_address + ":" + std::to_string(unit.api_port) + "/api/v1/status";
-    return perform_http_request(url, "GET", "", unit.api_key);
+    return perform_http_request(unit, "/status", "GET", "");
 }
 
 json APIProxy::get_demo_mode(const Unit& unit) {
-    std::string url = "https://" + unit.api_address + ":" + std::to_string(unit.api_port) + "/api/v1/demo-mode";
-    return perform_http_request(url, "GET", "", unit.api_key);
+    return perform_http_request(unit, "/demo-mode", "GET", "");
 }
 
 json APIProxy::get_logs(const Unit& unit) {
-    std::string url = "https://" + unit.api_address + ":" + std::to_string(unit.api_port) + "/api/v1/logs";
-    return perform_http_request(url, "GET", "", unit.api_key);
+    return perform_http_request(unit, "/logs", "GET", "");
 }
 
 std::string APIProxy::format_error_response(const std::string& error) {
@@ -74,19 +90,22 @@ std::string APIProxy::format_success_response(const json& data) {
     return response.dump();
 }
 
-json APIProxy::perform_http_request(const std::string& url, const std::string& method,
-                                    const std::string& body, const std::string& api_key) {
-    CURL* curl = curl_easy_init();
+json APIProxy::perform_http_request(const Unit& unit, const std::string& endpoint, const std::string& method,
+                                    const std::string& body) {
+    CURL* curl = connections_->acquire(unit);
     if (!curl) {
         write_log("APIProxy: Failed to initialize CURL");
         return json::object();
     }
 
+    std::string url = "https://" + unit.api_address + ":" + std::to_string(unit.api_port) + "/api/v1" + endpoint;
     std::string response_string;
 
     struct curl_slist* headers = nullptr;
-    headers = curl_slist_append(headers, ("X-API-Key: " + api_key).c_str());
+    headers = curl_slist_append(headers, ("X-API-Key: " + unit.api_key).c_str());
     headers = curl_slist_append(headers, "Content-Type: application/json");
+    // CBOR is smaller and cheaper to parse; units that don't support it answer with JSON
+    headers = curl_slist_append(headers, "Accept: application/cbor, application/json");
 
     curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
     curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
@@ -112,8 +131,12 @@ json APIProxy::perform_http_request(const std::string& url, const std::string& m
 
     CURLcode res = curl_easy_perform(curl);
 
+    char* content_type = nullptr;
+    curl_easy_getinfo(curl, CURLINFO_CONTENT_TYPE, &content_type);
+    bool is_cbor = content_type && std::string(content_type).find("application/cbor") == 0;
+
     curl_slist_free_all(headers);
-    curl_easy_cleanup(curl);
+    connections_->release(unit, curl);
 
     if (res != CURLE_OK) {
         write_log("APIProxy: ERROR - Failed to call API: " + std::string(curl_easy_strerror(res)));
@@ -122,6 +145,9 @@ json APIProxy::perform_http_request(const std::string& url, const std::string& m
 
     try {
         write_log("APIProxy: Response received, size: " + std::to_string(response_string.length()));
+        if (is_cbor) {
+            return json::from_cbor(response_string);
+        }
         return json::parse(response_string);
     } catch (const std::exception& e) {
         write_log("APIProxy: ERROR - Invalid JSON response: " + std::string(e.what()));
@@ -130,31 +156,26 @@ json APIProxy::perform_http_request(const std::string& url, const std::string& m
 }
 
 json APIProxy::set_demo_mode(const Unit& unit, const json& data) {
-    std::string url = "https://" + unit.api_address + ":" + std::to_string(unit.api_port) + "/api/v1/demo-mode";
     std::string body = data.dump();
-    return perform_http_request(url, "POST", body, unit.api_key);
+    return perform_http_request(unit, "/demo-mode", "POST", body);
 }
 
 json APIProxy::set_setpoint(const Unit& unit, const json& data) {
-    std::string url = "https://" + unit.api_address + ":" + std::to_string(unit.api_port) + "/api/v1/setpoint";
     std::string body = data.dump();
-    return perform_http_request(url, "POST", body, unit.api_key);
+    return perform_http_request(unit, "/setpoint", "POST", body);
 }
 
 json APIProxy::set_config(const Unit& unit, const json& data) {
-    std::string url = "https://" + unit.api_address + ":" + std::to_string(unit.api_port) + "/api/v1/config";
     std::string body = data.dump();
-    return perform_http_request(url, "POST", body, unit.api_key);
+    return perform_http_request(unit, "/config", "POST", body);
 }
 
 json APIProxy::reset_alarms(const Unit& unit) {
-    std::string url = "https://" + unit.api_address + ":" + std::to_string(unit.api_port) + "/api/v1/alarms/reset";
-    return perform_http_request(url, "POST", "", unit.api_key);
+    return perform_http_request(unit, "/alarms/reset", "POST", "");
 }
 
 json APIProxy::trigger_defrost(const Unit& unit) {
-    std::string url = "https://" + unit.api_address + ":" + std::to_string(unit.api_port) + "/api/v1/defrost/trigger";
-    return perform_http_request(url, "POST", "", unit.api_key);
+    return perform_http_request(unit, "/defrost/trigger", "POST", "");
 }
 
 void APIProxy::write_log(const std::string& message) {
@@ -18,6 +18,10 @@
 #include <chrono>
 #include <ctime>
 #include <iomanip>
+#include <cctype>
+#include <cstdlib>
+#include <cmath>
+#include <algorithm>
 #include <curl/curl.h>
 
 // CURL callback for downloading file data
@@ -26,13 +30,69 @@ static size_t web_interface_curl_write_callback(void* contents, size_t size, siz
     return size * nmemb;
 }
 
+// Value of a request header (name in lower case), empty if absent
+static std::string request_header(const std::string& request, const std::string& name) {
+    std::string lower = request.substr(0, request.find("\r\n\r\n"));
+    for (char& c : lower) c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    size_t header = lower.find("\r\n" + name + ":");
+    if (header == std::string::npos) {
+        return "";
+    }
+    size_t start = lower.find_first_not_of(' ', header + name.length() + 3);
+    size_t end = lower.find("\r\n", header + 2);
+    if (start == std::string::npos || (end != std::string::npos && start >= end)) {
+        return "";
+    }
+    // Values keep their case (ETags are case-sensitive)
+    return request.substr(start, end == std::string::npos ? std::string::npos : end - start);
+}
+
+// Whether the browser's Accept-Encoding allows a gzip body
+static bool browser_accepts_gzip(const std::string& request) {
+    std::string value = request_header(request, "accept-encoding");
+    for (char& c : value) c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    size_t gzip = value.find("gzip");
+    if (gzip == std::string::npos) {
+        return false;
+    }
+    size_t q = value.find(";q=", gzip);
+    if (q != std::string::npos && q == value.find_first_not_of(' ', gzip + 4)) {
+        return std::atof(value.c_str() + q + 3) > 0.0;
+    }
+    return true;
+}
+
+// Value of name=... in a query string, empty if absent
+static std::string query_param(const std::string& query_string, const std::string& name) {
+    size_t pos = 0;
+    while (pos < query_string.length()) {
+        size_t end = query_string.find('&', pos);
+        if (end == std::string::npos) end = query_string.length();
+        if (query_string.compare(pos, name.length(), name) == 0 && pos + name.length() < end &&
+            query_string[pos + name.length()] == '=') {
+            return query_string.substr(pos + name.length() + 1, end - pos - name.length() - 1);
+        }
+        pos = end + 1;
+    }
+    return "";
+}
+
+// Longest range a history query may cover, and the bucket count aimed for when no step is given
+static constexpr std::time_t history_max_range_seconds = 366 * 24 * 3600;
+static constexpr int history_default_buckets = 288;
+
 APIWebInterface::APIWebInterface(const std::string& config_file)
     : config_file_(config_file), running_(false) {
 
     // Initialize components
     config_manager_ = std::make_unique<ConfigManager>(config_file);
     web_server_ = std::make_unique<WebServer>(config_manager_->get_web_port());
-    unit_poller_ = std::make_unique<UnitPoller>();
+    connection_cache_ = std::make_unique<ConnectionCache>();
+    unit_poller_ = std::make_unique<UnitPoller>(connection_cache_.get());
+    unit_history_ = std::make_unique<UnitHistory>(
+        config_manager_->get_history_dir(),
+        config_manager_->get_history_retention_days()
+    );
     email_notifier_ = std::make_unique<EmailNotifier>(
         config_manager_->get_email_server(),
         config_manager_->get_email_port(),
@@ -41,8 +101,12 @@ APIWebInterface::APIWebInterface(const std::string& config_file)
     );
     // Connect email notifier to unit poller for alarm notifications
     unit_poller_->set_email_notifier(email_notifier_.get());
+    unit_poller_->set_poll_settings(config_manager_->get_poll_settings());
+    // Record every polled status for /api/unit/{id}/history
+    unit_poller_->set_history(unit_history_.get());
 
-    api_proxy_ = std::make_unique<APIProxy>();
+    api_proxy_ = std::make_unique<APIProxy>(connection_cache_.get());
+    asset_cache_ = std::make_unique<AssetCache>();
 
     write_log("APIWebInterface: Initialized with config from " + config_file);
 }
@@ -59,13 +123,16 @@ void APIWebInterface::start() {
     running_ = true;
     write_log("APIWebInterface: Starting components...");
 
+    // Alarm emails are queued by the poller and sent from the notifier's own thread
+    email_notifier_->start();
+
     // Get units from config manager
-    auto& units = config_manager_->get_units();
+    auto units = config_manager_->get_units();
     unit_poller_->start(units);
 
     // Set up web server handlers
-    web_server_->set_get_handler([this](const std::string& path) {
-        return handle_get_request(path);
+    web_server_->set_get_handler([this](const std::string& path, const std::string& request) {
+        return handle_get_request(path, request);
     });
 
     web_server_->set_post_handler([this](const std::string& path, const std::string& body) {
@@ -76,7 +143,18 @@ void APIWebInterface::start() {
         return verify_password(password);
     });
 
-    // Start config file watcher
+    // Templates and static files are served from memory, reloaded when they change on disk
+    asset_cache_->load();
+    asset_cache_->start_watch_thread();
+    web_server_->set_asset_handler([this](const std::string& path, const std::string& request,
+                                          WebServer::SharedResponse& response) {
+        return handle_asset_request(path, request, response);
+    });
+
+    // Start config file watcher; unit changes are applied to the running poller
+    config_manager_->set_on_config_changed([this]() {
+        on_config_changed();
+    });
     config_manager_->start_watch_thread();
 
     // Start web server
@@ -94,8 +172,10 @@ void APIWebInterface::stop() {
     write_log("APIWebInterface: Stopping components...");
 
     unit_poller_->stop();
+    email_notifier_->stop();
     config_manager_->stop_watch_thread();
     web_server_->stop();
+    asset_cache_->stop_watch_thread();
 
     write_log("APIWebInterface: All components stopped");
 }
@@ -104,114 +184,98 @@ bool APIWebInterface::verify_password(const std::string& password) {
     return password == config_manager_->get_web_password();
 }
 
-std::string APIWebInterface::handle_get_request(const std::string& path) {
+std::string APIWebInterface::handle_get_request(const std::string& path, const std::string& request) {
     write_log("APIWebInterface: GET request to " + path);
 
-    // Handle static file requests
+    // Static files and the template come from the asset cache; getting here means it doesn't have them
     if (path.find("/static/") == 0) {
-        std::string file_path = path.substr(8);  // Remove "/static/"
-
-        // Security: prevent directory traversal
-        if (file_path.find("..") != std::string::npos) {
-            return "HTTP/1.1 403 Forbidden\r\nContent-Type: text/plain\r\n\r\nForbidden";
-        }
-
-        // Try multiple locations for the static file
-        std::string file_locations[] = {
-            "/usr/share/web-api/static/" + file_path
-        };
-
-        for (const auto& loc : file_locations) {
-            std::ifstream file(loc, std::ios::binary);
-            if (file.is_open()) {
-                std::stringstream buffer;
-                buffer << file.rdbuf();
-                std::string content = buffer.str();
-                file.close();
-
-                // Determine content type
-                std::string content_type = "application/octet-stream";
-                if (file_path.find(".css") != std::string::npos) {
-                    content_type = "text/css; charset=utf-8";
-                } else if (file_path.find(".js") != std::string::npos) {
-                    content_type = "application/javascript; charset=utf-8";
-                }
-
-                std::ostringstream response;
-                response << "HTTP/1.1 200 OK\r\n"
-                        << "Content-Type: " << content_type << "\r\n"
-                        << "Content-Length: " << content.length() << "\r\n"
-                        << "Connection: close\r\n"
-                        << "\r\n"
-                        << content;
-                return response.str();
-            }
-        }
-
         write_log("Static file not found: " + path);
         return "HTTP/1.1 404 Not Found\r\nContent-Type: text/plain\r\n\r\nNot Found";
     }
 
     if (path == "/" || path == "/index.html") {
-        std::string template_locations[] = {
-            "/usr/share/web-api/templates/index.html"
-        };
-
-        std::string html;
-        bool template_found = false;
-
-        for (const auto& loc : template_locations) {
-            std::ifstream file(loc);
-            if (file.is_open()) {
-                std::stringstream buffer;
-                buffer << file.rdbuf();
-                html = buffer.str();
-                file.close();
-                template_found = true;
-                break;
-            }
+        std::string error_page = "<html><body><h1>Error</h1><p>HTML template not found</p></body></html>";
+        std::ostringstream response;
+        response << "HTTP/1.1 500 Internal Server Error\r\n"
+                << "Content-Type: text/html; charset=utf-8\r\n"
+                << "Content-Length: " << error_page.length() << "\r\n"
+                << "Connection: close\r\n"
+                << "\r\n"
+                << error_page;
+        return response.str();
+    } else if (path.compare(0, 16, "/api/units?since") == 0) {
+        // Only the units whose status changed after the given version, plus removed IDs
+        std::shared_ptr<const UnitsSnapshot> snapshot = unit_poller_->get_units_snapshot();
+        uint64_t since = 0;
+        try {
+            since = std::stoull(query_param(path.substr(11), "since"));
+        } catch (...) {
+            since = 0;  // Unparseable: send everything
         }
 
-        if (!template_found) {
-            std::string error_page = "<html><body><h1>Error</h1><p>HTML template not found</p></body></html>";
-            std::ostringstream response;
-            response << "HTTP/1.1 500 Internal Server Error\r\n"
-                    << "Content-Type: text/html; charset=utf-8\r\n"
-                    << "Content-Length: " << error_page.length() << "\r\n"
-                    << "Connection: close\r\n"
-                    << "\r\n"
-                    << error_page;
-            return response.str();
+        std::string body = snapshot->delta_body(since);
+        std::ostringstream oss;
+        oss << "HTTP/1.1 200 OK\r\n"
+            << "Content-Type: application/json\r\n"
+            << "Cache-Control: no-store\r\n"
+            << "Content-Length: " << body.length() << "\r\n"
+            << "Connection: close\r\n"
+            << "\r\n"
+            << body;
+        return oss.str();
+    } else if (path == "/api/units") {
+        // Pre-serialized by the poller whenever a unit's status changes
+        std::shared_ptr<const UnitsSnapshot> snapshot = unit_poller_->get_units_snapshot();
+        std::string if_none_match = request_header(request, "if-none-match");
+        if (!if_none_match.empty() && if_none_match.find(snapshot->etag) != std::string::npos) {
+            return "HTTP/1.1 304 Not Modified\r\nETag: " + snapshot->etag +
+                   "\r\nCache-Control: no-cache\r\nConnection: close\r\n\r\n";
         }
 
-        std::ostringstream response;
-        response << "HTTP/1.1 200 OK\r\n"
-                 << "Content-Type: text/html; charset=utf-8\r\n"
-                 << "Content-Length: " << html.length() << "\r\n"
-                 << "Connection: close\r\n"
-                 << "\r\n"
-                 << html;
-        return response.str();
-    } else if (path == "/api/units") {
+        std::string response;
+        response.reserve(snapshot->body.length() + 160);
+        response += "HTTP/1.1 200 OK\r\n"
+                    "Content-Type: application/json\r\n"
+                    "Cache-Control: no-cache\r\n"
+                    "ETag: ";
+        response += snapshot->etag;
+        response += "\r\nContent-Length: " + std::to_string(snapshot->body.length());
+        response += "\r\nConnection: close\r\n\r\n";
+        response += snapshot->body;
+        return response;
+    } else if (path == "/api/schedule") {
+        // When each unit is polled next and why; changes every second, so it's kept out of /api/units
         json response;
-        auto& units = config_manager_->get_units();
-
-        // Use cached data from UnitPoller for fast response
-        json all_units = unit_poller_->get_all_unit_data();
-        json unit_configs;
+        response["unit_schedule"] = unit_poller_->get_schedule();
+        response["timestamp"] = std::time(nullptr);
 
-        for (const auto& unit : units) {
-            // If no cached data, mark as offline
-            if (!all_units.contains(unit.id) || all_units[unit.id].empty()) {
-                all_units[unit.id]["system_status"] = "Offline";
-            }
-            // Optionally, you can cache configs in UnitPoller as well, but for now, leave empty
-            unit_configs[unit.id] = json::object();
-        }
+        std::string body = response.dump();
+        std::ostringstream oss;
+        oss << "HTTP/1.1 200 OK\r\n"
+            << "Content-Type: application/json\r\n"
+            << "Content-Length: " << body.length() << "\r\n"
+            << "Connection: close\r\n"
+            << "\r\n"
+            << body;
+        return oss.str();
+    } else if (path == "/api/connections") {
+        // Requests, new connections and TLS handshakes per unit since startup
+        json response;
+        response["units"] = connection_cache_->get_stats();
+        response["timestamp"] = std::time(nullptr);
 
-        response["unit_data"] = all_units;
-        response["unit_configs"] = unit_configs;
-        response["unit_count"] = units.size();
+        std::string body = response.dump();
+        std::ostringstream oss;
+        oss << "HTTP/1.1 200 OK\r\n"
+            << "Content-Type: application/json\r\n"
+            << "Content-Length: " << body.length() << "\r\n"
+            << "Connection: close\r\n"
+            << "\r\n"
+            << body;
+        return oss.str();
+    } else if (path == "/api/notifications") {
+        // Email queue depth and delivery counters
+        json response = email_notifier_->get_stats();
         response["timestamp"] = std::time(nullptr);
 
         std::string body = response.dump();
@@ -231,9 +295,15 @@ std::string APIWebInterface::handle_get_request(const std::string& path) {
         if (next_slash != std::string::npos) {
             std::string unit_id = path.substr(10, next_slash - 10);
             std::string endpoint = path.substr(next_slash);
+            std::string query_string;
+            size_t query_start = endpoint.find('?');
+            if (query_start != std::string::npos) {
+                query_string = endpoint.substr(query_start + 1);
+                endpoint = endpoint.substr(0, query_start);
+            }
 
             // Find the unit
-            auto& units = config_manager_->get_units();
+            auto units = config_manager_->get_units();
             Unit target_unit{"", "", 0, ""};
             bool found = false;
             for (const auto& unit : units) {
@@ -258,28 +328,22 @@ std::string APIWebInterface::handle_get_request(const std::string& path) {
                 return oss.str();
             }
 
+            if (endpoint == "/history") {
+                // Served from the samples the poller recorded; never calls the unit
+                return handle_unit_history_request(unit_id, query_string);
+            }
+
+            // Someone is looking at this unit; bring its cached status up to date
+            unit_poller_->request_poll(unit_id);
+
             // Route to specific endpoints
             if (endpoint == "/system-info") {
+                // Status, config and demo mode in one call to the unit
                 json system_info = api_proxy_->get_system_info(target_unit);
                 if (system_info.is_null() || system_info.empty()) {
                     system_info = json::object();
                 }
 
-                // Also add demo mode status and current status
-                json demo_mode = api_proxy_->get_demo_mode(target_unit);
-                if (!demo_mode.is_null() && demo_mode.contains("demo_mode")) {
-                    system_info["demo_mode"] = demo_mode["demo_mode"];
-                }
-
-                json status = api_proxy_->get_status(target_unit);
-                if (!status.is_null() && status.is_object()) {
-                    for (auto& el : status.items()) {
-                        if (system_info.find(el.key()) == system_info.end()) {
-                            system_info[el.key()] = el.value();
-                        }
-                    }
-                }
-
                 std::string response_body = system_info.dump();
                 std::ostringstream oss;
                 oss << "HTTP/1.1 200 OK\r\n"
@@ -351,7 +415,7 @@ std::string APIWebInterface::handle_get_request(const std::string& path) {
             return "HTTP/1.1 400 Bad Request\r\nContent-Type: application/json\r\n\r\n{\"error\": \"Missing 'date' parameter. Use ?date=YYYY-MM-DD\"}";
         }
 
-        return handle_download_events_request(date);
+        return handle_download_events_request(date, browser_accepts_gzip(request));
     }
 
     // Handle /api/v1/logs/conditions download endpoint
@@ -380,12 +444,137 @@ std::string APIWebInterface::handle_get_request(const std::string& path) {
             return "HTTP/1.1 400 Bad Request\r\nContent-Type: application/json\r\n\r\n{\"error\": \"Missing 'date' parameter. Use ?date=YYYY-MM-DD\"}";
         }
 
-        return handle_download_conditions_request(date);
+        return handle_download_conditions_request(date, browser_accepts_gzip(request));
     }
 
     return "HTTP/1.1 404 Not Found\r\nContent-Type: text/plain\r\n\r\nNot Found";
 }
 
+bool APIWebInterface::handle_asset_request(const std::string& path, const std::string& request,
+                                           WebServer::SharedResponse& response) {
+    std::shared_ptr<const CachedAsset> asset = asset_cache_->find(path);
+    if (!asset) {
+        return false;
+    }
+
+    bool gzip = asset->gzip_body && browser_accepts_gzip(request);
+    const std::string& etag = gzip ? asset->gzip_etag : asset->etag;
+    std::string if_none_match = request_header(request, "if-none-match");
+    if (!if_none_match.empty() && (if_none_match == "*" || if_none_match.find(etag) != std::string::npos)) {
+        response.head = gzip ? asset->gzip_not_modified_head : asset->not_modified_head;
+        return true;
+    }
+
+    response.head = gzip ? asset->gzip_head : asset->head;
+    response.body = gzip ? asset->gzip_body : asset->body;
+    return true;
+}
+
+std::string APIWebInterface::handle_unit_history_request(const std::string& unit_id, const std::string& query_string) {
+    auto error = [](const std::string& message) {
+        json error_response;
+        error_response["error"] = message;
+        std::string body = error_response.dump();
+        std::ostringstream oss;
+        oss << "HTTP/1.1 400 Bad Request\r\n"
+            << "Content-Type: application/json\r\n"
+            << "Content-Length: " << body.length() << "\r\n"
+            << "Connection: close\r\n"
+            << "\r\n"
+            << body;
+        return oss.str();
+    };
+
+    std::time_t to;
+    std::time_t from;
+    int step;
+    try {
+        std::string to_param = query_param(query_string, "to");
+        std::string from_param = query_param(query_string, "from");
+        std::string step_param = query_param(query_string, "step");
+        to = to_param.empty() ? std::time(nullptr) : static_cast<std::time_t>(std::stoll(to_param));
+        from = from_param.empty() ? to - 24 * 3600 : static_cast<std::time_t>(std::stoll(from_param));
+        step = step_param.empty() ? 0 : std::stoi(step_param);
+    } catch (...) {
+        return error("Invalid 'from', 'to' or 'step'. Use unix timestamps and seconds");
+    }
+    if (to <= from || to - from > history_max_range_seconds) {
+        return error("'from' must be before 'to' and the range at most 366 days");
+    }
+    if (step <= 0) {
+        step = std::max<int>(60, static_cast<int>((to - from + history_default_buckets - 1) / history_default_buckets));
+    }
+    if (static_cast<size_t>((to - from + step - 1) / step) > UnitHistory::max_buckets) {
+        return error("Too many buckets, use a larger 'step' (at most " +
+                     std::to_string(UnitHistory::max_buckets) + " buckets)");
+    }
+
+    std::string field_list = query_param(query_string, "fields");
+    if (field_list.empty()) {
+        field_list = "return,supply,coil,setpoint";
+    }
+    std::vector<SampleField> fields;
+    std::istringstream field_stream(field_list);
+    std::string name;
+    while (std::getline(field_stream, name, ',')) {
+        SampleField field;
+        if (name.empty()) continue;
+        if (!UnitHistory::parse_field(name, field)) {
+            return error("Unknown field '" + name + "'");
+        }
+        fields.push_back(field);
+    }
+
+    HistorySeries result = unit_history_->query(unit_id, from, to, step, fields);
+
+    // Same columnar shape as the unit's /api/v1/history: one array per aggregate, null for empty buckets
+    auto column = [](const std::vector<float>& values, const std::vector<uint32_t>& count) {
+        json array = json::array();
+        for (size_t b = 0; b < values.size(); ++b) {
+            if (count[b] == 0) {
+                array.push_back(nullptr);
+            } else {
+                array.push_back(std::round(values[b] * 100.0) / 100.0);
+            }
+        }
+        return array;
+    };
+
+    json response;
+    response["unit_id"] = unit_id;
+    response["from"] = result.from;
+    response["to"] = result.to;
+    response["step"] = result.step;
+    response["buckets"] = result.samples.size();
+    json times = json::array();
+    for (size_t b = 0; b < result.samples.size(); ++b) {
+        times.push_back(result.from + static_cast<std::time_t>(b) * result.step);
+    }
+    response["time"] = times;
+    response["samples"] = result.samples;
+    json series = json::object();
+    for (size_t f = 0; f < result.fields.size(); ++f) {
+        json columns;
+        columns["min"] = column(result.min[f], result.count[f]);
+        columns["avg"] = column(result.avg[f], result.count[f]);
+        columns["max"] = column(result.max[f], result.count[f]);
+        series[UnitHistory::field_name(result.fields[f])] = columns;
+    }
+    response["series"] = series;
+    response["source"] = result.source;
+    response["timestamp"] = std::time(nullptr);
+
+    std::string body = response.dump();
+    std::ostringstream oss;
+    oss << "HTTP/1.1 200 OK\r\n"
+        << "Content-Type: application/json\r\n"
+        << "Content-Length: " << body.length() << "\r\n"
+        << "Connection: close\r\n"
+        << "\r\n"
+        << body;
+    return oss.str();
+}
+
 std::string APIWebInterface::handle_post_request(const std::string& path, const std::string& body) {
     write_log("APIWebInterface: POST request to " + path);
 
@@ -423,7 +612,7 @@ std::string APIWebInterface::handle_post_request(const std::string& path, const
             std::string endpoint = path.substr(next_slash);
 
             // Find the unit
-            auto& units = config_manager_->get_units();
+            auto units = config_manager_->get_units();
             Unit target_unit{"", "", 0, ""};
             bool found = false;
             for (const auto& unit : units) {
@@ -451,6 +640,7 @@ std::string APIWebInterface::handle_post_request(const std::string& path, const
             // Route to specific endpoints
             if (endpoint == "/alarms/reset") {
                 json result = api_proxy_->reset_alarms(target_unit);
+                unit_poller_->request_poll(unit_id);  // Show the outcome without waiting for the schedule
                 if (result.is_null()) {
                     result = json::object();
                     result["success"] = true;
@@ -467,6 +657,7 @@ std::string APIWebInterface::handle_post_request(const std::string& path, const
                 return oss.str();
             } else if (endpoint == "/defrost/trigger") {
                 json result = api_proxy_->trigger_defrost(target_unit);
+                unit_poller_->request_poll(unit_id);  // Show the outcome without waiting for the schedule
                 if (result.is_null()) {
                     result = json::object();
                     result["success"] = true;
@@ -485,6 +676,7 @@ std::string APIWebInterface::handle_post_request(const std::string& path, const
                 try {
                     auto data = json::parse(body);
                     json result = api_proxy_->set_demo_mode(target_unit, data);
+                    unit_poller_->request_poll(unit_id);  // Show the outcome without waiting for the schedule
                     if (result.is_null()) {
                         result = json::object();
                         result["status"] = "sent";
@@ -505,6 +697,7 @@ std::string APIWebInterface::handle_post_request(const std::string& path, const
                 try {
                     auto data = json::parse(body);
                     json result = api_proxy_->set_setpoint(target_unit, data);
+                    unit_poller_->request_poll(unit_id);  // Show the outcome without waiting for the schedule
                     if (result.is_null()) {
                         result = json::object();
                         result["status"] = "setpoint_updated";
@@ -525,6 +718,7 @@ std::string APIWebInterface::handle_post_request(const std::string& path, const
                 try {
                     auto data = json::parse(body);
                     json result = api_proxy_->set_config(target_unit, data);
+                    unit_poller_->request_poll(unit_id);  // Show the outcome without waiting for the schedule
                     if (result.is_null()) {
                         result = json::object();
                         result["status"] = "config_updated";
@@ -587,13 +781,19 @@ std::string APIWebInterface::base64_encode(const std::string& input) {
     return result;
 }
 
+// Runs on the config watch thread after a reload. The web port and history folder are
+// only read at startup; everything else takes effect here.
 void APIWebInterface::on_config_changed() {
     write_log("APIWebInterface: Configuration changed, reloading...");
+    unit_poller_->set_poll_settings(config_manager_->get_poll_settings());
+    unit_poller_->update_units(config_manager_->get_units());
+    email_notifier_->set_server(config_manager_->get_email_server(), config_manager_->get_email_port());
+    email_notifier_->set_sender(config_manager_->get_email_address(), config_manager_->get_email_password());
 }
 
 void APIWebInterface::send_startup_email() {
     try {
-        auto& units = config_manager_->get_units();
+        auto units = config_manager_->get_units();
 
         // Format current time as MM-DD-YYYY HH:MM:SS
         auto now = std::chrono::system_clock::now();
@@ -623,13 +823,12 @@ void APIWebInterface::send_startup_email() {
         body << "Email Server: " << config_manager_->get_email_server() << ":";
         body << config_manager_->get_email_port() << "\n";
 
-        email_notifier_->send_email(
-            config_manager_->get_email_address(),
-            "Refrigeration API Web Interface Started",
-            body.str()
-        );
-
-        write_log("APIWebInterface: Startup email sent successfully");
+        if (email_notifier_->send_email(
+                config_manager_->get_email_address(),
+                "Refrigeration API Web Interface Started",
+                body.str())) {
+            write_log("APIWebInterface: Startup email queued");
+        }
     } catch (const std::exception& e) {
         write_log("APIWebInterface: Error sending startup email: " + std::string(e.what()));
     }
@@ -645,7 +844,7 @@ void APIWebInterface::write_log(const std::string& message) {
 
     std::cout << "[" << timestamp.str() << "] [APIWebInterface] " << message << std::endl;
 }
-std::string APIWebInterface::handle_download_events_request(const std::string& date) {
+std::string APIWebInterface::handle_download_events_request(const std::string& date, bool accept_gzip) {
     try {
         // Validate date format (YYYY-MM-DD)
         if (date.length() != 10 || date[4] != '-' || date[7] != '-') {
@@ -654,7 +853,7 @@ std::string APIWebInterface::handle_download_events_request(const std::string& d
         }
 
         // Get the first unit to download logs from
-        auto& units = config_manager_->get_units();
+        auto units = config_manager_->get_units();
         if (units.empty()) {
             write_log("APIWebInterface: No units configured");
             return "HTTP/1.1 404 Not Found\r\nContent-Type: application/json\r\n\r\n{\"error\": \"No units configured\"}";
@@ -664,19 +863,23 @@ std::string APIWebInterface::handle_download_events_request(const std::string& d
         std::string endpoint = "/api/v1/logs/events?date=" + date;
 
         // Use curl to download the file from the refrigeration API
-        CURL* curl = curl_easy_init();
+        const Unit& unit = units[0];
+        CURL* curl = connection_cache_->acquire(unit);
         if (!curl) {
             write_log("APIWebInterface: Failed to initialize CURL");
             return "HTTP/1.1 500 Internal Server Error\r\nContent-Type: application/json\r\n\r\n{\"error\": \"Failed to initialize download\"}";
         }
 
-        const Unit& unit = units[0];
         std::string url = "https://" + unit.api_address + ":" + std::to_string(unit.api_port) + endpoint;
         std::string api_key_header = "X-API-Key: " + unit.api_key;
 
         std::string file_content;
         struct curl_slist* headers = nullptr;
         headers = curl_slist_append(headers, api_key_header.c_str());
+        if (accept_gzip) {
+            // Ask for the unit's compressed copy and pass it through without decoding it here
+            headers = curl_slist_append(headers, "Accept-Encoding: gzip");
+        }
 
         curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
         curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
@@ -692,7 +895,7 @@ std::string APIWebInterface::handle_download_events_request(const std::string& d
         curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &http_code);
 
         curl_slist_free_all(headers);
-        curl_easy_cleanup(curl);
+        connection_cache_->release(unit, curl);
 
         if (res != CURLE_OK) {
             write_log("APIWebInterface: CURL error downloading events: " + std::string(curl_easy_strerror(res)));
@@ -708,6 +911,10 @@ std::string APIWebInterface::handle_download_events_request(const std::string& d
         std::string response = "HTTP/1.1 200 OK\r\n";
         response += "Content-Type: text/plain\r\n";
         response += "Content-Disposition: attachment; filename=\"events-" + date + ".log\"\r\n";
+        if (file_content.compare(0, 2, "\x1f\x8b") == 0) {
+            response += "Content-Encoding: gzip\r\n";
+        }
+        response += "Vary: Accept-Encoding\r\n";
         response += "Content-Length: " + std::to_string(file_content.length()) + "\r\n";
         response += "Connection: close\r\n";
         response += "\r\n";
@@ -720,7 +927,7 @@ std::string APIWebInterface::handle_download_events_request(const std::string& d
     }
 }
 
-std::string APIWebInterface::handle_download_conditions_request(const std::string& date) {
+std::string APIWebInterface::handle_download_conditions_request(const std::string& date, bool accept_gzip) {
     try {
         // Validate date format (YYYY-MM-DD)
         if (date.length() != 10 || date[4] != '-' || date[7] != '-') {
@@ -729,7 +936,7 @@ std::string APIWebInterface::handle_download_conditions_request(const std::strin
         }
 
         // Get the first unit to download logs from
-        auto& units = config_manager_->get_units();
+        auto units = config_manager_->get_units();
         if (units.empty()) {
             write_log("APIWebInterface: No units configured");
             return "HTTP/1.1 404 Not Found\r\nContent-Type: application/json\r\n\r\n{\"error\": \"No units configured\"}";
@@ -739,19 +946,23 @@ std::string APIWebInterface::handle_download_conditions_request(const std::strin
         std::string endpoint = "/api/v1/logs/conditions?date=" + date;
 
         // Use curl to download the file from the refrigeration API
-        CURL* curl = curl_easy_init();
+        const Unit& unit = units[0];
+        CURL* curl = connection_cache_->acquire(unit);
         if (!curl) {
             write_log("APIWebInterface: Failed to initialize CURL");
             return "HTTP/1.1 500 Internal Server Error\r\nContent-Type: application/json\r\n\r\n{\"error\": \"Failed to initialize download\"}";
         }
 
-        const Unit& unit = units[0];
         std::string url = "https://" + unit.api_address + ":" + std::to_string(unit.api_port) + endpoint;
         std::string api_key_header = "X-API-Key: " + unit.api_key;
 
         std::string file_content;
         struct curl_slist* headers = nullptr;
         headers = curl_slist_append(headers, api_key_header.c_str());
+        if (accept_gzip) {
+            // Ask for the unit's compressed copy and pass it through without decoding it here
+            headers = curl_slist_append(headers, "Accept-Encoding: gzip");
+        }
 
         curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
         curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
@@ -767,7 +978,7 @@ std::string APIWebInterface::handle_download_conditions_request(const std::strin
         curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &http_code);
 
         curl_slist_free_all(headers);
-        curl_easy_cleanup(curl);
+        connection_cache_->release(unit, curl);
 
         if (res != CURLE_OK) {
             write_log("APIWebInterface: CURL error downloading conditions: " + std::string(curl_easy_strerror(res)));
@@ -783,6 +994,10 @@ std::string APIWebInterface::handle_download_conditions_request(const std::strin
         std::string response = "HTTP/1.1 200 OK\r\n";
         response += "Content-Type: text/plain\r\n";
         response += "Content-Disposition: attachment; filename=\"conditions-" + date + ".log\"\r\n";
+        if (file_content.compare(0, 2, "\x1f\x8b") == 0) {
+            response += "Content-Encoding: gzip\r\n";
+        }
+        response += "Vary: Accept-Encoding\r\n";
         response += "Content-Length: " + std::to_string(file_content.length()) + "\r\n";
         response += "Connection: close\r\n";
         response += "\r\n";
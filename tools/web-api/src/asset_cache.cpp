@@ -0,0 +1,178 @@
+/*
+ * Asset Cache Implementation
+ */
+
+#include "../include/tools/web_interface/asset_cache.h"
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <ctime>
+#include <cstdio>
+#include <zlib.h>
+#include <sys/inotify.h>
+
+// Best-compression gzip; assets are compressed once per change, not per request
+static std::string gzip_compress(const std::string& data) {
+    z_stream stream{};
+    if (deflateInit2(&stream, Z_BEST_COMPRESSION, Z_DEFLATED, 15 + 16, 9, Z_DEFAULT_STRATEGY) != Z_OK) {
+        return "";
+    }
+    std::string out(deflateBound(&stream, data.size()), '\0');
+    stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data.data()));
+    stream.avail_in = static_cast<uInt>(data.size());
+    stream.next_out = reinterpret_cast<Bytef*>(&out[0]);
+    stream.avail_out = static_cast<uInt>(out.size());
+    int result = deflate(&stream, Z_FINISH);
+    out.resize(stream.total_out);
+    deflateEnd(&stream);
+    return result == Z_STREAM_END ? out : "";
+}
+
+// 64-bit FNV-1a of the content, as a quoted ETag
+static std::string content_etag(const std::string& data, const char* suffix) {
+    uint64_t hash = 14695981039346656037ULL;
+    for (unsigned char c : data) {
+        hash = (hash ^ c) * 1099511628211ULL;
+    }
+    char buffer[48];
+    std::snprintf(buffer, sizeof(buffer), "\"%zx-%016llx%s\"", data.size(), static_cast<unsigned long long>(hash), suffix);
+    return buffer;
+}
+
+AssetCache::AssetCache(const std::string& static_dir, const std::string& templates_dir)
+    : static_dir_(static_dir), templates_dir_(templates_dir), assets_(std::make_shared<const AssetMap>()) {
+}
+
+AssetCache::~AssetCache() {
+    stop_watch_thread();
+}
+
+std::string AssetCache::content_type_for(const std::string& name) {
+    std::string extension = std::filesystem::path(name).extension().string();
+    if (extension == ".css") return "text/css; charset=utf-8";
+    if (extension == ".js") return "application/javascript; charset=utf-8";
+    if (extension == ".html") return "text/html; charset=utf-8";
+    if (extension == ".json") return "application/json";
+    if (extension == ".svg") return "image/svg+xml";
+    if (extension == ".png") return "image/png";
+    if (extension == ".jpg" || extension == ".jpeg") return "image/jpeg";
+    if (extension == ".ico") return "image/x-icon";
+    return "application/octet-stream";
+}
+
+std::shared_ptr<const CachedAsset> AssetCache::build_asset(const std::string& content, const std::string& content_type,
+                                                           const std::string& cache_control) {
+    auto asset = std::make_shared<CachedAsset>();
+    asset->body = std::make_shared<const std::string>(content);
+    asset->etag = content_etag(content, "");
+
+    // Images are compressed already; text usually shrinks by two thirds or more
+    bool compressible = content_type.compare(0, 5, "text/") == 0 || content_type.compare(0, 12, "application/") == 0 ||
+                        content_type == "image/svg+xml";
+    if (compressible && content_type != "application/octet-stream") {
+        std::string compressed = gzip_compress(content);
+        if (!compressed.empty() && compressed.size() < content.size()) {
+            asset->gzip_body = std::make_shared<const std::string>(std::move(compressed));
+            asset->gzip_etag = content_etag(content, "-gz");
+        }
+    }
+
+    // Vary so a shared cache doesn't hand gzip to a client that didn't ask for it
+    std::string common = "Cache-Control: " + cache_control + "\r\n";
+    if (asset->gzip_body) {
+        common += "Vary: Accept-Encoding\r\n";
+    }
+    asset->head = "HTTP/1.1 200 OK\r\nContent-Type: " + content_type + "\r\nContent-Length: " +
+                  std::to_string(asset->body->size()) + "\r\nETag: " + asset->etag + "\r\n" + common;
+    asset->not_modified_head = "HTTP/1.1 304 Not Modified\r\nETag: " + asset->etag + "\r\n" + common;
+    if (asset->gzip_body) {
+        asset->gzip_head = "HTTP/1.1 200 OK\r\nContent-Type: " + content_type + "\r\nContent-Encoding: gzip\r\nContent-Length: " +
+                           std::to_string(asset->gzip_body->size()) + "\r\nETag: " + asset->gzip_etag + "\r\n" + common;
+        asset->gzip_not_modified_head = "HTTP/1.1 304 Not Modified\r\nETag: " + asset->gzip_etag + "\r\n" + common;
+    }
+    return asset;
+}
+
+void AssetCache::load() {
+    auto assets = std::make_shared<AssetMap>();
+    auto read_file = [](const std::filesystem::path& path, std::string& content) {
+        std::ifstream file(path, std::ios::binary);
+        if (!file.is_open()) {
+            return false;
+        }
+        std::ostringstream buffer;
+        buffer << file.rdbuf();
+        content = buffer.str();
+        return true;
+    };
+
+    std::error_code ec;
+    for (const auto& entry : std::filesystem::directory_iterator(static_dir_, ec)) {
+        std::string content;
+        std::string name = entry.path().filename().string();
+        // Skip editor temp files and anything that isn't a plain file
+        if (!entry.is_regular_file(ec) || name.empty() || name[0] == '.' || name.back() == '~') continue;
+        if (read_file(entry.path(), content)) {
+            // Not versioned in their URLs, so browsers revalidate (a 304 when unchanged)
+            (*assets)["/static/" + name] = build_asset(content, content_type_for(name), "no-cache");
+        }
+    }
+
+    std::string html;
+    if (read_file(std::filesystem::path(templates_dir_) / "index.html", html)) {
+        auto index = build_asset(html, "text/html; charset=utf-8", "no-cache");
+        (*assets)["/"] = index;
+        (*assets)["/index.html"] = index;
+    } else {
+        write_log("AssetCache: WARNING - Template not found: " + templates_dir_ + "/index.html");
+    }
+
+    size_t count = assets->size();
+    std::atomic_store(&assets_, std::shared_ptr<const AssetMap>(std::move(assets)));
+    write_log("AssetCache: Loaded " + std::to_string(count) + " assets");
+}
+
+std::shared_ptr<const CachedAsset> AssetCache::find(const std::string& path) const {
+    std::shared_ptr<const AssetMap> assets = std::atomic_load(&assets_);
+    auto it = assets->find(path.substr(0, path.find('?')));
+    return it != assets->end() ? it->second : nullptr;
+}
+
+void AssetCache::start_watch_thread() {
+    // Renames and deletes count too: a file that disappears has to leave the cache
+    const uint32_t mask = IN_CLOSE_WRITE | IN_MOVED_TO | IN_MOVED_FROM | IN_CREATE | IN_DELETE;
+    std::string problems;
+    if (!watcher_.start({static_dir_, templates_dir_}, mask, nullptr, [this]() { load(); }, problems)) {
+        write_log("AssetCache: ERROR - " + problems + ", assets won't reload");
+    } else if (!problems.empty()) {
+        write_log("AssetCache: WARNING - " + problems);
+    }
+}
+
+void AssetCache::stop_watch_thread() {
+    watcher_.stop();
+}
+
+void AssetCache::write_log(const std::string& message) {
+    std::string timestamp;
+    {
+        time_t now = std::time(nullptr);
+        struct tm* timeinfo = std::localtime(&now);
+        char buffer[20];
+        strftime(buffer, sizeof(buffer), "%Y-%m-%d %H:%M:%S", timeinfo);
+        timestamp = buffer;
+    }
+
+    std::string log_message = "[" + timestamp + "] [AssetCache] " + message;
+
+    // Log to console
+    std::cout << log_message << std::endl;
+
+    // Log to file
+    std::ofstream log_file("/var/log/refrigeration-api.log", std::ios::app);
+    if (log_file.is_open()) {
+        log_file << log_message << std::endl;
+        log_file.close();
+    }
+}
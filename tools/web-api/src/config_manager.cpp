@@ -11,10 +11,12 @@
 #include <chrono>
 #include <iomanip>
 #include <map>
+#include <algorithm>
+#include <sys/inotify.h>
 
 ConfigManager::ConfigManager(const std::string& config_file)
     : config_file_(config_file), email_port_(587), web_port_(9000),
-      config_file_mtime_(0), watching_(false) {
+      history_dir_("/var/lib/web-api/history"), history_retention_days_(90), config_file_mtime_(0) {
     load_config();
 }
 
@@ -31,6 +33,11 @@ void ConfigManager::load_config() {
         return;
     }
 
+    struct stat st;
+    if (stat(config_file_.c_str(), &st) == 0) {
+        config_file_mtime_ = st.st_mtime;
+    }
+
     std::string line;
     while (std::getline(file, line)) {
         // Remove comments
@@ -80,6 +87,50 @@ void ConfigManager::load_config() {
             }
         } else if (key == "WEB_PASSWORD") {
             web_password_ = value;
+        } else if (key == "POLL_CONCURRENCY") {
+            try {
+                poll_settings_.concurrency = std::max(1, std::stoi(value));
+            } catch (...) {
+                poll_settings_.concurrency = 16;
+            }
+        } else if (key == "POLL_CONNECT_TIMEOUT") {
+            try {
+                poll_settings_.connect_timeout = std::max(1, std::stoi(value));
+            } catch (...) {
+                poll_settings_.connect_timeout = 3;
+            }
+        } else if (key == "POLL_TIMEOUT") {
+            try {
+                poll_settings_.timeout = std::max(1, std::stoi(value));
+            } catch (...) {
+                poll_settings_.timeout = 10;
+            }
+        } else if (key == "POLL_INTERVAL") {
+            try {
+                poll_settings_.interval = std::max(1, std::stoi(value));
+            } catch (...) {
+                poll_settings_.interval = 30;
+            }
+        } else if (key == "HISTORY_DIR") {
+            history_dir_ = value;
+        } else if (key == "HISTORY_RETENTION_DAYS") {
+            try {
+                history_retention_days_ = std::max(1, std::stoi(value));
+            } catch (...) {
+                history_retention_days_ = 90;
+            }
+        } else if (key == "POLL_FAST_INTERVAL") {
+            try {
+                poll_settings_.fast_interval = std::max(1, std::stoi(value));
+            } catch (...) {
+                poll_settings_.fast_interval = 10;
+            }
+        } else if (key == "POLL_MAX_BACKOFF") {
+            try {
+                poll_settings_.max_backoff = std::max(1, std::stoi(value));
+            } catch (...) {
+                poll_settings_.max_backoff = 600;
+            }
         }
     }
 
@@ -164,39 +215,75 @@ void ConfigManager::load_units_from_config() {
     write_log("Loaded " + std::to_string(units_.size()) + " units from config");
 }
 
+UnitDiff diff_units(const std::vector<Unit>& before, const std::vector<Unit>& after) {
+    UnitDiff diff;
+    std::map<std::string, const Unit*> old_units;
+    for (const auto& unit : before) {
+        old_units[unit.id] = &unit;
+    }
+    for (const auto& unit : after) {
+        auto it = old_units.find(unit.id);
+        if (it == old_units.end()) {
+            diff.added.push_back(unit);
+            continue;
+        }
+        const Unit& old_unit = *it->second;
+        if (old_unit.api_address != unit.api_address || old_unit.api_port != unit.api_port ||
+            old_unit.api_key != unit.api_key) {
+            diff.changed.push_back(unit);
+        }
+        old_units.erase(it);
+    }
+    for (const auto& entry : old_units) {
+        diff.removed.push_back(*entry.second);
+    }
+    return diff;
+}
+
 void ConfigManager::start_watch_thread() {
-    if (watching_) return;
+    // Watch the folder, not the file: editors and config management replace the file by rename.
+    // Other files in the folder come and go too; only ours counts.
+    size_t slash = config_file_.find_last_of('/');
+    std::string dir = slash == std::string::npos ? "." : (slash == 0 ? "/" : config_file_.substr(0, slash));
+    std::string name = slash == std::string::npos ? config_file_ : config_file_.substr(slash + 1);
+    std::string problems;
+    if (watcher_.start({dir}, IN_CLOSE_WRITE | IN_MOVED_TO,
+                       [name](const std::string& changed) { return changed == name; },
+                       [this]() { reload(); }, problems)) {
+        write_log("Config watch thread started");
+        return;
+    }
 
-    watching_ = true;
-    config_watch_thread_ = std::thread(&ConfigManager::config_watch_loop, this);
-    write_log("Config watch thread started");
+    write_log("WARNING: " + problems + ", checking the config every 5 seconds instead");
+    if (!watcher_.start_polling(5000, [this]() { reload_if_changed(); }, problems)) {
+        write_log("ERROR: " + problems + ", config won't reload");
+    }
 }
 
 void ConfigManager::stop_watch_thread() {
-    watching_ = false;
-    if (config_watch_thread_.joinable()) {
-        config_watch_thread_.join();
-    }
+    if (!watcher_.running()) return;
+    watcher_.stop();
     write_log("Config watch thread stopped");
 }
 
-void ConfigManager::config_watch_loop() {
-    while (watching_) {
-        reload_if_changed();
-        std::this_thread::sleep_for(std::chrono::seconds(5));
+void ConfigManager::reload() {
+    write_log("Config file changed, reloading...");
+    load_config();
+    if (on_config_changed_) {
+        on_config_changed_();
     }
 }
 
 void ConfigManager::reload_if_changed() {
     struct stat st;
     if (stat(config_file_.c_str(), &st) == 0) {
-        if (st.st_mtime > config_file_mtime_) {
-            write_log("Config file changed, reloading...");
-            config_file_mtime_ = st.st_mtime;
-            load_config();
-            if (on_config_changed_) {
-                on_config_changed_();
-            }
+        time_t loaded_mtime;
+        {
+            std::lock_guard<std::mutex> lock(config_mutex_);
+            loaded_mtime = config_file_mtime_;
+        }
+        if (st.st_mtime > loaded_mtime) {
+            reload();
         }
     }
 }
@@ -0,0 +1,171 @@
+/*
+ * Connection Cache Implementation
+ */
+
+#include "../include/tools/web_interface/connection_cache.h"
+#include <openssl/ssl.h>
+
+ConnectionCache::ConnectionCache() {
+    share_ = curl_share_init();
+    if (share_) {
+        curl_share_setopt(share_, CURLSHOPT_LOCKFUNC, &ConnectionCache::lock_share);
+        curl_share_setopt(share_, CURLSHOPT_UNLOCKFUNC, &ConnectionCache::unlock_share);
+        curl_share_setopt(share_, CURLSHOPT_USERDATA, this);
+        curl_share_setopt(share_, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+        curl_share_setopt(share_, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+        // libcurl can't share a connection pool between threads (CURL_LOCK_DATA_CONNECT);
+        // live connections stay with the cached handles instead
+    }
+}
+
+ConnectionCache::~ConnectionCache() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto& entry : units_) {
+        for (CURL* curl : entry.second->idle) {
+            curl_easy_cleanup(curl);
+        }
+    }
+    units_.clear();
+    if (share_) {
+        curl_share_cleanup(share_);
+    }
+}
+
+void ConnectionCache::lock_share(CURL*, curl_lock_data data, curl_lock_access, void* userptr) {
+    static_cast<ConnectionCache*>(userptr)->share_locks_[data].lock();
+}
+
+void ConnectionCache::unlock_share(CURL*, curl_lock_data data, void* userptr) {
+    static_cast<ConnectionCache*>(userptr)->share_locks_[data].unlock();
+}
+
+ConnectionCache::UnitConnections& ConnectionCache::connections_for(const std::string& unit_id) {
+    auto& entry = units_[unit_id];
+    if (!entry) {
+        entry = std::make_unique<UnitConnections>();
+    }
+    return *entry;
+}
+
+CURLcode ConnectionCache::attach_ssl_ctx(CURL*, void* ssl_ctx, void* userptr) {
+    // libcurl builds an SSL_CTX per connection, so its app data can name the unit's counters
+    SSL_CTX* ctx = static_cast<SSL_CTX*>(ssl_ctx);
+    SSL_CTX_set_app_data(ctx, userptr);
+    SSL_CTX_set_info_callback(ctx, &ConnectionCache::tls_info_callback);
+    return CURLE_OK;
+}
+
+void ConnectionCache::tls_info_callback(const SSL* ssl, int where, int) {
+    if (!(where & SSL_CB_HANDSHAKE_DONE)) {
+        return;
+    }
+    auto* connections = static_cast<UnitConnections*>(SSL_CTX_get_app_data(SSL_get_SSL_CTX(ssl)));
+    if (!connections) {
+        return;
+    }
+    if (SSL_session_reused(const_cast<SSL*>(ssl))) {
+        connections->tls_resumed++;
+    } else {
+        connections->tls_full++;
+    }
+}
+
+CURL* ConnectionCache::acquire(const Unit& unit) {
+    CURL* curl = nullptr;
+    UnitConnections* connections;
+    uint64_t generation;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        connections = &connections_for(unit.id);
+        connections->removed = false;  // Configured again
+        generation = connections->generation;
+        if (!connections->idle.empty()) {
+            curl = connections->idle.back();
+            connections->idle.pop_back();
+        }
+    }
+
+    if (curl) {
+        // Drops the previous request's options but keeps the handle's connection and session
+        curl_easy_reset(curl);
+    } else {
+        curl = curl_easy_init();
+    }
+
+    if (!curl) {
+        return nullptr;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        lent_generation_[curl] = generation;
+    }
+
+    if (share_) {
+        curl_easy_setopt(curl, CURLOPT_SHARE, share_);
+    }
+    curl_easy_setopt(curl, CURLOPT_SSL_CTX_FUNCTION, &ConnectionCache::attach_ssl_ctx);
+    curl_easy_setopt(curl, CURLOPT_SSL_CTX_DATA, connections);
+    return curl;
+}
+
+void ConnectionCache::release(const Unit& unit, CURL* curl) {
+    if (!curl) {
+        return;
+    }
+
+    long connects = 0;
+    curl_easy_getinfo(curl, CURLINFO_NUM_CONNECTS, &connects);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    UnitConnections& connections = connections_for(unit.id);
+    connections.requests++;
+    connections.connects += static_cast<uint64_t>(connects);
+
+    bool current = true;
+    auto lent = lent_generation_.find(curl);
+    if (lent != lent_generation_.end()) {
+        current = lent->second == connections.generation;
+        lent_generation_.erase(lent);
+    }
+    if (current && !connections.removed && connections.idle.size() < max_idle_per_unit) {
+        connections.idle.push_back(curl);
+    } else {
+        curl_easy_cleanup(curl);
+    }
+}
+
+void ConnectionCache::forget(const std::string& unit_id, bool removed) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = units_.find(unit_id);
+    if (it == units_.end()) {
+        return;
+    }
+    UnitConnections& connections = *it->second;
+    for (CURL* curl : connections.idle) {
+        curl_easy_cleanup(curl);
+    }
+    connections.idle.clear();
+    connections.generation++;
+    if (removed) {
+        connections.removed = true;
+    }
+}
+
+json ConnectionCache::get_stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    json stats = json::object();
+    for (const auto& entry : units_) {
+        const UnitConnections& connections = *entry.second;
+        if (connections.removed) {
+            continue;
+        }
+        stats[entry.first] = {
+            {"requests", connections.requests.load()},
+            {"connects", connections.connects.load()},
+            {"tls_full_handshakes", connections.tls_full.load()},
+            {"tls_resumed_handshakes", connections.tls_resumed.load()},
+            {"idle_handles", connections.idle.size()}
+        };
+    }
+    return stats;
+}
@@ -0,0 +1,126 @@
+/*
+ * Directory Watcher Implementation
+ */
+
+#include "../include/tools/web_interface/directory_watcher.h"
+#include <cerrno>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/inotify.h>
+#include <sys/eventfd.h>
+
+DirectoryWatcher::DirectoryWatcher()
+    : running_(false), inotify_fd_(-1), stop_fd_(-1) {
+}
+
+DirectoryWatcher::~DirectoryWatcher() {
+    stop();
+}
+
+bool DirectoryWatcher::open_stop_fd(std::string& problems) {
+    stop_fd_ = eventfd(0, EFD_CLOEXEC);
+    if (stop_fd_ == -1) {
+        problems = "eventfd unavailable";
+        return false;
+    }
+    return true;
+}
+
+bool DirectoryWatcher::start(const std::vector<std::string>& dirs, uint32_t mask, NameFilter filter,
+                             std::function<void()> on_change, std::string& problems) {
+    problems.clear();
+    if (running_) return true;
+
+    inotify_fd_ = inotify_init1(IN_CLOEXEC);
+    if (inotify_fd_ == -1) {
+        problems = "inotify unavailable";
+        return false;
+    }
+    size_t watched = 0;
+    for (const std::string& dir : dirs) {
+        if (inotify_add_watch(inotify_fd_, dir.c_str(), mask) == -1) {
+            problems += (problems.empty() ? "can't watch " : ", ") + dir;
+        } else {
+            watched++;
+        }
+    }
+    if (watched == 0 || !open_stop_fd(problems)) {
+        close(inotify_fd_);
+        inotify_fd_ = -1;
+        return false;
+    }
+
+    running_ = true;
+    thread_ = std::thread(&DirectoryWatcher::watch_loop, this, std::move(filter), std::move(on_change));
+    return true;
+}
+
+bool DirectoryWatcher::start_polling(int interval_ms, std::function<void()> on_poll, std::string& problems) {
+    problems.clear();
+    if (running_) return true;
+    if (!open_stop_fd(problems)) {
+        return false;
+    }
+    running_ = true;
+    thread_ = std::thread(&DirectoryWatcher::poll_loop, this, interval_ms, std::move(on_poll));
+    return true;
+}
+
+void DirectoryWatcher::stop() {
+    if (!running_) return;
+
+    running_ = false;
+    uint64_t one = 1;
+    ssize_t written = write(stop_fd_, &one, sizeof(one));
+    (void)written;  // Can only fail if the counter is full, which means a wakeup is pending anyway
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+    close(stop_fd_);
+    stop_fd_ = -1;
+    if (inotify_fd_ != -1) {
+        close(inotify_fd_);
+        inotify_fd_ = -1;
+    }
+}
+
+void DirectoryWatcher::watch_loop(NameFilter filter, std::function<void()> on_change) {
+    struct pollfd fds[2] = {{inotify_fd_, POLLIN, 0}, {stop_fd_, POLLIN, 0}};
+    alignas(struct inotify_event) char buffer[4096];
+    bool pending = false;
+    while (running_) {
+        int ready = poll(fds, 2, pending ? debounce_ms : -1);
+        if (ready < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        if (fds[1].revents & POLLIN) {
+            break;
+        }
+        if (ready == 0) {
+            pending = false;
+            on_change();
+            continue;
+        }
+        if (fds[0].revents & POLLIN) {
+            ssize_t length = read(inotify_fd_, buffer, sizeof(buffer));
+            for (ssize_t offset = 0; offset < length;) {
+                auto* event = reinterpret_cast<struct inotify_event*>(buffer + offset);
+                if (!filter || (event->len > 0 && filter(event->name))) {
+                    pending = true;
+                }
+                offset += sizeof(struct inotify_event) + event->len;
+            }
+        }
+    }
+}
+
+void DirectoryWatcher::poll_loop(int interval_ms, std::function<void()> on_poll) {
+    struct pollfd stop = {stop_fd_, POLLIN, 0};
+    while (running_) {
+        on_poll();
+        if (poll(&stop, 1, interval_ms) > 0) {
+            break;
+        }
+    }
+}
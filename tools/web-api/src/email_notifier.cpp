@@ -41,51 +41,280 @@ static size_t smtp_read_callback(void* ptr, size_t size, size_t nmemb, void* use
 EmailNotifier::EmailNotifier(const std::string& email_server, int email_port,
                              const std::string& email_address, const std::string& email_password)
     : email_server_(email_server), email_port_(email_port),
-      email_address_(email_address), email_password_(email_password) {
+      email_address_(email_address), email_password_(email_password),
+      running_(false), next_id_(1), sending_id_(0), curl_(nullptr),
+      queued_(0), sent_(0), failed_(0), retries_(0), dropped_(0), digests_(0), alarms_(0), connections_(0),
+      last_sent_(0) {
 }
 
 EmailNotifier::~EmailNotifier() {
+    stop();
+    if (curl_) {
+        curl_easy_cleanup(curl_);
+    }
+}
+
+void EmailNotifier::start() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (running_) return;
+    running_ = true;
+    sender_thread_ = std::thread(&EmailNotifier::sender_loop, this);
+}
+
+void EmailNotifier::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        running_ = false;
+    }
+    wake_.notify_all();
+    if (sender_thread_.joinable()) {
+        sender_thread_.join();
+    }
 }
 
 bool EmailNotifier::send_alarm_email(const std::string& unit_id, const json& status_data) {
-    std::string subject = "ALARM: Unit " + unit_id + " Alarm Detected!";
-    std::string body = format_alarm_body(unit_id, status_data);
-    return send_smtp_email(email_address_, subject, body);
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (email_server_.empty() || email_address_.empty() || email_password_.empty()) {
+        write_log("EMAIL ERROR: Email configuration incomplete");
+        return false;
+    }
+
+    // The first alarm opens the window; a unit alarming again before it closes just updates its status
+    if (pending_alarms_.empty()) {
+        digest_due_ = Clock::now() + std::chrono::seconds(digest_seconds);
+    }
+    pending_alarms_[unit_id] = status_data;
+    alarms_++;
+    wake_.notify_one();
+    return true;
 }
 
 bool EmailNotifier::send_email(const std::string& to, const std::string& subject, const std::string& body) {
-    return send_smtp_email(to, subject, body);
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (email_server_.empty() || email_address_.empty() || email_password_.empty()) {
+        write_log("EMAIL ERROR: Email configuration incomplete");
+        return false;
+    }
+
+    Message message;
+    message.to = to;
+    message.subject = subject;
+    message.body = body;
+    enqueue(std::move(message));
+    wake_.notify_one();
+    return true;
 }
 
 void EmailNotifier::set_sender(const std::string& email, const std::string& password) {
+    std::lock_guard<std::mutex> lock(mutex_);
     email_address_ = email;
     email_password_ = password;
 }
 
 void EmailNotifier::set_server(const std::string& server, int port) {
+    std::lock_guard<std::mutex> lock(mutex_);
     email_server_ = server;
     email_port_ = port;
 }
 
-bool EmailNotifier::send_smtp_email(const std::string& to, const std::string& subject, const std::string& body) {
-    if (email_server_.empty() || email_address_.empty() || email_password_.empty()) {
-        write_log("EMAIL ERROR: Email configuration incomplete");
-        return false;
+json EmailNotifier::get_stats() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    json stats;
+    stats["queue_depth"] = queue_.size();
+    stats["pending_alarms"] = pending_alarms_.size();
+    stats["max_queue"] = max_queue;
+    stats["queued"] = queued_;
+    stats["sent"] = sent_;
+    stats["failed"] = failed_;
+    stats["retries"] = retries_;
+    stats["dropped"] = dropped_;
+    stats["alarms"] = alarms_;
+    stats["digests"] = digests_;
+    stats["smtp_connections"] = connections_;
+    stats["last_error"] = last_error_;
+    stats["last_sent"] = last_sent_;
+    if (!queue_.empty()) {
+        std::time_t oldest = queue_.front().queued_at;
+        for (const auto& message : queue_) {
+            oldest = std::min(oldest, message.queued_at);
+        }
+        stats["oldest_queued_seconds"] = std::time(nullptr) - oldest;
+    }
+    return stats;
+}
+
+// Caller holds mutex_
+void EmailNotifier::enqueue(Message message) {
+    if (queue_.size() >= max_queue) {
+        auto oldest = std::find_if(queue_.begin(), queue_.end(),
+                                   [this](const Message& queued) { return queued.id != sending_id_; });
+        if (oldest != queue_.end()) {
+            write_log("EMAIL ERROR: Queue full, dropping \"" + oldest->subject + "\"");
+            queue_.erase(oldest);
+            dropped_++;
+        }
+    }
+    message.id = next_id_++;
+    message.next_attempt = Clock::now();
+    message.queued_at = std::time(nullptr);
+    queue_.push_back(std::move(message));
+    queued_++;
+}
+
+// Caller holds mutex_. Turns the alarms collected so far into one queued email.
+void EmailNotifier::close_digest() {
+    std::string subject;
+    std::ostringstream body;
+    if (pending_alarms_.size() == 1) {
+        const auto& alarm = *pending_alarms_.begin();
+        subject = "ALARM: Unit " + alarm.first + " Alarm Detected!";
+        body << format_alarm_body(alarm.first, alarm.second);
+    } else {
+        subject = "ALARM: " + std::to_string(pending_alarms_.size()) + " Units Alarm Detected!";
+        body << pending_alarms_.size() << " units reported alarms within " << digest_seconds << " seconds:\n";
+        for (const auto& alarm : pending_alarms_) {
+            body << "- " << alarm.first << "\n";
+        }
+        for (const auto& alarm : pending_alarms_) {
+            body << "\n----------------------------------------\n\n" << format_alarm_body(alarm.first, alarm.second);
+        }
+        digests_++;
+    }
+    pending_alarms_.clear();
+
+    Message message;
+    message.to = email_address_;
+    message.subject = subject;
+    message.body = body.str();
+    enqueue(std::move(message));
+}
+
+void EmailNotifier::sender_loop() {
+    write_log("EMAIL: Sender thread started");
+    std::unique_lock<std::mutex> lock(mutex_);
+    bool shutdown_failed = false;
+
+    while (true) {
+        auto now = Clock::now();
+        if (!pending_alarms_.empty() && (!running_ || now >= digest_due_)) {
+            close_digest();
+        }
+
+        // Oldest message that's due. On stop, each untried message gets one attempt unless the server is failing.
+        auto next = queue_.end();
+        auto wake_at = Clock::time_point::max();
+        for (auto it = queue_.begin(); it != queue_.end(); ++it) {
+            bool due = running_ ? it->next_attempt <= now : (it->attempts == 0 && !shutdown_failed);
+            if (due) {
+                next = it;
+                break;
+            }
+            wake_at = std::min(wake_at, it->next_attempt);
+        }
+
+        if (next == queue_.end()) {
+            if (!running_) break;
+            if (!pending_alarms_.empty()) {
+                wake_at = std::min(wake_at, digest_due_);
+            }
+            if (wake_at == Clock::time_point::max()) {
+                wake_.wait(lock);
+            } else {
+                wake_.wait_until(lock, wake_at);
+            }
+            continue;
+        }
+
+        // Send without the lock so the poller can keep queueing
+        Message message = *next;
+        sending_id_ = message.id;
+        lock.unlock();
+        std::string error;
+        bool success = send_smtp_email(message.to, message.subject, message.body, error);
+        lock.lock();
+        sending_id_ = 0;
+
+        auto it = std::find_if(queue_.begin(), queue_.end(),
+                               [&message](const Message& queued) { return queued.id == message.id; });
+        if (it == queue_.end()) continue;
+
+        if (success) {
+            sent_++;
+            last_sent_ = std::time(nullptr);
+            queue_.erase(it);
+            continue;
+        }
+
+        last_error_ = error;
+        it->attempts++;
+        if (!running_) {
+            shutdown_failed = true;
+        }
+        if (it->attempts >= max_attempts) {
+            write_log("EMAIL ERROR: Giving up on \"" + it->subject + "\" after " + std::to_string(it->attempts) + " attempts");
+            failed_++;
+            queue_.erase(it);
+        } else {
+            int delay = std::min(retry_max_seconds, retry_base_seconds << (it->attempts - 1));
+            write_log("EMAIL: Retrying \"" + it->subject + "\" in " + std::to_string(delay) + " seconds");
+            it->next_attempt = Clock::now() + std::chrono::seconds(delay);
+            retries_++;
+        }
     }
 
-    write_log("EMAIL: Attempting to send email to " + to + " via " + email_server_ + ":" + std::to_string(email_port_));
+    if (!queue_.empty()) {
+        write_log("EMAIL ERROR: Discarding " + std::to_string(queue_.size()) + " unsent emails at shutdown");
+        dropped_ += queue_.size();
+        queue_.clear();
+    }
+    write_log("EMAIL: Sender thread stopped");
+}
+
+// Runs on the sender thread only, which owns curl_
+bool EmailNotifier::send_smtp_email(const std::string& to, const std::string& subject, const std::string& body,
+                                    std::string& error) {
+    std::string server, address, password;
+    int port;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        server = email_server_;
+        port = email_port_;
+        address = email_address_;
+        password = email_password_;
+    }
 
-    CURL* curl = curl_easy_init();
-    if (!curl) {
-        write_log("EMAIL ERROR: Failed to initialize CURL");
+    if (server.empty() || address.empty() || password.empty()) {
+        error = "Email configuration incomplete";
+        write_log("EMAIL ERROR: " + error);
         return false;
     }
 
+    write_log("EMAIL: Attempting to send email to " + to + " via " + server + ":" + std::to_string(port));
+
+    // One handle for the life of the notifier: reset clears the options but keeps its
+    // connection cache, so back-to-back emails skip the TCP and TLS handshakes
+    if (!curl_) {
+        curl_ = curl_easy_init();
+        if (!curl_) {
+            error = "Failed to initialize CURL";
+            write_log("EMAIL ERROR: " + error);
+            return false;
+        }
+    } else {
+        curl_easy_reset(curl_);
+    }
+    CURL* curl = curl_;
+
+    // RFC 5322 date of when the message is actually sent
+    char date[64];
+    std::time_t now = std::time(nullptr);
+    strftime(date, sizeof(date), "%a, %d %b %Y %H:%M:%S %z", std::localtime(&now));
+
     // Build the email payload
     std::string payload_text =
-        "Date: Fri, 22 Dec 2025 12:00:00 -0500\r\n"
+        "Date: " + std::string(date) + "\r\n"
         "To: " + to + "\r\n"
-        "From: REFRIGERATION-ALARM@" + email_server_ + "\r\n"
+        "From: REFRIGERATION-ALARM@" + server + "\r\n"
         "Subject: " + subject + "\r\n"
         "\r\n" + body + "\r\n";
 
@@ -97,49 +326,52 @@ bool EmailNotifier::send_smtp_email(const std::string& to, const std::string& su
     struct curl_slist* recipients = nullptr;
     recipients = curl_slist_append(recipients, to.c_str());
 
-    curl_easy_setopt(curl, CURLOPT_USERNAME, email_address_.c_str());
-    curl_easy_setopt(curl, CURLOPT_PASSWORD, email_password_.c_str());
+    curl_easy_setopt(curl, CURLOPT_USERNAME, address.c_str());
+    curl_easy_setopt(curl, CURLOPT_PASSWORD, password.c_str());
 
     // Set the URL based on port
     std::string smtp_url;
-    if (email_port_ == 465) {
-        smtp_url = "smtps://" + email_server_ + ":465";
-        write_log("EMAIL: Using SMTPS (implicit TLS) on port 465");
-    } else if (email_port_ == 587) {
-        smtp_url = "smtp://" + email_server_ + ":587";
+    if (port == 465) {
+        smtp_url = "smtps://" + server + ":465";
+    } else if (port == 587) {
+        smtp_url = "smtp://" + server + ":587";
         curl_easy_setopt(curl, CURLOPT_USE_SSL, (long)CURLUSESSL_ALL);
-        write_log("EMAIL: Using SMTP with STARTTLS on port 587");
     } else {
-        smtp_url = "smtp://" + email_server_ + ":" + std::to_string(email_port_);
-        write_log("EMAIL: Using SMTP on port " + std::to_string(email_port_));
+        smtp_url = "smtp://" + server + ":" + std::to_string(port);
     }
 
     curl_easy_setopt(curl, CURLOPT_URL, smtp_url.c_str());
-    curl_easy_setopt(curl, CURLOPT_MAIL_FROM, email_address_.c_str());
+    curl_easy_setopt(curl, CURLOPT_MAIL_FROM, address.c_str());
     curl_easy_setopt(curl, CURLOPT_MAIL_RCPT, recipients);
 
     // Use upload mode with payload callback
     curl_easy_setopt(curl, CURLOPT_UPLOAD, 1L);
     curl_easy_setopt(curl, CURLOPT_READFUNCTION, smtp_read_callback);
     curl_easy_setopt(curl, CURLOPT_READDATA, (void*)&upload_ctx);
+    curl_easy_setopt(curl, CURLOPT_CONNECTTIMEOUT, 10L);
     curl_easy_setopt(curl, CURLOPT_TIMEOUT, 30L);
+    curl_easy_setopt(curl, CURLOPT_NOSIGNAL, 1L);
 
     // Suppress response content (we don't need it for SMTP)
     curl_easy_setopt(curl, CURLOPT_NOBODY, 0L);
 
-    write_log("EMAIL: Sending message...");
     CURLcode res = curl_easy_perform(curl);
 
+    long connects = 0;
+    curl_easy_getinfo(curl, CURLINFO_NUM_CONNECTS, &connects);
+
     bool success = (res == CURLE_OK);
     if (!success) {
-        write_log("EMAIL ERROR: " + std::string(curl_easy_strerror(res)));
+        error = curl_easy_strerror(res);
+        write_log("EMAIL ERROR: " + error);
     } else {
-        write_log("EMAIL: Message sent successfully");
+        write_log(std::string("EMAIL: Message sent successfully") + (connects == 0 ? " (reused connection)" : ""));
     }
 
     curl_slist_free_all(recipients);
-    curl_easy_cleanup(curl);
 
+    std::lock_guard<std::mutex> lock(mutex_);
+    connections_ += connects;
     return success;
 }
 
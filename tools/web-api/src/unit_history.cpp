@@ -0,0 +1,370 @@
+/*
+ * Unit History Implementation
+ */
+
+#include "../include/tools/web_interface/unit_history.h"
+#include <filesystem>
+#include <algorithm>
+#include <cmath>
+#include <climits>
+#include <cctype>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+static const char* const field_names[static_cast<int>(SampleField::Count)] = {
+    "return", "supply", "coil", "setpoint", "compressor", "fan", "valve", "electric_heater", "alarm", "defrost"
+};
+
+static_assert(sizeof(HistorySample) == 20, "HistorySample layout is part of the file format");
+
+static int16_t to_hundredths(const json& value) {
+    if (!value.is_number()) {
+        return INT16_MIN;
+    }
+    double v = value.get<double>();
+    if (std::isnan(v)) {
+        return INT16_MIN;
+    }
+    return static_cast<int16_t>(std::lround(std::clamp(v, -327.67, 327.67) * 100.0));
+}
+
+static HistoryMode mode_from_status(const std::string& status) {
+    if (status == "Null") return HistoryMode::Null;
+    if (status == "Cooling") return HistoryMode::Cooling;
+    if (status == "Heating") return HistoryMode::Heating;
+    if (status == "Defrost") return HistoryMode::Defrost;
+    if (status == "Alarm") return HistoryMode::Alarm;
+    return HistoryMode::Unknown;
+}
+
+UnitHistory::UnitHistory(const std::string& data_dir, int retention_days)
+    : data_dir_(data_dir), retention_days_(retention_days) {
+}
+
+UnitHistory::~UnitHistory() {
+    for (auto& entry : units_) {
+        if (entry.second.fd != -1) {
+            close(entry.second.fd);
+        }
+    }
+}
+
+const char* UnitHistory::field_name(SampleField field) {
+    int index = static_cast<int>(field);
+    return (index >= 0 && index < field_count) ? field_names[index] : "unknown";
+}
+
+bool UnitHistory::parse_field(const std::string& name, SampleField& field) {
+    for (int i = 0; i < field_count; ++i) {
+        if (name == field_names[i]) {
+            field = static_cast<SampleField>(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+std::string UnitHistory::day_name(std::time_t time) {
+    std::tm tm_buf{};
+    gmtime_r(&time, &tm_buf);
+    char buffer[16];
+    std::strftime(buffer, sizeof(buffer), "%Y-%m-%d", &tm_buf);
+    return buffer;
+}
+
+std::string UnitHistory::unit_dir(const std::string& unit_id) const {
+    // Unit IDs come from the config file; keep them to one safe path component
+    std::string name = unit_id;
+    for (char& c : name) {
+        if (!std::isalnum(static_cast<unsigned char>(c)) && c != '-' && c != '_' && c != '.') {
+            c = '_';
+        }
+    }
+    if (name.empty() || name == "." || name == "..") {
+        name = "_";
+    }
+    return data_dir_ + "/" + name;
+}
+
+bool UnitHistory::sample_from_status(const json& status, HistorySample& sample) {
+    if (!status.is_object() || !status.contains("sensors") || !status["sensors"].is_object()) {
+        return false;
+    }
+    const json& sensors = status["sensors"];
+    const json relays = status.value("relays", json::object());
+
+    sample = HistorySample{};
+    sample.timestamp = static_cast<uint32_t>(std::time(nullptr));
+    sample.return_temp = to_hundredths(sensors.value("return_temp", json()));
+    sample.supply_temp = to_hundredths(sensors.value("supply_temp", json()));
+    sample.coil_temp = to_hundredths(sensors.value("coil_temp", json()));
+    sample.setpoint = to_hundredths(status.value("setpoint", json()));
+    sample.mode = static_cast<uint8_t>(mode_from_status(status.value("system_status", "")));
+    sample.relays = (relays.value("compressor", false) ? 1 : 0) | (relays.value("fan", false) ? 2 : 0) |
+                    (relays.value("valve", false) ? 4 : 0) | (relays.value("electric_heater", false) ? 8 : 0);
+    sample.flags = (status.value("alarm_warning", false) ? 1 : 0) | (status.value("alarm_shutdown", false) ? 2 : 0);
+
+    int lowest = 0;
+    int alarm_count = 0;
+    for (const auto& code : status.value("active_alarms", json::array())) {
+        if (!code.is_number_integer()) continue;
+        int value = code.get<int>();
+        alarm_count++;
+        if (lowest == 0 || value < lowest) lowest = value;
+    }
+    sample.alarm_count = static_cast<uint8_t>(std::min(alarm_count, 255));
+    sample.first_alarm = static_cast<uint16_t>(std::clamp(lowest, 0, 65535));
+    return true;
+}
+
+bool UnitHistory::field_value(const HistorySample& sample, SampleField field, float& value) {
+    int16_t raw;
+    switch (field) {
+        case SampleField::Return: raw = sample.return_temp; break;
+        case SampleField::Supply: raw = sample.supply_temp; break;
+        case SampleField::Coil: raw = sample.coil_temp; break;
+        case SampleField::Setpoint: raw = sample.setpoint; break;
+        case SampleField::Compressor: value = (sample.relays & 1) ? 1.0f : 0.0f; return true;
+        case SampleField::Fan: value = (sample.relays & 2) ? 1.0f : 0.0f; return true;
+        case SampleField::Valve: value = (sample.relays & 4) ? 1.0f : 0.0f; return true;
+        case SampleField::ElectricHeater: value = (sample.relays & 8) ? 1.0f : 0.0f; return true;
+        case SampleField::Alarm: value = (sample.alarm_count > 0 || sample.flags != 0) ? 1.0f : 0.0f; return true;
+        case SampleField::Defrost:
+            value = sample.mode == static_cast<uint8_t>(HistoryMode::Defrost) ? 1.0f : 0.0f;
+            return true;
+        default: return false;
+    }
+    if (raw == INT16_MIN) {
+        return false;
+    }
+    value = raw / 100.0f;
+    return true;
+}
+
+UnitHistory::UnitSeries& UnitHistory::series_for(const std::string& unit_id) {
+    UnitSeries& series = units_[unit_id];
+    if (!series.loaded) {
+        load(unit_id, series);
+    }
+    return series;
+}
+
+void UnitHistory::load(const std::string& unit_id, UnitSeries& series) {
+    // Rebuild the in-memory windows from the day files, so a restart keeps them
+    std::time_t now = std::time(nullptr);
+    series.loaded = true;
+    series.rollups_since = now - rollup_keep_seconds;
+    series.rollups_since -= series.rollups_since % rollup_seconds;
+    series.recent_since = now - recent_seconds;
+    for (const HistorySample& sample : read_range(unit_id, series.rollups_since, now + 1)) {
+        add_to_memory(series, sample);
+    }
+}
+
+void UnitHistory::add_to_memory(UnitSeries& series, const HistorySample& sample) {
+    if (sample.timestamp >= series.recent_since) {
+        series.recent.push_back(sample);
+    }
+    std::time_t recent_cutoff = static_cast<std::time_t>(sample.timestamp) - recent_seconds;
+    while (!series.recent.empty() && series.recent.front().timestamp < recent_cutoff) {
+        series.recent.pop_front();
+    }
+    series.recent_since = std::max(series.recent_since, recent_cutoff);
+
+    uint32_t start = sample.timestamp - sample.timestamp % rollup_seconds;
+    if (series.rollups.empty() || series.rollups.back().start < start) {
+        Rollup rollup{};
+        rollup.start = start;
+        series.rollups.push_back(rollup);
+    } else if (series.rollups.back().start > start) {
+        return;  // Clock stepped back; the day file still has the sample
+    }
+    Rollup& rollup = series.rollups.back();
+    rollup.samples++;
+    for (int f = 0; f < field_count; ++f) {
+        float value;
+        if (!field_value(sample, static_cast<SampleField>(f), value)) continue;
+        if (rollup.count[f] == 0 || value < rollup.min[f]) rollup.min[f] = value;
+        if (rollup.count[f] == 0 || value > rollup.max[f]) rollup.max[f] = value;
+        rollup.sum[f] += value;
+        rollup.count[f]++;
+    }
+
+    std::time_t rollup_cutoff = static_cast<std::time_t>(start) - rollup_keep_seconds;
+    while (!series.rollups.empty() && series.rollups.front().start < rollup_cutoff) {
+        series.rollups.pop_front();
+    }
+    series.rollups_since = std::max(series.rollups_since, rollup_cutoff);
+}
+
+bool UnitHistory::open_day_file(const std::string& unit_id, UnitSeries& series, const std::string& day) {
+    if (series.fd != -1) {
+        close(series.fd);
+        series.fd = -1;
+    }
+    std::error_code ec;
+    std::filesystem::create_directories(unit_dir(unit_id), ec);
+
+    std::string path = unit_dir(unit_id) + "/" + day + ".hist";
+    int fd = open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if (fd == -1) {
+        return false;
+    }
+    // Drop a record torn by a crash mid-write so later records stay aligned
+    struct stat st;
+    if (fstat(fd, &st) == 0 && st.st_size % sizeof(HistorySample) != 0) {
+        if (ftruncate(fd, st.st_size - st.st_size % sizeof(HistorySample)) == -1) {
+            close(fd);
+            return false;
+        }
+    }
+    series.fd = fd;
+    series.day = day;
+    return true;
+}
+
+void UnitHistory::remove_expired(const std::string& unit_id) {
+    std::string oldest_kept = day_name(std::time(nullptr) - static_cast<std::time_t>(retention_days_) * 86400);
+    std::error_code ec;
+    for (const auto& entry : std::filesystem::directory_iterator(unit_dir(unit_id), ec)) {
+        std::string name = entry.path().filename().string();
+        if (name.size() == 15 && name.compare(10, 5, ".hist") == 0 && name.substr(0, 10) < oldest_kept) {
+            std::filesystem::remove(entry.path(), ec);
+        }
+    }
+}
+
+void UnitHistory::append(const std::string& unit_id, const json& status) {
+    HistorySample sample;
+    if (!sample_from_status(status, sample)) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    UnitSeries& series = series_for(unit_id);
+    std::string day = day_name(sample.timestamp);
+    if (day != series.day || series.fd == -1) {
+        // New day: start its file and drop files past retention
+        if (!open_day_file(unit_id, series, day)) {
+            series.day.clear();
+        }
+        remove_expired(unit_id);
+    }
+    if (series.fd != -1) {
+        ssize_t written = write(series.fd, &sample, sizeof(sample));
+        (void)written;  // A failed write only loses the sample from disk; memory still has it
+    }
+    add_to_memory(series, sample);
+}
+
+std::vector<HistorySample> UnitHistory::read_range(const std::string& unit_id, std::time_t from, std::time_t to) const {
+    std::vector<HistorySample> samples;
+    std::vector<HistorySample> day_samples;
+    std::time_t day_start = from - ((from % 86400) + 86400) % 86400;
+    for (; day_start < to; day_start += 86400) {
+        std::string path = unit_dir(unit_id) + "/" + day_name(day_start) + ".hist";
+        int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd == -1) {
+            continue;
+        }
+        struct stat st;
+        if (fstat(fd, &st) == 0) {
+            // Whole records only; the writer may be mid-append
+            size_t records = static_cast<size_t>(st.st_size) / sizeof(HistorySample);
+            day_samples.resize(records);
+            ssize_t got = pread(fd, day_samples.data(), records * sizeof(HistorySample), 0);
+            day_samples.resize(got > 0 ? static_cast<size_t>(got) / sizeof(HistorySample) : 0);
+            // Appended in time order, so the range is one contiguous run
+            auto first = std::lower_bound(day_samples.begin(), day_samples.end(), from,
+                [](const HistorySample& s, std::time_t t) { return static_cast<std::time_t>(s.timestamp) < t; });
+            for (auto it = first; it != day_samples.end() && static_cast<std::time_t>(it->timestamp) < to; ++it) {
+                samples.push_back(*it);
+            }
+        }
+        close(fd);
+    }
+    return samples;
+}
+
+HistorySeries UnitHistory::query(const std::string& unit_id, std::time_t from, std::time_t to, int step,
+                                 const std::vector<SampleField>& fields) {
+    HistorySeries result;
+    result.from = from;
+    result.to = to;
+    result.step = step;
+    result.fields = fields;
+    if (step <= 0 || to <= from) {
+        return result;
+    }
+
+    size_t buckets = static_cast<size_t>((to - from + step - 1) / step);
+    result.samples.assign(buckets, 0);
+    result.count.assign(fields.size(), std::vector<uint32_t>(buckets, 0));
+    result.min.assign(fields.size(), std::vector<float>(buckets, 0.0f));
+    result.max.assign(fields.size(), std::vector<float>(buckets, 0.0f));
+    std::vector<std::vector<double>> sum(fields.size(), std::vector<double>(buckets, 0.0));
+
+    auto add_sample = [&](const HistorySample& sample) {
+        if (sample.timestamp < from || sample.timestamp >= to) return;
+        size_t bucket = static_cast<size_t>((sample.timestamp - from) / step);
+        result.samples[bucket]++;
+        for (size_t f = 0; f < fields.size(); ++f) {
+            float value;
+            if (!field_value(sample, fields[f], value)) continue;
+            uint32_t& n = result.count[f][bucket];
+            if (n == 0 || value < result.min[f][bucket]) result.min[f][bucket] = value;
+            if (n == 0 || value > result.max[f][bucket]) result.max[f][bucket] = value;
+            sum[f][bucket] += value;
+            n++;
+        }
+    };
+
+    bool served = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        UnitSeries& series = series_for(unit_id);
+        if (from % rollup_seconds == 0 && step % rollup_seconds == 0 && from >= series.rollups_since) {
+            // Bucket edges fall on rollup edges: merge whole rollups
+            result.source = "rollup";
+            for (const Rollup& rollup : series.rollups) {
+                if (rollup.start < from || rollup.start >= to) continue;
+                size_t bucket = static_cast<size_t>((rollup.start - from) / step);
+                result.samples[bucket] += rollup.samples;
+                for (size_t f = 0; f < fields.size(); ++f) {
+                    int index = static_cast<int>(fields[f]);
+                    if (rollup.count[index] == 0) continue;
+                    uint32_t& n = result.count[f][bucket];
+                    if (n == 0 || rollup.min[index] < result.min[f][bucket]) result.min[f][bucket] = rollup.min[index];
+                    if (n == 0 || rollup.max[index] > result.max[f][bucket]) result.max[f][bucket] = rollup.max[index];
+                    sum[f][bucket] += rollup.sum[index];
+                    n += rollup.count[index];
+                }
+            }
+            served = true;
+        } else if (from >= series.recent_since) {
+            result.source = "recent";
+            for (const HistorySample& sample : series.recent) {
+                add_sample(sample);
+            }
+            served = true;
+        }
+    }
+
+    if (!served) {
+        result.source = "disk";
+        for (const HistorySample& sample : read_range(unit_id, from, to)) {
+            add_sample(sample);
+        }
+    }
+
+    result.avg.assign(fields.size(), std::vector<float>(buckets, 0.0f));
+    for (size_t f = 0; f < fields.size(); ++f) {
+        for (size_t b = 0; b < buckets; ++b) {
+            if (result.count[f][b] > 0) {
+                result.avg[f][b] = static_cast<float>(sum[f][b] / result.count[f][b]);
+            }
+        }
+    }
+    return result;
+}
@@ -1,5 +1,6 @@
 #include "../include/tools/web_interface/unit_poller.h"
 #include "../include/tools/web_interface/email_notifier.h"
+#include "../include/tools/web_interface/unit_history.h"
 #include <curl/curl.h>
 #include <nlohmann/json.hpp>
 #include <thread>
@@ -8,6 +9,10 @@
 #include <iostream>
 #include <fstream>
 #include <ctime>
+#include <map>
+#include <memory>
+#include <algorithm>
+#include <cmath>
 
 using json = nlohmann::json;
 
@@ -17,11 +22,19 @@ static size_t unit_poller_curl_write_callback(void* contents, size_t size, size_
     return size * nmemb;
 }
 
-UnitPoller::UnitPoller() : running_(false), email_notifier_(nullptr) {
+UnitPoller::UnitPoller(ConnectionCache* connections)
+    : snapshot_epoch_(std::time(nullptr)), first_version_(static_cast<uint64_t>(snapshot_epoch_) * 1000000),
+      snapshot_version_(first_version_), email_notifier_(nullptr), history_(nullptr),
+      connections_(connections), multi_(nullptr), jitter_rng_(std::random_device{}()),
+      running_(false), stop_requested_(false) {
+    publish_units_snapshot();
 }
 
 UnitPoller::~UnitPoller() {
     stop();
+    if (multi_) {
+        curl_multi_cleanup(multi_);
+    }
 }
 
 void UnitPoller::start(const std::vector<Unit>& units) {
@@ -32,9 +45,38 @@ void UnitPoller::start(const std::vector<Unit>& units) {
     {
         std::lock_guard<std::mutex> lock(data_mutex_);
         units_ = units;
+        // Configured units that haven't answered yet show as offline; units no longer
+        // configured are dropped and reported as removed to delta readers
+        static const auto offline = std::make_shared<const std::string>("{\"system_status\":\"Offline\"}");
+        for (const auto& unit : units) {
+            if (unit_bodies_.emplace(unit.id, UnitsSnapshot::UnitBody{0, offline}).second) {
+                removed_units_.erase(unit.id);
+            }
+        }
+        for (auto it = unit_bodies_.begin(); it != unit_bodies_.end();) {
+            bool configured = std::any_of(units.begin(), units.end(), [&](const Unit& u) { return u.id == it->first; });
+            if (configured) {
+                ++it;
+            } else {
+                removed_units_[it->first] = 0;
+                unit_data_.erase(it->first);
+                it = unit_bodies_.erase(it);
+            }
+        }
+    }
+    schedule_units(units);
+    publish_units_snapshot();
+
+    if (!multi_) {
+        multi_ = curl_multi_init();
+        if (!multi_) {
+            write_log("UnitPoller: Failed to initialize CURL multi handle");
+            return;
+        }
     }
 
     running_ = true;
+    stop_requested_ = false;
     polling_thread_ = std::thread(&UnitPoller::polling_loop, this);
     write_log("UnitPoller: Started polling thread with " + std::to_string(units.size()) + " units");
 }
@@ -45,12 +87,99 @@ void UnitPoller::stop() {
     }
 
     running_ = false;
+    stop_requested_ = true;
+    if (multi_) {
+        curl_multi_wakeup(multi_);
+    }
     if (polling_thread_.joinable()) {
         polling_thread_.join();
     }
     write_log("UnitPoller: Stopped polling thread");
 }
 
+void UnitPoller::update_units(const std::vector<Unit>& units) {
+    UnitDiff diff;
+    {
+        std::lock_guard<std::mutex> lock(data_mutex_);
+        diff = diff_units(units_, units);
+        if (diff.empty()) {
+            return;
+        }
+        units_ = units;
+
+        auto now = Clock::now();
+        static const auto offline = std::make_shared<const std::string>("{\"system_status\":\"Offline\"}");
+        std::uniform_int_distribution<int> offset(0, std::min(settings_.interval, 5) * 1000);
+        for (const auto& unit : diff.added) {
+            unit_bodies_[unit.id] = UnitsSnapshot::UnitBody{0, offline};
+            removed_units_.erase(unit.id);
+            UnitSchedule& entry = schedule_[unit.id];
+            entry = UnitSchedule();
+            entry.unit = unit;
+            entry.interval = settings_.interval;
+            entry.next_due = now + std::chrono::milliseconds(offset(jitter_rng_));
+            entry.reason = "added";
+            poll_queue_.push({entry.next_due, unit.id});
+        }
+        for (const auto& unit : diff.removed) {
+            // A poll still in flight is discarded when it finishes (see accept_result)
+            schedule_.erase(unit.id);
+            unit_data_.erase(unit.id);
+            unit_bodies_.erase(unit.id);
+            active_alarms_.erase(unit.id);
+            last_status_.erase(unit.id);
+            removed_units_[unit.id] = 0;
+        }
+        for (const auto& unit : diff.changed) {
+            // Its last status came from the old address; keep showing it until the new one answers
+            UnitSchedule& entry = schedule_[unit.id];
+            entry.unit = unit;
+            entry.failures = 0;
+            entry.interval = settings_.interval;
+            entry.reason = "reconfigured";
+            if (!entry.in_flight) {
+                entry.next_due = now;
+                poll_queue_.push({entry.next_due, unit.id});
+            }
+        }
+    }
+
+    for (const auto& unit : diff.removed) {
+        connections_->forget(unit.id, true);
+    }
+    for (const auto& unit : diff.changed) {
+        connections_->forget(unit.id, false);
+    }
+    if (!diff.added.empty() || !diff.removed.empty()) {
+        publish_units_snapshot();
+    }
+    if (multi_) {
+        curl_multi_wakeup(multi_);
+    }
+
+    write_log("UnitPoller: Units updated: " + std::to_string(diff.added.size()) + " added, " +
+              std::to_string(diff.removed.size()) + " removed, " + std::to_string(diff.changed.size()) + " changed");
+}
+
+// False for a poll of a unit that was removed or reconfigured while it was in flight; a
+// reconfigured unit is queued again straight away with its new settings
+bool UnitPoller::accept_result(const Unit& unit) {
+    std::lock_guard<std::mutex> lock(data_mutex_);
+    auto it = schedule_.find(unit.id);
+    if (it == schedule_.end()) {
+        return false;
+    }
+    UnitSchedule& entry = it->second;
+    if (entry.unit.api_address == unit.api_address && entry.unit.api_port == unit.api_port &&
+        entry.unit.api_key == unit.api_key) {
+        return true;
+    }
+    entry.in_flight = false;
+    entry.next_due = Clock::now();
+    poll_queue_.push({entry.next_due, unit.id});
+    return false;
+}
+
 json UnitPoller::get_unit_data(const std::string& unit_id) const {
     std::lock_guard<std::mutex> lock(data_mutex_);
     auto it = unit_data_.find(unit_id);
@@ -60,13 +189,78 @@ json UnitPoller::get_unit_data(const std::string& unit_id) const {
     return json::object();
 }
 
-json UnitPoller::get_all_unit_data() const {
+std::shared_ptr<const UnitsSnapshot> UnitPoller::get_units_snapshot() const {
+    return std::atomic_load(&units_snapshot_);
+}
+
+void UnitPoller::publish_units_snapshot() {
     std::lock_guard<std::mutex> lock(data_mutex_);
-    json all_data = json::object();
-    for (const auto& entry : unit_data_) {
-        all_data[entry.first] = entry.second;
+    auto snapshot = std::make_shared<UnitsSnapshot>();
+    snapshot->version = ++snapshot_version_;
+    snapshot->first_version = first_version_;
+    snapshot->timestamp = std::time(nullptr);
+    snapshot->etag = "\"" + std::to_string(snapshot_epoch_) + "-" + std::to_string(snapshot->version) + "\"";
+
+    // Changes since the last snapshot take this version
+    for (auto& entry : unit_bodies_) {
+        if (entry.second.version == 0) entry.second.version = snapshot->version;
+    }
+    for (auto& entry : removed_units_) {
+        if (entry.second == 0) entry.second = snapshot->version;
     }
-    return all_data;
+    snapshot->units = unit_bodies_;
+    snapshot->removed = removed_units_;
+
+    // Splice the per-unit JSON instead of building and dumping one big tree
+    std::string& body = snapshot->body;
+    std::string unit_configs = "{";
+    body = "{\"full\":true,\"unit_data\":{";
+    for (const auto& entry : snapshot->units) {
+        std::string key = json(entry.first).dump();
+        if (body.back() != '{') body += ",";
+        body += key + ":" + *entry.second.json;
+        if (unit_configs.size() > 1) unit_configs += ",";
+        unit_configs += key + ":{}";
+    }
+    body += "},\"unit_configs\":" + unit_configs + "}";
+    body += ",\"removed\":[]";
+    body += ",\"unit_count\":" + std::to_string(snapshot->units.size());
+    body += ",\"version\":" + std::to_string(snapshot->version);
+    body += ",\"timestamp\":" + std::to_string(snapshot->timestamp) + "}";
+
+    std::atomic_store(&units_snapshot_, std::shared_ptr<const UnitsSnapshot>(std::move(snapshot)));
+}
+
+std::string UnitsSnapshot::delta_body(uint64_t since) const {
+    if (since < first_version || since > version) {
+        return body;
+    }
+
+    std::string unit_data = "{";
+    std::string unit_configs = "{";
+    for (const auto& entry : units) {
+        if (entry.second.version <= since) continue;
+        std::string key = json(entry.first).dump();
+        if (unit_data.size() > 1) {
+            unit_data += ",";
+            unit_configs += ",";
+        }
+        unit_data += key + ":" + *entry.second.json;
+        unit_configs += key + ":{}";
+    }
+    json removed_ids = json::array();
+    for (const auto& entry : removed) {
+        if (entry.second > since) removed_ids.push_back(entry.first);
+    }
+
+    std::string delta = "{\"full\":false,\"since\":" + std::to_string(since);
+    delta += ",\"unit_data\":" + unit_data + "}";
+    delta += ",\"unit_configs\":" + unit_configs + "}";
+    delta += ",\"removed\":" + removed_ids.dump();
+    delta += ",\"unit_count\":" + std::to_string(units.size());
+    delta += ",\"version\":" + std::to_string(version);
+    delta += ",\"timestamp\":" + std::to_string(timestamp) + "}";
+    return delta;
 }
 
 json UnitPoller::get_active_alarms(const std::string& unit_id) const {
@@ -82,139 +276,451 @@ json UnitPoller::get_active_alarms(const std::string& unit_id) const {
     return json::array();
 }
 
-json UnitPoller::call_unit_api(const Unit& unit, const std::string& endpoint) {
-    CURL* curl = curl_easy_init();
-    if (!curl) {
-        write_log("UnitPoller: Failed to initialize CURL for unit " + unit.id);
-        return json::object();
-    }
-
+// Set up an easy handle for one unit API request; returns the header list the caller frees
+static struct curl_slist* setup_unit_request(CURL* curl, const Unit& unit, const std::string& endpoint,
+                                             const PollSettings& settings, std::string* response) {
     std::string url = "https://" + unit.api_address + ":" + std::to_string(unit.api_port) + "/api/v1" + endpoint;
-    std::string response_string;
 
     struct curl_slist* headers = nullptr;
     headers = curl_slist_append(headers, ("X-API-Key: " + unit.api_key).c_str());
+    // CBOR is smaller and cheaper to parse; units that don't support it answer with JSON
+    headers = curl_slist_append(headers, "Accept: application/cbor, application/json");
 
     curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
     curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
     curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, unit_poller_curl_write_callback);
-    curl_easy_setopt(curl, CURLOPT_WRITEDATA, &response_string);
-    curl_easy_setopt(curl, CURLOPT_TIMEOUT, 10L);
+    curl_easy_setopt(curl, CURLOPT_WRITEDATA, response);
+    // An unreachable unit gives up after the connect timeout instead of holding a slot for the full timeout
+    curl_easy_setopt(curl, CURLOPT_CONNECTTIMEOUT, static_cast<long>(settings.connect_timeout));
+    curl_easy_setopt(curl, CURLOPT_TIMEOUT, static_cast<long>(settings.timeout));
+    curl_easy_setopt(curl, CURLOPT_NOSIGNAL, 1L);  // Timeouts without SIGALRM, required off the main thread
     curl_easy_setopt(curl, CURLOPT_SSL_VERIFYPEER, 0L);  // Accept self-signed certs
     curl_easy_setopt(curl, CURLOPT_SSL_VERIFYHOST, 0L);
+    return headers;
+}
 
-    CURLcode res = curl_easy_perform(curl);
+void UnitPoller::set_poll_settings(const PollSettings& settings) {
+    std::lock_guard<std::mutex> lock(data_mutex_);
+    settings_ = settings;
+}
 
-    curl_slist_free_all(headers);
-    curl_easy_cleanup(curl);
+json UnitPoller::decode_response(const Unit& unit, const char* content_type, const std::string& response) {
+    try {
+        if (content_type && std::string(content_type).find("application/cbor") == 0) {
+            return json::from_cbor(response);
+        }
+        return json::parse(response);
+    } catch (const std::exception& e) {
+        write_log("UnitPoller: ERROR - Invalid JSON response from unit " + unit.id + ": " + std::string(e.what()));
+        return json::object();
+    }
+}
 
+json UnitPoller::call_unit_api(const Unit& unit, const std::string& endpoint) {
+    CURL* curl = connections_->acquire(unit);
+    if (!curl) {
+        write_log("UnitPoller: Failed to initialize CURL for unit " + unit.id);
+        return json::object();
+    }
+
+    PollSettings settings;
+    {
+        std::lock_guard<std::mutex> lock(data_mutex_);
+        settings = settings_;
+    }
+
+    std::string response_string;
+    struct curl_slist* headers = setup_unit_request(curl, unit, endpoint, settings, &response_string);
+
+    CURLcode res = curl_easy_perform(curl);
+
+    char* content_type = nullptr;
+    curl_easy_getinfo(curl, CURLINFO_CONTENT_TYPE, &content_type);
+    json result = json::object();
     if (res != CURLE_OK) {
         write_log("UnitPoller: ERROR - Failed to call API for unit " + unit.id + ": " + std::string(curl_easy_strerror(res)));
-        return json::object();
+    } else {
+        result = decode_response(unit, content_type, response_string);
     }
 
-    try {
-        return json::parse(response_string);
-    } catch (const std::exception& e) {
-        write_log("UnitPoller: ERROR - Invalid JSON response from unit " + unit.id + ": " + std::string(e.what()));
-        return json::object();
+    curl_slist_free_all(headers);
+    connections_->release(unit, curl);
+    return result;
+}
+
+// One in-flight status request
+struct PollTransfer {
+    Unit unit;
+    CURL* curl = nullptr;
+    struct curl_slist* headers = nullptr;
+    std::string response;
+};
+
+bool UnitPoller::begin_transfer(const Unit& unit, const PollSettings& settings) {
+    CURL* curl = connections_->acquire(unit);
+    if (!curl) {
+        write_log("UnitPoller: Failed to initialize CURL for unit " + unit.id);
+        return false;
     }
+    auto transfer = std::make_unique<PollTransfer>();
+    transfer->unit = unit;
+    transfer->curl = curl;
+    transfer->headers = setup_unit_request(curl, unit, "/status", settings, &transfer->response);
+    curl_multi_add_handle(multi_, curl);
+    in_flight_[curl] = std::move(transfer);
+    return true;
 }
 
-void UnitPoller::polling_loop() {
-    write_log("UnitPoller: Polling loop started");
+void UnitPoller::finish_transfers(int wait_ms, std::vector<std::pair<Unit, json>>& results) {
+    // All transfers share one thread: a slow or dead unit only occupies one of the
+    // concurrency slots while the rest of the fleet keeps moving
+    int still_running = 0;
+    curl_multi_perform(multi_, &still_running);
 
-    while (running_) {
-        write_log("UnitPoller: === Polling cycle started ===");
+    int queued = 0;
+    while (CURLMsg* message = curl_multi_info_read(multi_, &queued)) {
+        if (message->msg != CURLMSG_DONE) {
+            continue;
+        }
+        auto it = in_flight_.find(message->easy_handle);
+        if (it == in_flight_.end()) {
+            continue;
+        }
+        std::unique_ptr<PollTransfer> transfer = std::move(it->second);
+        in_flight_.erase(it);
+
+        json status = json::object();
+        if (message->data.result != CURLE_OK) {
+            write_log("UnitPoller: ERROR - Failed to call API for unit " + transfer->unit.id + ": " +
+                      std::string(curl_easy_strerror(message->data.result)));
+        } else {
+            char* content_type = nullptr;
+            curl_easy_getinfo(transfer->curl, CURLINFO_CONTENT_TYPE, &content_type);
+            status = decode_response(transfer->unit, content_type, transfer->response);
+        }
 
-        std::vector<Unit> current_units;
-        {
-            std::lock_guard<std::mutex> lock(data_mutex_);
-            current_units = units_;
+        curl_multi_remove_handle(multi_, transfer->curl);
+        curl_slist_free_all(transfer->headers);
+        connections_->release(transfer->unit, transfer->curl);
+        results.emplace_back(transfer->unit, std::move(status));
+    }
+
+    // Refill freed slots straight away; otherwise wait for socket activity, a due unit or a wakeup
+    if (results.empty() && wait_ms > 0) {
+        curl_multi_poll(multi_, nullptr, 0, wait_ms, nullptr);
+    }
+}
+
+void UnitPoller::abort_transfers() {
+    for (auto& entry : in_flight_) {
+        curl_multi_remove_handle(multi_, entry.first);
+        curl_slist_free_all(entry.second->headers);
+        curl_easy_cleanup(entry.first);
+    }
+    in_flight_.clear();
+}
+
+void UnitPoller::schedule_units(const std::vector<Unit>& units) {
+    std::lock_guard<std::mutex> lock(data_mutex_);
+    schedule_.clear();
+    poll_queue_ = {};
+
+    // Spread the first round over a few seconds so restarts don't hit the whole fleet at once
+    auto now = Clock::now();
+    int spread_ms = std::min(settings_.interval, 5) * 1000;
+    std::uniform_int_distribution<int> offset(0, spread_ms);
+    for (const auto& unit : units) {
+        UnitSchedule& entry = schedule_[unit.id];
+        entry.unit = unit;
+        entry.interval = settings_.interval;
+        entry.next_due = now + std::chrono::milliseconds(offset(jitter_rng_));
+        entry.reason = "startup";
+        poll_queue_.push({entry.next_due, unit.id});
+    }
+}
+
+std::vector<Unit> UnitPoller::take_due_units(size_t limit, int& wait_ms) {
+    std::vector<Unit> due;
+    std::lock_guard<std::mutex> lock(data_mutex_);
+    auto now = Clock::now();
+    while (!poll_queue_.empty() && due.size() < limit) {
+        const ScheduledPoll& top = poll_queue_.top();
+        auto it = schedule_.find(top.unit_id);
+        if (it == schedule_.end() || it->second.in_flight || it->second.next_due != top.due) {
+            poll_queue_.pop();  // Superseded by a later reschedule
+            continue;
+        }
+        if (top.due > now) {
+            break;
         }
+        it->second.in_flight = true;
+        due.push_back(it->second.unit);
+        poll_queue_.pop();
+    }
 
-        for (const auto& unit : current_units) {
-            if (!running_) break;
+    // Sleep until the next unit is due (the next poll wakes up early for request_poll())
+    wait_ms = 1000;
+    if (due.size() == limit) {
+        // No free slot; only a finishing transfer can change that
+    } else if (!poll_queue_.empty()) {
+        auto until_due = std::chrono::duration_cast<std::chrono::milliseconds>(poll_queue_.top().due - now).count();
+        wait_ms = static_cast<int>(std::clamp<long long>(until_due, 0, 1000));
+    }
+    return due;
+}
 
-            write_log("UnitPoller: Polling unit: " + unit.id);
+// How long a unit stays on the fast cadence after its mode, relays, setpoint or alarms changed
+static constexpr int recent_change_seconds = 120;
+
+// Fields of a status that mark a change worth watching closely; temperatures drift constantly
+static std::string status_state_key(const json& status) {
+    json key = json::array();
+    key.push_back(status.value("system_status", ""));
+    key.push_back(status.value("relays", json::object()));
+    key.push_back(status.value("setpoint", 0.0));
+    key.push_back(status.value("active_alarms", json::array()));
+    key.push_back(status.value("pretrip_stage", 0));
+    return key.dump();
+}
 
-            // Fetch current status
-            json status = call_unit_api(unit, "/status");
+void UnitPoller::reschedule(const Unit& unit, bool answered, const json& status) {
+    std::lock_guard<std::mutex> lock(data_mutex_);
+    auto it = schedule_.find(unit.id);
+    if (it == schedule_.end()) {
+        return;
+    }
+    UnitSchedule& entry = it->second;
+    entry.in_flight = false;
+    entry.last_poll = std::time(nullptr);
+
+    int delay = settings_.interval;
+    if (!answered) {
+        // Exponential backoff: one normal interval, then doubling up to the cap
+        entry.failures++;
+        int shift = std::min(entry.failures - 1, 16);
+        delay = static_cast<int>(std::min<long long>(static_cast<long long>(settings_.interval) << shift,
+                                                     settings_.max_backoff));
+        entry.reason = entry.failures > 1 ? "backoff" : "unreachable";
+    } else {
+        entry.failures = 0;
+        std::string state_key = status_state_key(status);
+        if (!entry.state_key.empty() && state_key != entry.state_key) {
+            entry.last_change = entry.last_poll;
+        }
+        entry.state_key = state_key;
+
+        std::string system_status = status.value("system_status", "");
+        auto alarms = status.value("active_alarms", json::array());
+        bool alarm = system_status == "Alarm" || status.value("alarm_warning", false) ||
+                     status.value("alarm_shutdown", false) || (alarms.is_array() && !alarms.empty());
+        if (alarm) {
+            entry.reason = "alarm";
+        } else if (system_status == "Defrost") {
+            entry.reason = "defrost";
+        } else if (status.value("pretrip_stage", 0) > 0) {
+            entry.reason = "pretrip";
+        } else if (entry.last_change != 0 && entry.last_poll - entry.last_change < recent_change_seconds) {
+            entry.reason = "changed";
+        } else {
+            entry.reason = "normal";
+        }
+        if (entry.reason != "normal") {
+            delay = std::min(settings_.fast_interval, settings_.interval);
+        }
+    }
 
-            write_log("UnitPoller: Unit " + unit.id + " response: " + status.dump().substr(0, 200));
+    auto delay_ms = std::chrono::milliseconds(static_cast<long long>(delay) * 1000);
+    if (entry.repoll) {
+        entry.repoll = false;
+        delay_ms = std::chrono::milliseconds(0);
+        entry.reason = "requested";
+    } else {
+        // +/-10% so instances and units that started together drift apart
+        std::uniform_real_distribution<double> jitter(0.9, 1.1);
+        delay_ms = std::chrono::milliseconds(static_cast<long long>(delay_ms.count() * jitter(jitter_rng_)));
+    }
+    entry.interval = delay;
+    entry.next_due = Clock::now() + delay_ms;
+    poll_queue_.push({entry.next_due, unit.id});
+}
 
-            if (status.is_object() && status.contains("system_status")) {
-                {
-                    std::lock_guard<std::mutex> lock(data_mutex_);
-                    unit_data_[unit.id] = status;
-                    write_log("UnitPoller: Stored data for unit " + unit.id + " with status: " + std::string(status["system_status"]));
-                }
+void UnitPoller::request_poll(const std::string& unit_id) {
+    {
+        std::lock_guard<std::mutex> lock(data_mutex_);
+        auto it = schedule_.find(unit_id);
+        if (it == schedule_.end()) {
+            return;
+        }
+        UnitSchedule& entry = it->second;
+        if (entry.in_flight) {
+            entry.repoll = true;  // The answer in flight may predate the user's action
+            return;
+        }
+        entry.next_due = Clock::now();
+        entry.reason = "requested";
+        poll_queue_.push({entry.next_due, unit_id});
+    }
+    if (multi_) {
+        curl_multi_wakeup(multi_);
+    }
+}
 
-                // Check for alarms using new API fields
-                bool alarm_warning = status.value("alarm_warning", false);
-                bool alarm_shutdown = status.value("alarm_shutdown", false);
-                auto current_alarms = status.value("active_alarms", json::array());
-
-                bool has_alarm = alarm_warning || alarm_shutdown || (current_alarms.is_array() && !current_alarms.empty());
-                bool alarm_changed = false;
-
-                {
-                    std::lock_guard<std::mutex> lock(data_mutex_);
-                    auto it = active_alarms_.find(unit.id);
-                    if (has_alarm) {
-                        // Only update if alarm codes changed
-                        std::vector<int> alarm_ints;
-                        for (const auto& a : current_alarms) {
-                            if (a.is_number()) {
-                                alarm_ints.push_back(a.get<int>());
-                            }
-                        }
-                        if (it == active_alarms_.end() || it->second != alarm_ints) {
-                            alarm_changed = true;
-                            active_alarms_[unit.id] = alarm_ints;
-                        }
-                    } else {
-                        if (it != active_alarms_.end()) {
-                            alarm_changed = true;
-                            active_alarms_.erase(unit.id);
-                        }
-                    }
-                }
+json UnitPoller::get_schedule() const {
+    std::lock_guard<std::mutex> lock(data_mutex_);
+    json schedule = json::object();
+    auto now = Clock::now();
+    for (const auto& item : schedule_) {
+        const UnitSchedule& entry = item.second;
+        double next_poll_in = 0.0;
+        if (!entry.in_flight && entry.next_due > now) {
+            next_poll_in = std::chrono::duration<double>(entry.next_due - now).count();
+        }
+        schedule[item.first] = {
+            {"next_poll_in", std::round(next_poll_in * 10.0) / 10.0},
+            {"interval", entry.interval},
+            {"failures", entry.failures},
+            {"polling", entry.in_flight},
+            {"last_poll", entry.last_poll},
+            {"reason", entry.reason}
+        };
+    }
+    return schedule;
+}
 
-                if (alarm_changed && has_alarm) {
-                    write_log("UnitPoller: ALARM detected on unit: " + unit.id);
-                    // Send email notification if notifier is configured
-                    if (email_notifier_) {
-                        email_notifier_->send_alarm_email(unit.id, status);
-                    }
-                }
+// Units re-stamp their status every second, so two polls of an unchanged unit differ only in
+// "timestamp". Leaving it out keeps the /api/units version, ETag and deltas moving with real changes.
+static bool same_status(const json& previous, const json& status) {
+    if (!previous.is_object() || !status.is_object()) {
+        return previous == status;
+    }
+    size_t compared = 0;
+    for (auto it = status.begin(); it != status.end(); ++it) {
+        if (it.key() == "timestamp") continue;
+        auto match = previous.find(it.key());
+        if (match == previous.end() || *match != it.value()) {
+            return false;
+        }
+        compared++;
+    }
+    return compared == previous.size() - (previous.contains("timestamp") ? 1 : 0);
+}
 
-                write_log("UnitPoller: Unit " + unit.id + " status: " + status.value("system_status", "Unknown"));
-            } else {
-                write_log("UnitPoller: WARNING - Failed to get status for unit " + unit.id);
-            }
+void UnitPoller::process_status(const Unit& unit, const json& status) {
+    write_log("UnitPoller: Unit " + unit.id + " response: " + status.dump().substr(0, 200));
+
+    if (!status.is_object() || !status.contains("system_status")) {
+        write_log("UnitPoller: WARNING - Failed to get status for unit " + unit.id);
+        return;
+    }
 
-            // Small delay between unit calls
-            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    bool status_changed;
+    {
+        std::lock_guard<std::mutex> lock(data_mutex_);
+        auto it = unit_data_.find(unit.id);
+        status_changed = it == unit_data_.end() || !same_status(it->second, status);
+        unit_data_[unit.id] = status;
+        if (status_changed) {
+            unit_bodies_[unit.id] = UnitsSnapshot::UnitBody{0, std::make_shared<const std::string>(status.dump())};
         }
+    }
+    // Outside data_mutex_: readers of the unit data shouldn't wait on log file I/O
+    write_log("UnitPoller: Stored data for unit " + unit.id + " with status: " + std::string(status["system_status"]));
+    if (status_changed) {
+        publish_units_snapshot();
+    }
+
+    if (history_) {
+        history_->append(unit.id, status);
+    }
+
+    // Check for alarms using new API fields
+    bool alarm_warning = status.value("alarm_warning", false);
+    bool alarm_shutdown = status.value("alarm_shutdown", false);
+    auto current_alarms = status.value("active_alarms", json::array());
 
-        write_log("UnitPoller: === Polling cycle completed ===");
+    bool has_alarm = alarm_warning || alarm_shutdown || (current_alarms.is_array() && !current_alarms.empty());
+    bool alarm_changed = false;
 
-        // Poll every 30 seconds
-        for (int i = 0; i < 30 && running_; ++i) {
-            std::this_thread::sleep_for(std::chrono::seconds(1));
+    {
+        std::lock_guard<std::mutex> lock(data_mutex_);
+        auto it = active_alarms_.find(unit.id);
+        if (has_alarm) {
+            // Only update if alarm codes changed
+            std::vector<int> alarm_ints;
+            for (const auto& a : current_alarms) {
+                if (a.is_number()) {
+                    alarm_ints.push_back(a.get<int>());
+                }
+            }
+            if (it == active_alarms_.end() || it->second != alarm_ints) {
+                alarm_changed = true;
+                active_alarms_[unit.id] = alarm_ints;
+            }
+        } else {
+            if (it != active_alarms_.end()) {
+                alarm_changed = true;
+                active_alarms_.erase(unit.id);
+            }
         }
     }
 
-    write_log("UnitPoller: Polling loop stopped");
-}
+    if (alarm_changed && has_alarm) {
+        write_log("UnitPoller: ALARM detected on unit: " + unit.id);
+        // Send email notification if notifier is configured
+        if (email_notifier_) {
+            email_notifier_->send_alarm_email(unit.id, status);
+        }
+    }
 
-json UnitPoller::fetch_unit_status(const Unit& unit) {
-    return call_unit_api(unit, "/status");
+    write_log("UnitPoller: Unit " + unit.id + " status: " + status.value("system_status", "Unknown"));
 }
 
-json UnitPoller::fetch_unit_logs(const Unit& unit) {
-    return call_unit_api(unit, "/logs");
+void UnitPoller::polling_loop() {
+    write_log("UnitPoller: Polling loop started");
+
+    std::vector<std::pair<Unit, json>> results;
+    size_t max_connects = 0;
+    while (!stop_requested_) {
+        PollSettings settings;
+        size_t unit_count;
+        {
+            std::lock_guard<std::mutex> lock(data_mutex_);
+            settings = settings_;
+            unit_count = units_.size();
+        }
+        // Room for an idle connection to every unit between polls. The unit list can change
+        // on a config reload, and only this thread may touch the multi handle.
+        if (unit_count != max_connects) {
+            max_connects = unit_count;
+            curl_multi_setopt(multi_, CURLMOPT_MAXCONNECTS, static_cast<long>(max_connects));
+        }
+
+        size_t slots = static_cast<size_t>(settings.concurrency);
+        size_t free_slots = in_flight_.size() < slots ? slots - in_flight_.size() : 0;
+        int wait_ms = 1000;
+        for (const auto& unit : take_due_units(free_slots, wait_ms)) {
+            write_log("UnitPoller: Polling unit: " + unit.id);
+            if (!begin_transfer(unit, settings)) {
+                reschedule(unit, false, json::object());
+            }
+        }
+
+        results.clear();
+        finish_transfers(wait_ms, results);
+        for (const auto& result : results) {
+            if (!accept_result(result.first)) {
+                write_log("UnitPoller: Discarding poll of " + result.first.id + ", it was removed or reconfigured meanwhile");
+                continue;
+            }
+            const json& status = result.second;
+            bool answered = status.is_object() && status.contains("system_status");
+            process_status(result.first, status);
+            reschedule(result.first, answered, status);
+        }
+    }
+
+    abort_transfers();
+    write_log("UnitPoller: Polling loop stopped");
 }
 
 void UnitPoller::write_log(const std::string& message) {
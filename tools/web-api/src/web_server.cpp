@@ -1,5 +1,8 @@
 #include "../include/tools/web_interface/web_server.h"
 #include <sys/socket.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/uio.h>
 #include <netinet/in.h>
 #include <arpa/inet.h>
 #include <unistd.h>
@@ -12,8 +15,83 @@
 #include <fstream>
 #include <ctime>
 #include <iomanip>
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+
+// Lower-cased copy, for matching header names
+static std::string to_lower(std::string text) {
+    for (char& c : text) c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    return text;
+}
+
+// Value of a header in a lower-cased header block, empty if absent
+static std::string header_value(const std::string& lower_headers, const std::string& name) {
+    size_t pos = lower_headers.find("\r\n" + name + ":");
+    if (pos == std::string::npos) {
+        return "";
+    }
+    size_t start = lower_headers.find_first_not_of(" \t", pos + name.length() + 3);
+    size_t end = lower_headers.find("\r\n", pos + 2);
+    if (start == std::string::npos || start >= end) {
+        return "";
+    }
+    size_t last = lower_headers.find_last_not_of(" \t", end - 1);
+    return lower_headers.substr(start, last - start + 1);
+}
+
+// Status line and error body for requests the server refuses itself
+static std::string error_response(const std::string& status) {
+    std::string body = status.substr(4);
+    return "HTTP/1.1 " + status + "\r\nContent-Type: text/plain\r\nContent-Length: " +
+           std::to_string(body.length()) + "\r\nConnection: close\r\n\r\n" + body;
+}
 
-WebServer::WebServer(int port) : port_(port), server_fd_(-1), running_(false) {
+// Connection header lines and the blank line that ends the header block
+static std::string connection_headers(bool keep_alive) {
+    if (keep_alive) {
+        return "Connection: keep-alive\r\nKeep-Alive: timeout=" + std::to_string(WebServer::idle_timeout_seconds) + "\r\n\r\n";
+    }
+    return "Connection: close\r\n\r\n";
+}
+
+// Handlers build complete responses written for one request per connection. Give each a
+// Content-Length if it has none and the Connection header this connection actually uses.
+static std::string frame_response(const std::string& response, bool keep_alive) {
+    size_t header_end = response.find("\r\n\r\n");
+    if (header_end == std::string::npos) {
+        header_end = response.length();
+    }
+    size_t body_start = std::min(response.length(), header_end + 4);
+    std::string lower = to_lower(response.substr(0, header_end)) + "\r\n";
+
+    std::string framed;
+    framed.reserve(response.length() + 64);
+    size_t line_start = 0;
+    while (line_start < header_end) {
+        size_t line_end = response.find("\r\n", line_start);
+        if (line_end == std::string::npos || line_end > header_end) line_end = header_end;
+        if (lower.compare(line_start, 11, "connection:") != 0 && lower.compare(line_start, 11, "keep-alive:") != 0) {
+            framed.append(response, line_start, line_end - line_start);
+            framed += "\r\n";
+        }
+        line_start = line_end + 2;
+    }
+
+    // 1xx, 204 and 304 never carry a body
+    int status = response.length() > 12 ? std::atoi(response.c_str() + 9) : 0;
+    bool bodiless = status < 200 || status == 204 || status == 304;
+    if (!bodiless && lower.find("\r\ncontent-length:") == std::string::npos) {
+        framed += "Content-Length: " + std::to_string(response.length() - body_start) + "\r\n";
+    }
+    framed += connection_headers(keep_alive);
+    framed.append(response, body_start, std::string::npos);
+    return framed;
+}
+
+WebServer::WebServer(int port, int worker_count)
+    : port_(port), worker_count_(std::max(1, worker_count)), server_fd_(-1), epoll_fd_(-1), wake_fd_(-1),
+      running_(false), next_serial_(0) {
 }
 
 WebServer::~WebServer() {
@@ -25,6 +103,11 @@ void WebServer::start() {
         return;
     }
 
+    wake_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (wake_fd_ == -1) {
+        write_log("WebServer: ERROR - Failed to create eventfd");
+        return;
+    }
     running_ = true;
     server_thread_ = std::thread(&WebServer::server_loop, this);
     write_log("WebServer: Started on port " + std::to_string(port_));
@@ -38,29 +121,17 @@ void WebServer::stop() {
     write_log("WebServer: Stopping...");
     running_ = false;
 
-    // Close socket to interrupt accept() if it's blocking
-    if (server_fd_ != -1) {
-        int fd = server_fd_;
-        server_fd_ = -1;
-        close(fd);
+    // The server thread wakes on the eventfd, closes every connection and joins the workers.
+    // A worker inside a handler finishes that request first (unit calls have their own timeouts).
+    uint64_t one = 1;
+    if (write(wake_fd_, &one, sizeof(one)) < 0) {
+        write_log("WebServer: WARNING - Failed to wake server thread");
     }
-
-    // Wait for thread to finish with timeout
     if (server_thread_.joinable()) {
-        // Give thread up to 2 seconds to finish
-        auto start = std::chrono::system_clock::now();
-        while (server_thread_.joinable()) {
-            std::this_thread::sleep_for(std::chrono::milliseconds(50));
-            auto elapsed = std::chrono::system_clock::now() - start;
-            if (elapsed > std::chrono::seconds(2)) {
-                write_log("WebServer: WARNING - Thread did not stop gracefully");
-                break;
-            }
-        }
-        if (server_thread_.joinable()) {
-            server_thread_.detach();
-        }
+        server_thread_.join();
     }
+    close(wake_fd_);
+    wake_fd_ = -1;
 
     write_log("WebServer: Stopped");
 }
@@ -68,12 +139,13 @@ void WebServer::stop() {
 void WebServer::server_loop() {
     write_log("WebServer: Creating socket...");
 
-    server_fd_ = socket(AF_INET, SOCK_STREAM, 0);
+    server_fd_ = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
     if (server_fd_ < 0) {
         write_log("WebServer: ERROR - Failed to create socket");
         return;
     }
 
+    // Set SO_REUSEADDR to allow quick restart
     int opt = 1;
     setsockopt(server_fd_, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
 
@@ -89,62 +161,382 @@ void WebServer::server_loop() {
         return;
     }
 
-    if (listen(server_fd_, 10) < 0) {
+    if (listen(server_fd_, 128) < 0) {
         write_log("WebServer: ERROR - Failed to listen");
         close(server_fd_);
         server_fd_ = -1;
         return;
     }
 
-    // Set SO_REUSEADDR to allow quick restart
-    int reuse_val = 1;
-    setsockopt(server_fd_, SOL_SOCKET, SO_REUSEADDR, &reuse_val, sizeof(reuse_val));
-
-    // Set socket to non-blocking mode for accept() timeout
-    int flags = fcntl(server_fd_, F_GETFL, 0);
-    fcntl(server_fd_, F_SETFL, flags | O_NONBLOCK);
+    epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+    if (epoll_fd_ < 0) {
+        write_log("WebServer: ERROR - Failed to create epoll instance");
+        close(server_fd_);
+        server_fd_ = -1;
+        return;
+    }
+    struct epoll_event ev{};
+    ev.events = EPOLLIN;
+    ev.data.fd = server_fd_;
+    epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, server_fd_, &ev);
+    ev.data.fd = wake_fd_;
+    epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, wake_fd_, &ev);
+
+    for (int i = 0; i < worker_count_; ++i) {
+        workers_.emplace_back(&WebServer::worker_loop, this);
+    }
 
-    write_log("WebServer: Listening on 0.0.0.0:" + std::to_string(port_));
+    write_log("WebServer: Listening on 0.0.0.0:" + std::to_string(port_) + " with " +
+              std::to_string(worker_count_) + " workers");
 
+    struct epoll_event events[64];
+    int timeout_ms = -1;
     while (running_) {
-        struct sockaddr_in client_addr;
-        socklen_t client_len = sizeof(client_addr);
+        int count = epoll_wait(epoll_fd_, events, 64, timeout_ms);
+        if (count < 0 && errno != EINTR) {
+            write_log("WebServer: ERROR - epoll_wait failed: " + std::string(strerror(errno)));
+            break;
+        }
+        for (int i = 0; i < count; ++i) {
+            int fd = events[i].data.fd;
+            if (fd == server_fd_) {
+                accept_clients();
+            } else if (fd == wake_fd_) {
+                uint64_t value;
+                while (read(wake_fd_, &value, sizeof(value)) > 0) {}
+                deliver_responses();
+            } else {
+                handle_client(fd, events[i].events);
+            }
+        }
+        // Sleep until the next idle deadline, or indefinitely with no connections open
+        timeout_ms = close_idle_clients();
+    }
 
-        int client_fd = accept(server_fd_, (struct sockaddr*)&client_addr, &client_len);
-        if (client_fd < 0) {
-            if (errno == EAGAIN || errno == EWOULDBLOCK) {
-                // Non-blocking mode, no client available yet
-                std::this_thread::sleep_for(std::chrono::milliseconds(100));
-                continue;
+    {
+        std::lock_guard<std::mutex> lock(server_mutex_);
+        jobs_.clear();
+    }
+    jobs_ready_.notify_all();
+    for (auto& worker : workers_) {
+        worker.join();
+    }
+    workers_.clear();
+    finished_.clear();
+
+    while (!connections_.empty()) {
+        close_client(connections_.begin()->first);
+    }
+    close(epoll_fd_);
+    epoll_fd_ = -1;
+    close(server_fd_);
+    server_fd_ = -1;
+
+    write_log("WebServer: Accept loop ended");
+}
+
+void WebServer::worker_loop() {
+    while (true) {
+        Job job;
+        {
+            std::unique_lock<std::mutex> lock(server_mutex_);
+            jobs_ready_.wait(lock, [this] { return !running_ || !jobs_.empty(); });
+            if (!running_) {
+                return;
             }
-            if (running_) {
-                continue;
+            job = std::move(jobs_.front());
+            jobs_.pop_front();
+        }
+
+        // Cached files skip the handler (and its per-request logging) and keep their body shared
+        SharedResponse shared;
+        if (asset_handler_ && job.request.compare(0, 4, "GET ") == 0) {
+            size_t path_end = job.request.find(' ', 4);
+            std::string path = job.request.substr(4, path_end == std::string::npos ? std::string::npos : path_end - 4);
+            if (asset_handler_(path, job.request, shared)) {
+                job.request = shared.head + connection_headers(job.keep_alive);
+                job.body = std::move(shared.body);
             }
-            break;
+        }
+        if (!job.body && shared.head.empty()) {
+            job.request = frame_response(process_http_request(job.request), job.keep_alive);
         }
 
-        // Handle client in separate thread
-        std::thread([this, client_fd]() {
-            handle_client(client_fd);
+        {
+            std::lock_guard<std::mutex> lock(server_mutex_);
+            finished_.push_back(std::move(job));
+        }
+        uint64_t one = 1;
+        if (write(wake_fd_, &one, sizeof(one)) < 0) {
+            // Counter is non-zero already, so the server thread will wake anyway
+        }
+    }
+}
+
+void WebServer::accept_clients() {
+    while (true) {
+        int client_fd = accept4(server_fd_, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (client_fd < 0) {
+            if (errno == EINTR) continue;
+            // EAGAIN: accepted everything pending. Anything else (EMFILE...) is retried on the next event.
+            return;
+        }
+        if (connections_.size() >= max_connections) {
             close(client_fd);
-        }).detach();
+            continue;
+        }
+
+        Connection& conn = connections_[client_fd];
+        conn.serial = ++next_serial_;
+        conn.last_active = Clock::now();
+
+        struct epoll_event ev{};
+        ev.events = EPOLLIN | EPOLLRDHUP;
+        ev.data.fd = client_fd;
+        if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, client_fd, &ev) < 0) {
+            connections_.erase(client_fd);
+            close(client_fd);
+        }
+    }
+}
+
+void WebServer::watch_client(int client_fd, uint32_t events) {
+    auto it = connections_.find(client_fd);
+    if (it != connections_.end() && it->second.peer_closed) {
+        events &= ~static_cast<uint32_t>(EPOLLIN | EPOLLRDHUP);  // Level-triggered: would fire forever
     }
+    struct epoll_event ev{};
+    ev.events = events;
+    ev.data.fd = client_fd;
+    epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, client_fd, &ev);
+}
 
-    write_log("WebServer: Accept loop ended");
+void WebServer::close_client(int client_fd) {
+    epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, client_fd, nullptr);
+    close(client_fd);
+    connections_.erase(client_fd);
+}
+
+void WebServer::handle_client(int client_fd, uint32_t events) {
+    auto it = connections_.find(client_fd);
+    if (it == connections_.end()) {
+        return;
+    }
+    Connection& conn = it->second;
+
+    if (events & (EPOLLERR | EPOLLHUP)) {
+        // Nothing can reach the client any more; a worker's answer is dropped by serial
+        close_client(client_fd);
+        return;
+    }
+    if (events & EPOLLOUT) {
+        if (!send_response(client_fd, conn)) {
+            close_client(client_fd);
+        }
+        return;
+    }
+    if (events & (EPOLLIN | EPOLLRDHUP)) {
+        if (!read_client(client_fd, conn)) {
+            close_client(client_fd);
+            return;
+        }
+        if (conn.busy) {
+            // Half-closed while a worker has the request: answer, then close
+            conn.keep_alive = false;
+            watch_client(client_fd, EPOLLRDHUP);
+            return;
+        }
+        dispatch_request(client_fd, conn);
+    }
 }
 
-void WebServer::handle_client(int client_fd) {
-    char buffer[4096] = {0};
-    int bytes_read = recv(client_fd, buffer, sizeof(buffer) - 1, 0);
+bool WebServer::read_client(int client_fd, Connection& conn) {
+    char buffer[16384];
+    while (true) {
+        ssize_t n = recv(client_fd, buffer, sizeof(buffer), 0);
+        if (n > 0) {
+            conn.in.append(buffer, static_cast<size_t>(n));
+            conn.last_active = Clock::now();
+            if (conn.in.size() > max_header_bytes + max_body_bytes) {
+                break;  // dispatch_request rejects it
+            }
+            continue;
+        }
+        if (n == 0) {
+            conn.peer_closed = true;
+            // Close straight away unless there's a request to answer
+            return conn.busy || !conn.out.empty() || conn.in.find("\r\n\r\n") != std::string::npos;
+        }
+        if (errno == EINTR) continue;
+        return errno == EAGAIN || errno == EWOULDBLOCK;
+    }
+    return true;
+}
 
-    if (bytes_read <= 0) {
+void WebServer::dispatch_request(int client_fd, Connection& conn) {
+    if (conn.busy || !conn.out.empty()) {
         return;
     }
 
-    std::string request(buffer, bytes_read);
-    std::string response = process_http_request(request);
+    // Wait for the whole header block, then for Content-Length bytes of body
+    size_t header_end = conn.in.find("\r\n\r\n");
+    if (header_end == std::string::npos) {
+        if (conn.in.size() > max_header_bytes) {
+            conn.out = error_response("431 Request Header Fields Too Large");
+        } else if (conn.peer_closed) {
+            close_client(client_fd);
+            return;
+        } else {
+            watch_client(client_fd, EPOLLIN | EPOLLRDHUP);
+            return;
+        }
+    } else if (header_end > max_header_bytes) {
+        conn.out = error_response("431 Request Header Fields Too Large");
+    } else {
+        std::string lower = to_lower(conn.in.substr(0, header_end)) + "\r\n";
+        size_t content_length = 0;
+        std::string length_value = header_value(lower, "content-length");
+        bool valid = length_value.empty() ||
+                     std::all_of(length_value.begin(), length_value.end(), [](char c) { return std::isdigit(static_cast<unsigned char>(c)); });
+        if (!header_value(lower, "transfer-encoding").empty()) {
+            conn.out = error_response("411 Length Required");
+        } else if (!valid || length_value.length() > 9) {
+            conn.out = error_response(valid ? "413 Payload Too Large" : "400 Bad Request");
+        } else {
+            content_length = length_value.empty() ? 0 : std::stoul(length_value);
+            if (content_length > max_body_bytes) {
+                conn.out = error_response("413 Payload Too Large");
+            } else if (conn.in.size() < header_end + 4 + content_length) {
+                if (conn.peer_closed) {
+                    close_client(client_fd);
+                } else {
+                    watch_client(client_fd, EPOLLIN | EPOLLRDHUP);
+                }
+                return;
+            } else {
+                // HTTP/1.1 keeps the connection unless told otherwise; HTTP/1.0 only when asked
+                std::string connection = header_value(lower, "connection");
+                size_t line_end = lower.find("\r\n");
+                bool http10 = line_end >= 8 && lower.compare(line_end - 8, 8, "http/1.0") == 0;
+                Job job;
+                job.fd = client_fd;
+                job.serial = conn.serial;
+                job.request = conn.in.substr(0, header_end + 4 + content_length);
+                job.keep_alive = !conn.peer_closed &&
+                                 (http10 ? connection == "keep-alive" : connection != "close");
+                conn.in.erase(0, header_end + 4 + content_length);
+                conn.keep_alive = job.keep_alive;
+                conn.busy = true;
+                // Stop reading until the answer is out; pipelined requests wait in conn.in
+                watch_client(client_fd, EPOLLRDHUP);
+                {
+                    std::lock_guard<std::mutex> lock(server_mutex_);
+                    jobs_.push_back(std::move(job));
+                }
+                jobs_ready_.notify_one();
+                return;
+            }
+        }
+    }
+
+    // Refused by the server itself
+    conn.keep_alive = false;
+    conn.in.clear();
+    if (!send_response(client_fd, conn)) {
+        close_client(client_fd);
+    }
+}
+
+void WebServer::deliver_responses() {
+    std::deque<Job> finished;
+    {
+        std::lock_guard<std::mutex> lock(server_mutex_);
+        finished.swap(finished_);
+    }
+    for (Job& job : finished) {
+        auto it = connections_.find(job.fd);
+        if (it == connections_.end() || it->second.serial != job.serial) {
+            continue;  // Connection already gone
+        }
+        Connection& conn = it->second;
+        conn.busy = false;
+        conn.out = std::move(job.request);
+        conn.out_body = std::move(job.body);
+        conn.out_sent = 0;
+        if (!send_response(job.fd, conn)) {
+            close_client(job.fd);
+        }
+    }
+}
+
+bool WebServer::send_response(int client_fd, Connection& conn) {
+    size_t body_size = conn.out_body ? conn.out_body->size() : 0;
+    size_t total = conn.out.size() + body_size;
+    while (conn.out_sent < total) {
+        // Head and shared body in one call, picking up wherever the last partial send stopped
+        struct iovec iov[2];
+        int iov_count = 0;
+        if (conn.out_sent < conn.out.size()) {
+            iov[iov_count++] = {const_cast<char*>(conn.out.data()) + conn.out_sent, conn.out.size() - conn.out_sent};
+            if (body_size > 0) {
+                iov[iov_count++] = {const_cast<char*>(conn.out_body->data()), body_size};
+            }
+        } else {
+            size_t offset = conn.out_sent - conn.out.size();
+            iov[iov_count++] = {const_cast<char*>(conn.out_body->data()) + offset, body_size - offset};
+        }
+        struct msghdr msg{};
+        msg.msg_iov = iov;
+        msg.msg_iovlen = iov_count;
+
+        ssize_t n = sendmsg(client_fd, &msg, MSG_NOSIGNAL);
+        if (n > 0) {
+            conn.out_sent += static_cast<size_t>(n);
+            conn.last_active = Clock::now();
+            continue;
+        }
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            watch_client(client_fd, EPOLLOUT | EPOLLRDHUP);
+            return true;
+        }
+        return false;
+    }
+
+    conn.out.clear();
+    conn.out_body.reset();
+    conn.out_sent = 0;
+    if (!conn.keep_alive) {
+        return false;
+    }
+    // Ready for the next request, which may already be buffered
+    dispatch_request(client_fd, conn);
+    return true;
+}
 
-    send(client_fd, response.c_str(), response.length(), 0);
+int WebServer::close_idle_clients() {
+    if (connections_.empty()) {
+        return -1;
+    }
+    auto now = Clock::now();
+    auto timeout = std::chrono::seconds(idle_timeout_seconds);
+    auto next_deadline = now + timeout;
+    for (auto it = connections_.begin(); it != connections_.end();) {
+        const Connection& conn = it->second;
+        auto deadline = conn.last_active + timeout;
+        if (!conn.busy && deadline <= now) {
+            int fd = it->first;
+            ++it;
+            close_client(fd);
+            continue;
+        }
+        if (!conn.busy) {
+            next_deadline = std::min(next_deadline, deadline);
+        }
+        ++it;
+    }
+    auto wait = std::chrono::duration_cast<std::chrono::milliseconds>(next_deadline - now).count();
+    return static_cast<int>(std::max<long long>(wait, 0) + 1);
 }
 
 std::string WebServer::process_http_request(const std::string& request) {
@@ -157,7 +549,7 @@ std::string WebServer::process_http_request(const std::string& request) {
     if (method == "GET") {
         // Call handler if available
         if (get_handler_) {
-            return get_handler_(path);
+            return get_handler_(path, request);
         }
         return "HTTP/1.1 404 Not Found\r\nContent-Type: text/plain\r\n\r\nNot Found";
     } else if (method == "POST") {
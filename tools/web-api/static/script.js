@@ -3,6 +3,10 @@ let currentUnitId = null;
 let currentUnitData = null;
 let controlPanelRefreshInterval = null;
 let dashboardRefreshInterval = null;
+// Dashboard copy of /api/units, kept current with ?since=<version> deltas
+let unitsVersion = null;
+let unitsData = {};
+let unitCards = {};
 
 function updateLastRefreshTime() {
     const now = new Date();
@@ -138,57 +142,92 @@ function updateUnits() {
         document.getElementById('loginStatusBar').style.display = 'none';
     }
 
-    fetch('/api/units')
+    // After the first load only units that changed since our version come back
+    const url = unitsVersion === null ? '/api/units' : '/api/units?since=' + unitsVersion;
+    fetch(url)
         .then(response => response.json())
         .then(data => {
             console.log('Received data:', data);
-            // Store unit configs globally for API calls
-            window.units_config = data.unit_configs || {};
             const unitsDiv = document.getElementById('units');
-            unitsDiv.innerHTML = '';
-            if (!data.unit_data || Object.keys(data.unit_data).length === 0) {
-                unitsDiv.innerHTML = '<p>No units configured or no data yet. Unit count: ' + (data.unit_count || 0) + '</p>';
-                return;
+            if (data.full) {
+                unitsData = {};
+                unitCards = {};
+                window.units_config = {};
+                unitsDiv.innerHTML = '';
             }
-            for (const [unitId, unitData] of Object.entries(data.unit_data)) {
-                let status = 'Offline';
-                if (unitData.system_status) {
-                    status = String(unitData.system_status);
+            // Store unit configs globally for API calls
+            window.units_config = Object.assign(window.units_config || {}, data.unit_configs || {});
+            for (const unitId of data.removed || []) {
+                delete unitsData[unitId];
+                delete window.units_config[unitId];
+                if (unitCards[unitId]) {
+                    unitCards[unitId].remove();
+                    delete unitCards[unitId];
                 }
-                const statusClass = status === 'Alarm' ? 'status-alarm' : (status === 'Run' ? 'status-ok' : (status === 'Offline' ? 'status-offline' : 'status-unknown'));
-                const sensors = unitData.sensors || {};
-                const setpoint = unitData.setpoint || 0;
-                const returnTemp = sensors.return_temp || 0;
-                const supplyTemp = sensors.supply_temp || 0;
-                const coilTemp = sensors.coil_temp || 0;
-                const isOffline = status === 'Offline';
-                const formatValue = (val) => isOffline ? 'N/A' : (val || 0).toFixed(1);
-                const card = document.createElement('div');
-                card.className = 'unit-card';
-                if (!isOffline) {
-                    card.onclick = () => promptLogin(unitId, unitData);
+            }
+            for (const [unitId, unitData] of Object.entries(data.unit_data || {})) {
+                unitsData[unitId] = unitData;
+                const card = createUnitCard(unitId, unitData);
+                if (unitCards[unitId]) {
+                    unitCards[unitId].replaceWith(card);
                 } else {
-                    card.style.pointerEvents = 'none';
-                    card.style.cursor = 'not-allowed';
+                    // Keep cards in unit ID order
+                    const nextId = Object.keys(unitCards).sort().find(id => id > unitId);
+                    unitsDiv.insertBefore(card, nextId ? unitCards[nextId] : null);
                 }
-                card.innerHTML = `
-                    <div class="unit-id">${unitId}</div>
-                    <div class="status ${statusClass}">${status}</div>
-                    <div class="reading"><span class="reading-label">Setpoint:</span> ${formatValue(setpoint)}&deg;F</div>
-                    <div class="reading"><span class="reading-label">Return Temp:</span> ${formatValue(returnTemp)}&deg;F</div>
-                    <div class="reading"><span class="reading-label">Supply Temp:</span> ${formatValue(supplyTemp)}&deg;F</div>
-                    <div class="reading"><span class="reading-label">Coil Temp:</span> ${formatValue(coilTemp)}&deg;F</div>
-                    <div class="last-update">${isOffline ? 'Waiting for connection...' : 'Last update: ' + new Date(unitData.timestamp * 1000).toLocaleString()}</div>
-                `;
-                unitsDiv.appendChild(card);
+                unitCards[unitId] = card;
+            }
+            unitsVersion = data.version;
+
+            const emptyNote = document.getElementById('unitsEmpty');
+            if (Object.keys(unitsData).length === 0) {
+                if (!emptyNote) {
+                    unitsDiv.innerHTML = '<p id="unitsEmpty">No units configured or no data yet. Unit count: ' + (data.unit_count || 0) + '</p>';
+                }
+            } else if (emptyNote) {
+                emptyNote.remove();
             }
         })
         .catch(error => {
             console.error('Error loading units:', error);
+            unitsVersion = null;  // Start over with a full load next time
             document.getElementById('units').innerHTML = '<p>Error: ' + error + '</p>';
         });
 }
 
+function createUnitCard(unitId, unitData) {
+    let status = 'Offline';
+    if (unitData.system_status) {
+        status = String(unitData.system_status);
+    }
+    const statusClass = status === 'Alarm' ? 'status-alarm' : (status === 'Run' ? 'status-ok' : (status === 'Offline' ? 'status-offline' : 'status-unknown'));
+    const sensors = unitData.sensors || {};
+    const setpoint = unitData.setpoint || 0;
+    const returnTemp = sensors.return_temp || 0;
+    const supplyTemp = sensors.supply_temp || 0;
+    const coilTemp = sensors.coil_temp || 0;
+    const isOffline = status === 'Offline';
+    const formatValue = (val) => isOffline ? 'N/A' : (val || 0).toFixed(1);
+    const card = document.createElement('div');
+    card.className = 'unit-card';
+    if (!isOffline) {
+        card.onclick = () => promptLogin(unitId, unitsData[unitId] || unitData);
+    } else {
+        card.style.pointerEvents = 'none';
+        card.style.cursor = 'not-allowed';
+    }
+    card.innerHTML = `
+        <div class="unit-id">${unitId}</div>
+        <div class="status ${statusClass}">${status}</div>
+        <div class="reading"><span class="reading-label">Setpoint:</span> ${formatValue(setpoint)}&deg;F</div>
+        <div class="reading"><span class="reading-label">Return Temp:</span> ${formatValue(returnTemp)}&deg;F</div>
+        <div class="reading"><span class="reading-label">Supply Temp:</span> ${formatValue(supplyTemp)}&deg;F</div>
+        <div class="reading"><span class="reading-label">Coil Temp:</span> ${formatValue(coilTemp)}&deg;F</div>
+        <div class="last-update">${isOffline ? 'Waiting for connection...' : 'Last change: ' + new Date(unitData.timestamp * 1000).toLocaleString()}</div>
+    `;
+    return card;
+}
+
 function promptLogin(unitId, unitData) {
     currentUnitId = unitId;
     currentUnitData = unitData;
@@ -329,21 +368,12 @@ function showControlPage() {
         if (resetBtn) resetBtn.style.display = hasAlarm ? 'block' : 'none';
         if (defrostBtn) defrostBtn.style.display = canDefrost ? 'block' : 'none';
 
-        // Fetch demo mode status separately
-        fetch('/api/unit/' + currentUnitId + '/demo-mode')
-        .then(r => r.json())
-        .then(d => {
-            console.log('Demo mode status:', d.demo_mode);
-            currentUnitData.demo_mode = d.demo_mode;
-            const demoMode = d.demo_mode ? 'Enabled' : 'Disabled';
-            const demoStyle = d.demo_mode ? 'color: #FF9800;' : '';
-            const demoModeEl = document.getElementById('demoModeStatus');
-            if (demoModeEl) {
-                demoModeEl.innerHTML = '<strong>Demo Mode:</strong> ' + demoMode;
-                demoModeEl.style.cssText = demoStyle;
-            }
-        })
-        .catch(e => console.error('Failed to fetch demo mode:', e));
+        // Demo mode comes back in the same snapshot as the status and config
+        const demoModeEl = document.getElementById('demoModeStatus');
+        if (demoModeEl) {
+            demoModeEl.innerHTML = '<strong>Demo Mode:</strong> ' + demoMode;
+            demoModeEl.style.cssText = demoStyle;
+        }
     })
     .catch(e => {
         console.error('Failed to fetch system info:', e);
@@ -0,0 +1,95 @@
+/*
+ * Refrigeration Server
+ * Copyright (c) 2025 William Bellvance Jr
+ * Licensed under the MIT License.
+ *
+ * /api/units change detection: units re-stamp their status every second, and polls that only
+ * bring a newer timestamp must not publish a new version, ETag or delta entry.
+ */
+
+#include "../bench/fleet_simulator.h"
+#include "tools/web_interface/unit_poller.h"
+#include "tools/web_interface/connection_cache.h"
+#include <curl/curl.h>
+#include <iostream>
+#include <fstream>
+#include <chrono>
+#include <thread>
+
+int main() {
+    curl_global_init(CURL_GLOBAL_ALL);
+    std::ostream out(std::cout.rdbuf());
+    std::ofstream discard("/dev/null");
+    std::cout.rdbuf(discard.rdbuf());   // The poller logs every poll
+
+    int failures = 0;
+    {
+        FleetSimulator fleet(0);
+        std::string problems;
+        std::vector<Unit> units = fleet.start(3, 0, problems);
+        if (units.empty()) {
+            std::cerr << "FAIL simulator: " << problems << "\n";
+            return 1;
+        }
+
+        PollSettings settings;
+        settings.connect_timeout = 1;
+        settings.timeout = 2;
+        settings.interval = 1;
+        settings.fast_interval = 1;
+        ConnectionCache connections;
+        UnitPoller poller(&connections);
+        poller.set_poll_settings(settings);
+        poller.start(units);
+
+        // First answers from every unit, and the snapshots they publish
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+        while (fleet.units_answered() < units.size() && std::chrono::steady_clock::now() < deadline) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+        auto before = poller.get_units_snapshot();
+
+        json first = json::parse(before->delta_body(before->first_version));
+        if (first["unit_data"].size() != units.size()) {
+            std::cerr << "FAIL first delta has " << first["unit_data"].size() << " of " << units.size() << " units\n";
+            failures++;
+        }
+
+        // Several more polls per unit, each with a newer timestamp
+        uint64_t served = fleet.requests_served();
+        std::this_thread::sleep_for(std::chrono::milliseconds(2500));
+        if (fleet.requests_served() < served + 2 * units.size()) {
+            std::cerr << "FAIL units weren't re-polled\n";
+            failures++;
+        }
+
+        auto after = poller.get_units_snapshot();
+        if (after->version != before->version || after->etag != before->etag) {
+            std::cerr << "FAIL version went from " << before->version << " to " << after->version
+                      << " with only the timestamp changing\n";
+            failures++;
+        }
+        json delta = json::parse(after->delta_body(before->version));
+        if (!delta["unit_data"].empty()) {
+            std::cerr << "FAIL delta since " << before->version << " lists " << delta["unit_data"].dump() << "\n";
+            failures++;
+        }
+        for (const Unit& unit : units) {
+            json stored = json::parse(*after->units.at(unit.id).json);
+            if (poller.get_unit_data(unit.id).value("timestamp", 0) <= stored.value("timestamp", 0)) {
+                std::cerr << "FAIL " << unit.id << " unit data didn't get the newer timestamp\n";
+                failures++;
+            }
+        }
+        poller.stop();
+    }
+
+    std::cout.rdbuf(out.rdbuf());
+    curl_global_cleanup();
+    if (failures) {
+        return 1;
+    }
+    std::cout << "PASS unit_poller_test\n";
+    return 0;
+}